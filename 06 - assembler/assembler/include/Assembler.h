@@ -4,17 +4,70 @@
 #include "Parser.h"
 #include "Code.h"
 #include "SymbolTable.h"
+#include "RomWriter.h"
+#include "ObjectFile.h"
+#include "Optimizer.h"
+#include "TraceLog.h"
 #include <iostream>
 #include <string>
-#include <map>
+#include <vector>
+#include <cstdint>
 
 using namespace std;
 
-class Assembler
+/**
+	Symbol policy of the assembler for programs with symbols: labels, variables and the Hack
+	predefined symbols are mapped through a SymbolTable, in two passes over the input.
+*/
+class Symbolic
+{
+	public:
+		typedef SymbolTable Table;									/**< Symbol table of the assembler. */
+		static constexpr bool hasSymbols = true;					/**< Are symbols handled? */
+		static constexpr const char* subtitle
+			= "hack assembler (nand2tetris, chap. 6)";				/**< Subtitle of the assembler. */
+};
+
+/**
+	Symbol policy of the assembler for programs without symbols (A-instructions with decimal
+	constants only, labels are ignored). There is no symbol table, and the first pass and the
+	symbol lookups are compiled away: the input is assembled in a single streaming pass.
+*/
+class SymbolLess
+{
+	public:
+		class Table {};												/**< No symbol table. */
+		static constexpr bool hasSymbols = false;					/**< Are symbols handled? */
+		static constexpr const char* subtitle
+			= "hack assembler symbol-less version (nand2tetris, chap. 6)";	/**< Subtitle of the assembler. */
+};
+
+/**
+	The Hack assembler. The SymbolPolicy (Symbolic or SymbolLess) selects whether symbols are
+	handled; the member functions are explicitly instantiated for both in Assembler.cpp. Use
+	the Assembler and AssemblerL names defined below.
+*/
+template<class SymbolPolicy>
+class BasicAssembler
 {
 
 	public:
 
+		static constexpr const char* version = "0.3";	/**< Version of the assembler. */
+
+		/**
+			An error found while assembling.
+		*/
+		class Diagnostic {
+			public:
+				Diagnostic(int linePos, string message)
+					: linePos(linePos), message(message)
+				{}
+
+				int linePos;			/**< Line number of the command with the error. */
+				string message;			/**< Description of the error. */
+		};
+
      	/**
 			Constructs an Assembler object and binds it to the input and output stream.
 
@@ -30,15 +83,37 @@ class Assembler
 
             @param veryVerbose Flags the assembler to switch 'very verbose' mode on or off.
 		*/
-        Assembler(istream& inputStream, string inputName, ostream& outputStream, string outputName,
-        	      bool verbose = false, bool veryVerbose = false);
+        BasicAssembler(istream& inputStream, string inputName, ostream& outputStream, string outputName,
+        	           bool verbose = false, bool veryVerbose = false);
+
+     	/**
+			Constructs an Assembler object over a buffer with the Hack assembly program (for instance,
+			a mapped file). The machine code is not written anywhere: it is kept in memory and can be
+			retrieved with getRom() after assembling.
+
+            @param source Buffer with the Hack assembly program. Must outlive the assembler.
+
+			@param inputName Name of the input.
+
+            @param outputName Name of the output.
+
+            @param verbose Flags the assembler to switch verbose mode on or off.
+
+            @param veryVerbose Flags the assembler to switch 'very verbose' mode on or off.
+		*/
+        BasicAssembler(string_view source, string inputName, string outputName,
+        	           bool verbose = false, bool veryVerbose = false);
 
 		/**
 			Assembles the input stream into Hack machine code and writes it to the output stream.
 			If the assembler is in verbose or 'very verbose' mode, a call to assemble() will print
 			details of the assembling process to the standard output.
+
+			Errors (such as illegal C-instructions) are reported to the standard error output.
+
+			@return True if the program was assembled without errors. False otherwise.
 		*/
-		void assemble();
+		bool assemble();
 
 		/**
 			First pass of the assembling process. Populates the symbol table with the program's labels only.
@@ -59,13 +134,80 @@ class Assembler
 		void assembleSecondPass();
 
 		/**
-			Outputs to a file the symbol table of the program being assembled. The output file will be named
-			"prog-symbols", being "prog" the name of the output stream.
+			Assembles the input stream into Hack machine code reading it only once. Instructions are
+			encoded into an in-memory buffer as they are parsed; A-instructions referencing symbols not
+			yet known are recorded as fixups and patched when the end of the input stream is reached.
+			The output is the same as the one generated by assemble().
+
+			If the assembler is in verbose mode, a call to assembleSinglePass() will print details of the
+			assembling process to the standard output.
+
+			@return True if the program was assembled without errors. False otherwise.
+		*/
+		bool assembleSinglePass();
+
+		/**
+			Assembles the input using several threads. The input is split on line boundaries into
+			chunks, one per thread. In the first pass every thread counts the instructions and collects
+			the labels of its chunk, and a prefix sum of the counts gives the ROM address of each chunk.
+			In the second pass every thread encodes its chunk into its own range of the ROM. Variables
+			are mapped to RAM at the end, in order of first use, so the output is the same as the one
+			generated by assemble().
+
+			Falls back to assemble() in verbose mode, when the input is too small to be worth splitting
+			and when the input has multi line comments (a chunk boundary could fall inside one).
+
+			@param threadCount Number of threads (0 for one per hardware thread).
+
+			@return True if the program was assembled without errors. False otherwise.
+		*/
+		bool assembleParallel(unsigned int threadCount);
+
+		/**
+			Assembles the input with the optimizer (see Optimizer). The program is decoded into a
+			list of instructions, optimized, and then laid out: labels are resolved once the
+			instructions are in their final places. If the assembler is in verbose mode, the
+			optimizations applied are printed.
+
+			The symbol-less assembler does not optimize (its jumps target plain ROM addresses, which
+			removing instructions would break) and falls back to assemble().
+
+			@param passes Optimizer passes to run (a combination of Optimizer::Pass values).
+
+			@return True if the program was assembled without errors. False otherwise.
+		*/
+		bool assembleOptimized(unsigned int passes = Optimizer::PEEPHOLE);
+
+		/**
+			Assembles the input into a relocatable object (see ObjectFile), to be linked with other
+			separately assembled modules. The labels of the input are exported; the symbols it uses
+			but does not define are left to the linker, which resolves them to labels of other
+			modules or allocates them as variables. The object is written to the output stream, and
+			@ref rom holds its words.
+
+			Only the peephole pass of the optimizer is run, if requested: the code and labels that
+			look unused in a module may be used by the others. The symbol-less assembler makes
+			objects without relocations.
+
+			@param passes Optimizer passes to run (a combination of Optimizer::Pass values).
+
+			@return True if the program was assembled without errors. False otherwise.
+		*/
+		bool assembleObject(unsigned int passes = 0);
+
+		/**
+			Prepares the assembler for another input, as if it had just been constructed over it.
+			The predefined symbols and the memory of the tables and buffers are kept, so assembling
+			many small inputs with one assembler avoids most of the set up. The modes and streams
+			set are kept too.
 
-			@return True if the symbol table was succesfully outputed to a file. False if an error occurred
-			while opening the output file.
+			@param source Buffer with the Hack assembly program (see Parser(string_view)).
+
+			@param inputName Name of the input, used in verbose details and error messages.
+
+			@param outputName Name of the output, used in verbose details and symbol tables.
 		*/
-		void outputSymbolTable(ostream& symOutputStream);
+		void reset(string_view source, string inputName, string outputName);
 
 		/**
 			Sets the verbose mode on or off.
@@ -97,8 +239,143 @@ class Assembler
 		*/
 		bool isVeryVerbose();
 
+		/**
+			Sets the format in which the machine code is written to the output stream. The
+			default format is RomFormat::HACK.
+
+			@note The output stream must be opened in binary mode for the binary formats.
+
+			@param romFormat Format of the machine code.
+		*/
+		void setRomFormat(RomFormat romFormat);
+
+		/**
+			Returns the format in which the machine code is written to the output stream.
+
+			@return RomFormat constant of the output format.
+		*/
+		RomFormat getRomFormat();
+
+		/**
+			Returns the machine code of the assembled program.
+
+			@return A reference to the words of the program, in ROM order.
+		*/
+		const vector<uint16_t>& getRom();
+
+		/**
+			Sets the stream to which verbose and 'very verbose' details are printed. The default
+			is the standard output.
+
+			@param logStream Stream for the assembling details.
+		*/
+		void setLogStream(ostream& logStream);
+
+		/**
+			Sets the stream to which the records of the commands are printed in verbose mode, and
+			their format. By default (null stream) they are printed to the log stream, in columns.
+
+			@param traceStream Stream for the records of the commands, or nullptr for the log stream.
+
+			@param traceFormat Format of the records.
+		*/
+		void setTraceStream(ostream* traceStream, TraceFormat traceFormat = TraceFormat::COLUMNS);
+
+		/**
+			Sets the stream to which errors are reported. The default is the standard error output.
+			Errors are collected (see getDiagnostics()) whether or not they are printed.
+
+			@param errorStream Stream for the error messages, or nullptr to not print them.
+		*/
+		void setErrorStream(ostream* errorStream);
+
+		/**
+			Returns the errors found while assembling, in the order they were found.
+
+			@return A reference to the diagnostics.
+		*/
+		const vector<Diagnostic>& getDiagnostics();
+
+		/**
+			Sets the recording of the source line of every instruction on or off. It is off by
+			default.
+
+			@param sourceLines True to record the source lines, False otherwise.
+		*/
+		void setSourceLines(bool sourceLines);
+
+		/**
+			Returns the source line of every instruction of the assembled program, if recorded
+			(see setSourceLines()).
+
+			@return A reference to the line numbers, in ROM order (empty if not recorded).
+		*/
+		const vector<int>& getSourceLines();
+
+		/**
+			Returns what the optimizer did in assembleOptimized().
+
+			@return A reference to the report, one entry per optimization (empty if the program
+			was not optimized).
+		*/
+		const vector<Optimizer::Pattern>& getOptimizationReport();
+
+		/**
+			Returns the object made by assembleObject().
+
+			@return A reference to the object (empty if no object was made).
+		*/
+		const ObjectFile& getObject();
+
+		/**
+			Returns the symbol table of the program, with the predefined symbols, labels and variables
+			(an empty object for the symbol-less assembler).
+
+			@return A reference to the symbol table.
+		*/
+		const typename SymbolPolicy::Table& getSymbolTable();
+
+		/**
+			Returns the number of predefined symbols, which are the first entries of the symbol table.
+
+			@return The number of predefined symbols.
+		*/
+		size_t getPredefinedCount();
+
 	private:
 
+		/**
+			An A-instruction whose symbol was not known when it was encoded.
+		*/
+		class Fixup {
+			public:
+				Fixup(size_t index, string_view symbol)
+					: index(index), symbol(symbol)
+				{}
+
+				size_t index;			/**< Index of the instruction in @ref rom. */
+				string_view symbol;		/**< Symbol referenced by the instruction (a view of the parser's buffer). */
+		};
+
+		/**
+			A chunk of the input assembled by one thread of assembleParallel().
+		*/
+		class Chunk {
+			public:
+				Chunk(string_view source)
+					: source(source), romOffset(0), instructionCount(0), linePos(1), lineCount(0)
+				{}
+
+				string_view source;							/**< Lines of the chunk. */
+				size_t romOffset;							/**< ROM address of the first instruction. */
+				size_t instructionCount;					/**< Number of instructions. */
+				int linePos;								/**< Line number of the first line. */
+				int lineCount;								/**< Number of line breaks. */
+				vector<pair<string_view, size_t>> labels;	/**< Labels and their chunk relative addresses. */
+				vector<Fixup> fixups;						/**< A-instructions referencing unknown symbols. */
+				vector<pair<int, string_view>> errors;		/**< Chunk relative lines and commands with errors. */
+		};
+
 		/**
 			Populates the @ref symbolTable without generating code. The first pass will only compute the
 			program's labels. The program's variable are handled in the second pass.
@@ -106,22 +383,133 @@ class Assembler
 		void firstPass();
 
 		/**
-			Generates the Hack machine code to the @ref outputStream using the symbol table to map labels
+			Generates the Hack machine code to @ref rom using the symbol table to map labels
 			to ROM addresses. Variables are added to the @ref symbolTable during the second pass, mapping
 			variables to RAM addresses.
 		*/
 		void secondPass();
 
 		/**
-			Assembles an A-instruction (A_COMMAND), writing to the output stream its machine code.
+			Encodes the whole program into @ref rom in a single pass over the input. Labels are added
+			to the @ref symbolTable as they are defined and unresolved symbols are added to @ref fixups.
+		*/
+		void singlePass();
+
+		/**
+			Patches every entry of @ref fixups with the address of its symbol. Symbols that were not
+			defined as labels are mapped to RAM addresses (variables) in order of first use.
+		*/
+		void resolveFixups();
+
+		/**
+			Splits the input on line boundaries into chunks of about the same size.
+
+			@param chunkCount Maximum number of chunks.
+
+			@return The chunks, in input order.
+		*/
+		vector<Chunk> splitChunks(size_t chunkCount);
+
+		/**
+			First pass over a chunk: counts its instructions, lines and collects its labels.
+			Does not change the assembler, so it can run concurrently for different chunks.
+		*/
+		void firstPassChunk(Chunk& chunk) const;
+
+		/**
+			Second pass over a chunk: encodes its instructions into its range of @ref rom. Symbols
+			not in the @ref symbolTable (variables) become fixups of the chunk. Only reads the
+			symbol table, so it can run concurrently for different chunks.
+		*/
+		void secondPassChunk(Chunk& chunk);
+
+		/**
+			Decodes the whole input into a list of instructions, for the optimizer. Constants and
+			predefined symbols are converted; labels and variables are kept as symbols.
+
+			@return The instructions and labels of the program, in input order.
+		*/
+		vector<Instruction> decode();
+
+		/**
+			Lays out a decoded program into @ref rom: maps the labels to the addresses of the
+			instructions that follow them, then encodes the instructions, mapping variables to
+			RAM addresses in order of first use.
+
+			@param program The instructions and labels of the program.
+		*/
+		void layout(const vector<Instruction>& program);
+
+		/**
+			Lays out a decoded program into @ref object (and @ref rom): like layout(), but the labels
+			are relative to the start of the module and the symbols that are not labels are left
+			unresolved.
+
+			@param program The instructions and labels of the program.
+		*/
+		void layoutObject(const vector<Instruction>& program);
+
+		/**
+			Prints that the peephole passes were skipped (see Optimizer::isPeepholeSkipped()).
+		*/
+		void printPeepholeSkipped();
+
+		/**
+			Prints the optimizations applied by assembleOptimized().
+
+			@param wordsBefore Size of the program before optimizing.
+		*/
+		void printOptimizationReport(size_t wordsBefore);
+
+		/**
+			Assembles an A-instruction (A_COMMAND), appending its machine code to @ref rom.
 		*/
 		void assembleACommand();
 
 		/**
-			Assembles a C-instruction (C_COMMAND), writing to the output stream its machine code.
+			Assembles a C-instruction (C_COMMAND), appending its machine code to @ref rom.
 		*/
 		void assembleCCommand();
 
+		/**
+			Encodes the current C-instruction (C_COMMAND). Illegal C-instructions are reported to the
+			standard error output and counted in @ref errorCount.
+
+			@return An unsigned integer with the machine code of the C-instruction (zero if illegal).
+		*/
+		unsigned int encodeCCommand();
+
+		/**
+			Converts the decimal constant of an A-instruction. Constants that are not decimal
+			numbers from 0 to 32767 are reported to the standard error output and counted in
+			@ref errorCount.
+
+			@param digits String with the decimal constant.
+
+			@return An integer with the value of the constant (zero if invalid).
+		*/
+		int toConstant(string_view digits);
+
+		/**
+			Converts a decimal constant without reporting errors.
+
+			@param digits String with the decimal constant.
+
+			@return An integer with the value of the constant, or -1 if it is not a decimal number
+			from 0 to 32767.
+		*/
+		static int parseConstant(string_view digits);
+
+		/**
+			Reports an invalid A- or C-instruction to the @ref errorStream, adds it to @ref diagnostics
+			and counts it in @ref errorCount.
+
+			@param linePos Line number of the command.
+
+			@param command The command with the error.
+		*/
+		void reportError(int linePos, string_view command);
+
 		/**
 			Prints a header (with command details) and assembling information to the standard output.
 		*/
@@ -135,35 +523,67 @@ class Assembler
 		/**
 			Prints details of the current command being assembled. If 'very verbose'
 			mode is on, this method will print extra details related to C-instructions.
+			The record is formatted by hand into @ref traceRecord and written at once, as this
+			runs for every command.
 		*/
 		void printCmdDetails();
 
 		/**
-			Populates @ref predefinedMap with Hack predefined symbols.
+			Adds the Hack predefined symbols to the @ref symbolTable.
 		*/
 		void mapPredefinedSymbols();
 
-		istream& inputStream;			/**< Input stream with the Hack assembly program. */
+		ostream* outputStream;			/**< Output stream which the assembler writes the Hack machine code (may be null). */
 
-		ostream& outputStream;			/**< Output stream which the assembler writes the Hack machine code. */
+		ostream* logStream;				/**< Stream for verbose details (standard output by default). */
+
+		ostream* errorStream;			/**< Stream for error messages (standard error output by default). */
+
+		ostream* traceStream;			/**< Stream for the records of the commands (null: @ref logStream). */
 
 		string inputName;				/**< Name of the input stream. */
 
 		string outputName; 				/**< Name of the output stream. */
 
-		string bin;						/**< Binary string of the last assembled instruction. */
+		vector<uint16_t> rom;			/**< Machine code of the program, written to @ref outputStream at the end. */
+
+		vector<Fixup> fixups;			/**< Unresolved A-instructions of the single pass. */
+
+		vector<Diagnostic> diagnostics;	/**< Errors found while assembling. */
+
+		vector<Optimizer::Pattern> optimizationReport; /**< What the optimizer did. */
+
+		ObjectFile object;				/**< Relocatable object made by assembleObject(). */
+
+		vector<int> sourceLines;		/**< Source line of every word of @ref rom (if @ref recordLines). */
 
 		Parser parser; 					/**< To read/parse the input file. */
 
 		Code code; 						/**< To translate the input from the parser. */
 
-		SymbolTable symbolTable; 		/**< To handle labels and variables. */
+		typename SymbolPolicy::Table symbolTable; /**< To handle labels and variables. */
 
 		bool verbose; 					/**< Flag for the verbose mode. */
 
 		bool veryVerbose; 				/**< Flag for the 'very verbose' mode. */
 
-		map<string, int> predefinedMap; /**< Set with the predefined symbols of the Hack language. */
+		RomFormat romFormat;			/**< Format of the machine code written to @ref outputStream. */
+
+		TraceFormat traceFormat;		/**< Format of the records of the commands. */
+
+		string traceRecord;				/**< Record of the current command, reused by printCmdDetails(). */
+
+		bool recordLines;				/**< Flag for the recording of @ref sourceLines. */
+
+		int errorCount;					/**< Number of errors found while assembling. */
+
+		size_t predefinedCount;			/**< Number of predefined symbols (the first entries of @ref symbolTable). */
+
+		SymbolTable::Mark predefinedMark;	/**< State of @ref symbolTable with only the predefined symbols. */
+
+		int variableAddress;			/**< RAM address of the next variable. */
+
+		int cmdCount;					/**< Number of commands printed in verbose mode. */
 
 		const string assemblerTitle; 	/**< Assembler title. */
 
@@ -173,4 +593,8 @@ class Assembler
 
 };
 
+typedef BasicAssembler<Symbolic> Assembler;		/**< Assembler of programs with symbols. */
+
+typedef BasicAssembler<SymbolLess> AssemblerL;	/**< Assembler of programs without symbols. */
+
 #endif // ASSEMBLER_INCLUDED_H
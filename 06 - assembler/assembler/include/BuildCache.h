@@ -0,0 +1,168 @@
+#ifndef BUILD_CACHE_INCLUDED_H
+#define BUILD_CACHE_INCLUDED_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+	On-disk cache of assembled outputs, addressed by content: the key of an entry is a hash
+	(XXH64) of the source and of everything else the outputs depend on (assembler version,
+	options), never a file name or timestamp. An entry holds the output files of one assembly,
+	stored as "key.0", "key.1"... in the cache directory.
+
+	Files are copied in and out of the cache as reflinks (shared extents) where the file system
+	supports them, and as plain copies otherwise. They enter the cache through a temporary file
+	and a rename, so several processes may share a cache. When the cache outgrows its size
+	bound, the least recently used files are evicted (a hit refreshes the modification time of
+	its files, which only orders the eviction).
+
+	Hits, misses, stores and evictions are counted, and added to the "stats" file of the cache
+	by saveStats().
+*/
+class BuildCache
+{
+
+	public:
+
+		/**
+			Counters of the cache.
+		*/
+		class Stats {
+			public:
+				uint64_t hits = 0;			/**< Assemblies whose outputs were found. */
+				uint64_t misses = 0;		/**< Assemblies whose outputs were not found. */
+				uint64_t stores = 0;		/**< Entries added. */
+				uint64_t evictions = 0;		/**< Files evicted. */
+		};
+
+		/**
+			Constructs a BuildCache object.
+
+			@param dirName Directory of the cache (created by open() if needed).
+
+			@param maxSize Size bound of the cache, in bytes.
+		*/
+		BuildCache(string dirName, uint64_t maxSize);
+
+		/**
+			Creates the directory of the cache if it does not exist.
+
+			@return True if the cache can be used. False otherwise.
+		*/
+		bool open();
+
+		/**
+			Computes the key of an assembly.
+
+			@param source Source being assembled.
+
+			@param context Everything else the outputs depend on (assembler version, options...).
+
+			@return The key, 16 hexadecimal digits.
+		*/
+		static string makeKey(string_view source, string context);
+
+		/**
+			Copies the outputs of an entry to their destinations. Counts a hit if all of them are
+			in the cache, and a miss otherwise.
+
+			@param key Key of the entry.
+
+			@param outputNames Names of the output files, in the order they were stored.
+
+			@return True on a hit. False otherwise.
+		*/
+		bool fetch(string key, const vector<string>& outputNames);
+
+		/**
+			Adds an entry with copies of the given output files.
+
+			@param key Key of the entry.
+
+			@param outputNames Names of the output files.
+		*/
+		void store(string key, const vector<string>& outputNames);
+
+		/**
+			Evicts the least recently used files until the cache is under its size bound (and
+			under 90% of it, so that the next stores do not evict again).
+		*/
+		void evict();
+
+		/**
+			Adds the counters of this object to the "stats" file of the cache (locked while it is
+			updated, as other processes may be doing the same).
+
+			@return True if the file was updated. False otherwise.
+		*/
+		bool saveStats();
+
+		/**
+			Reads the "stats" file of the cache.
+
+			@return The counters saved so far.
+		*/
+		Stats loadStats();
+
+		/**
+			Sums the sizes of the files of the cache.
+
+			@param fileCount Receives the number of files.
+
+			@return The size of the cache, in bytes.
+		*/
+		uint64_t size(size_t& fileCount);
+
+	private:
+
+		/**
+			A file of the cache, for eviction.
+		*/
+		class File {
+			public:
+				string name;			/**< Path of the file. */
+				uint64_t size;			/**< Size in bytes. */
+				int64_t lastUse;		/**< Modification time, in nanoseconds. */
+		};
+
+		/**
+			Lists the entry files of the cache (the stats and temporary files are left out).
+		*/
+		vector<File> listFiles();
+
+		/**
+			Returns the path of an output file of an entry.
+		*/
+		string entryPath(string key, size_t index);
+
+		/**
+			Copies a file as a reflink, or as a plain copy if the file system cannot share extents.
+
+			@param from Name of the source file.
+
+			@param to Name of the destination file (created or truncated).
+
+			@return True if the file was copied. False otherwise.
+		*/
+		static bool cloneFile(string from, string to);
+
+		string dirName;					/**< Directory of the cache. */
+
+		uint64_t maxSize;				/**< Size bound of the cache, in bytes. */
+
+		atomic<uint64_t> hits;			/**< Hits since the last saveStats(). */
+
+		atomic<uint64_t> misses;		/**< Misses since the last saveStats(). */
+
+		atomic<uint64_t> stores;		/**< Stores since the last saveStats(). */
+
+		atomic<uint64_t> evictions;		/**< Evictions since the last saveStats(). */
+
+};
+
+#endif // BUILD_CACHE_INCLUDED_H
@@ -1,7 +1,9 @@
 #ifndef CODE_INCLUDED_H
 #define CODE_INCLUDED_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 using namespace std;
 
@@ -11,31 +13,33 @@ class Code
 	public:
 
 		/**
-			Returns the binary code of the dest mnemonic.
+			Returns the binary code of a whole C-instruction (<I>dest=comp;jump</I>, where dest or jump
+			might be omitted). The command is looked up as a whole in a table generated at compile time,
+			so encoding takes a single lookup regardless of the mnemonics used.
 
-			@param mnemonic String with mnemonic.
+			The letters of the dest mnemonic may appear in any order (<I>MD</I> and <I>DM</I> are the
+			same) and the commutative comp mnemonics accept both operand orders (<I>D+A</I> and
+			<I>A+D</I>).
 
-			@return An unsigned integer with the dest mnemonic binary code.
-		*/
-		unsigned int dest(string mnemonic);
-
-		/**
-			Returns the binary code of the comp mnemonic.
-
-			@param mnemonic String with mnemonic.
+			@param command String with the C-instruction, without whitespace or comments.
 
-			@return An unsigned integer with the comp mnemonic binary code.
+			@return An integer with the binary code of the C-instruction, or -1 if the command is not
+			a valid C-instruction.
 		*/
-		unsigned int comp(string mnemonic);
+		int cCommand(string_view command) const;
 
 		/**
-			Returns the binary code of the jump mnemonic.
+			Returns the mnemonic of a C-instruction, the inverse of cCommand(). Every 16 bit word
+			is looked up in a 64K-entry table generated at compile time from the same dest, comp and
+			jump tables; the mnemonic is the canonical one (<I>MD</I>, <I>D+A</I>...).
 
-			@param mnemonic String with mnemonic.
+			@param word Machine code of the instruction.
 
-			@return An unsigned integer with the jump mnemonic binary code.
+			@return The C-instruction (<I>dest=comp;jump</I>, with dest or jump omitted when zero),
+			or nullptr if the word is not a C-instruction the assembler can produce (an A-instruction,
+			an undefined comp or unset bits 13 and 14).
 		*/
-		unsigned int jump(string mnemonic);
+		const char* cMnemonic(uint16_t word) const;
 
 };
 
@@ -0,0 +1,72 @@
+#ifndef CPU_INCLUDED_H
+#define CPU_INCLUDED_H
+
+#include <cstdint>
+
+using namespace std;
+
+/**
+	The fields of the Hack instructions and the rules of the CPU of CPU.hdl that the tools
+	running programs share (the Emulator, its Jit and the Translator), so that they agree on
+	the results and on the end of a program.
+*/
+namespace Cpu
+{
+
+	const uint16_t addressMask = 0x7fff;	/**< Bits of A addressing the memory and the ROM. */
+
+	const uint16_t cInstruction = 0x8000;	/**< Set in C-instructions. */
+
+	const uint16_t compReadsM = 0x1000;		/**< The "a" bit: the y input of the ALU is M, not A. */
+
+	const uint16_t compZeroY = 0x0200;		/**< The "zy" bit of the ALU control bits. */
+
+	const uint16_t destA = 0x0020;			/**< Destination bits. */
+	const uint16_t destD = 0x0010;
+	const uint16_t destM = 0x0008;
+
+	const uint16_t jumpLess = 0x0004;		/**< Jump bits. */
+	const uint16_t jumpEqual = 0x0002;
+	const uint16_t jumpGreater = 0x0001;
+	const uint16_t jumpAlways = jumpLess | jumpEqual | jumpGreater;
+
+	/**
+		The ALU of the Hack computer, bit by bit as the chip does.
+
+		@param x The x input (D).
+
+		@param y The y input (A or M).
+
+		@param control The control bits: zx nx zy ny f no, from the most significant.
+
+		@return The output of the ALU.
+	*/
+	uint16_t alu(uint16_t x, uint16_t y, unsigned int control);
+
+	/**
+		Is the word a C-instruction that jumps unconditionally, writing nothing (0;JMP)?
+	*/
+	bool isJumpOnly(uint16_t word);
+
+	/**
+		Is the A-instruction at an address, with the word that follows it, the end of a program
+		("(END) \@END 0;JMP")? A program halts when it runs the A-instruction, or jumps to the
+		C-instruction with A holding the address of the A-instruction.
+
+		@param word The A-instruction.
+
+		@param address Address of the A-instruction.
+
+		@param next The word that follows it.
+	*/
+	bool isEnd(uint16_t word, uint16_t address, uint16_t next);
+
+	/**
+		The source of alu(), isJumpOnly() and isEnd(), for the programs written by the
+		Translator: the same definitions, in namespace Cpu.
+	*/
+	extern const char* const source;
+
+};
+
+#endif // CPU_INCLUDED_H
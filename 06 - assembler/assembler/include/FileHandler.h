@@ -2,6 +2,7 @@
 #define FILE_HANDLER_INCLUDED_H
 
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -40,6 +41,26 @@ namespace FileHandler
 	*/
 	 bool isFile(string fileName);
 
+	/**
+		Is the file name pointing to a directory?
+
+		@param String with the name of the directory to be checked.
+
+		@return True if it's a directory. False otherwise.
+	*/
+	 bool isDirectory(string fileName);
+
+	/**
+		Lists the regular files in a directory with the supplied extension.
+
+		@param dirName String with the name of the directory.
+
+		@param extension String with the extension of the files to be listed.
+
+		@return Vector with the paths of the files (directory name included), sorted by name.
+	*/
+	 vector<string> listFiles(string dirName, string extension);
+
 };
 
 #endif // FILE_HANDLER_INCLUDED_H
@@ -0,0 +1,26 @@
+#ifndef HASH_INCLUDED_H
+#define HASH_INCLUDED_H
+
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+namespace Hash
+{
+
+	/**
+		Computes the XXH64 hash of a buffer (xxHash, 64 bit version). The result is the same
+		as the reference implementation's, on any platform.
+
+		@param data Buffer to be hashed.
+
+		@param seed Seed of the hash (hashes of the same data with different seeds are unrelated).
+
+		@return The 64 bit hash.
+	*/
+	uint64_t xxh64(string_view data, uint64_t seed = 0);
+
+};
+
+#endif // HASH_INCLUDED_H
@@ -0,0 +1,143 @@
+#ifndef HASS_INCLUDED_H
+#define HASS_INCLUDED_H
+
+#include "ObjectFile.h"
+#include "TraceLog.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+template<class SymbolPolicy> class BasicAssembler;
+class Symbolic;
+
+/**
+	In-process interface of the assembler. assemble() turns Hack assembly source held in
+	memory into machine code, without files or global state, so it can be called from several
+	threads at once.
+*/
+namespace Hass
+{
+
+	class Context;
+
+	/**
+		Version of the assembler.
+	*/
+	extern const char* const version;
+
+	/**
+		Options of an assembly.
+	*/
+	class Options
+	{
+		public:
+			string inputName = "input";		/**< Name of the input, used in verbose details. */
+			string outputName = "output";	/**< Name of the output, used in verbose details and symbol tables. */
+			bool singlePass = false;		/**< Reads the input only once (see Assembler::assembleSinglePass()). */
+			unsigned int threads = 1;		/**< Threads for large inputs (0: one per core, see Assembler::assembleParallel()). */
+			bool sourceLines = false;		/**< Records the source line of every instruction in Result::sourceLines. */
+			bool optimize = false;			/**< Runs the peephole optimizer (see Assembler::assembleOptimized()). */
+			bool removeUnreachable = false;	/**< Removes unreachable code and dead labels (see Optimizer::removeUnreachableCode()). */
+			bool object = false;			/**< Makes a relocatable object (see Assembler::assembleObject()); removeUnreachable is ignored. */
+			bool verbose = false;			/**< Prints the details of the assembling process to @ref logStream. */
+			bool veryVerbose = false;		/**< Also prints the details of the C-instructions. */
+			ostream* logStream = nullptr;	/**< Stream for the verbose details (verbose modes are ignored if null). */
+			TraceFormat traceFormat = TraceFormat::COLUMNS; /**< Format of the verbose details (JSONL: only the records of the commands). */
+			Context* context = nullptr;		/**< Warm assembler to reuse (null: a new one for this assembly). */
+	};
+
+	/**
+		An error found while assembling.
+	*/
+	class Diagnostic
+	{
+		public:
+			int line;						/**< Line number of the command with the error. */
+			string message;					/**< Description of the error. */
+	};
+
+	/**
+		A resolved symbol.
+	*/
+	class Symbol
+	{
+		public:
+			string name;					/**< Name of the symbol. */
+			int address;					/**< ROM address (labels) or RAM address (variables, predefined symbols). */
+			bool predefined;				/**< Is it one of the Hack predefined symbols? */
+	};
+
+	/**
+		An optimization applied to the program.
+	*/
+	class Optimization
+	{
+		public:
+			string name;					/**< Name of the optimization. */
+			int count;						/**< Times it was applied. */
+			int wordsSaved;					/**< Instructions it removed. */
+	};
+
+	/**
+		Outcome of an assembly.
+	*/
+	class Result
+	{
+		public:
+			bool ok = false;				/**< True if the program was assembled without errors. */
+			vector<uint16_t> rom;			/**< Machine code, in ROM order. Illegal instructions are encoded as zero. */
+			vector<Symbol> symbols;			/**< Predefined symbols, then the program's labels and variables, each sorted by name. */
+			vector<Diagnostic> diagnostics;	/**< Errors, in the order they were found. */
+			vector<int> sourceLines;		/**< Source line of every word of @ref rom (empty unless Options::sourceLines). */
+			vector<Optimization> optimizations; /**< Optimizations applied (empty unless Options::optimize or Options::removeUnreachable). */
+			ObjectFile object;				/**< Relocatable object (empty unless Options::object). */
+	};
+
+	/**
+		A warm assembler, reused by the assemblies that name it in their Options: the predefined
+		symbols and the memory of the tables and buffers survive from one assembly to the next,
+		which pays off when assembling many small programs. A context must not be used by two
+		assemblies at once.
+	*/
+	class Context
+	{
+		public:
+			Context();
+			~Context();
+
+		private:
+			unique_ptr<BasicAssembler<Symbolic>> assembler;	/**< The assembler, made by the first assembly. */
+
+			friend Result assemble(string_view source, const Options& options);
+	};
+
+	/**
+		Assembles a Hack assembly program.
+
+		@param source Hack assembly program.
+
+		@param options Options of the assembly.
+
+		@return The machine code, symbols and diagnostics of the program.
+	*/
+	Result assemble(string_view source, const Options& options = Options());
+
+	/**
+		Writes the symbol table of an assembled program in the format of "hass -t".
+
+		@param symOutputStream Output stream.
+
+		@param result Assembled program.
+
+		@param outputName Name of the program, printed in the header of its symbols.
+	*/
+	void outputSymbolTable(ostream& symOutputStream, const Result& result, string outputName);
+
+};
+
+#endif // HASS_INCLUDED_H
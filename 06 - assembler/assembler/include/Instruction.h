@@ -0,0 +1,132 @@
+#ifndef INSTRUCTION_INCLUDED_H
+#define INSTRUCTION_INCLUDED_H
+
+#include "Parser.h"
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+/**
+	A decoded command of a Hack program, the unit the optimization passes work on. C-instructions
+	are kept encoded; A-instructions keep their symbol until the program is laid out, since
+	removing instructions moves the labels.
+*/
+class Instruction
+{
+
+	public:
+
+		/**
+			Bits of the dest field of a C-instruction.
+		*/
+		enum Dest : uint16_t {
+			DEST_M = 0b001,
+			DEST_D = 0b010,
+			DEST_A = 0b100
+		};
+
+		/**
+			Constructs an A-instruction with a constant or a symbol.
+
+			@param value Constant (ignored if symbol is not empty).
+
+			@param symbol Symbol of the instruction, or empty for a constant.
+
+			@param linePos Source line of the instruction.
+		*/
+		static Instruction aCommand(uint16_t value, string_view symbol, int linePos);
+
+		/**
+			Constructs a C-instruction.
+
+			@param word Machine code of the instruction.
+
+			@param linePos Source line of the instruction.
+		*/
+		static Instruction cCommand(uint16_t word, int linePos);
+
+		/**
+			Constructs a label (L_COMMAND).
+
+			@param symbol Name of the label.
+
+			@param linePos Source line of the label.
+		*/
+		static Instruction label(string_view symbol, int linePos);
+
+		/**
+			Returns the comp field of a C-instruction, with the a bit (7 bits).
+		*/
+		uint16_t comp() const;
+
+		/**
+			Returns the dest field of a C-instruction (a combination of Dest bits).
+		*/
+		uint16_t dest() const;
+
+		/**
+			Does the C-instruction jump (conditionally or not)?
+		*/
+		bool jumps() const;
+
+		/**
+			Does the C-instruction always jump (0;JMP, or a condition that holds for its constant
+			comp, like 0;JEQ)?
+		*/
+		bool jumpsAlways() const;
+
+		/**
+			Does the instruction use the value of the A register (as operand, memory address or
+			jump target)?
+		*/
+		bool readsA() const;
+
+		/**
+			Does the instruction use the value of the A register other than as jump target (as
+			operand or memory address)?
+		*/
+		bool readsAOperand() const;
+
+		/**
+			Does the instruction use the value of the D register?
+		*/
+		bool readsD() const;
+
+		/**
+			Does the instruction read the memory (M)?
+		*/
+		bool readsM() const;
+
+		/**
+			Does the instruction write the A register?
+		*/
+		bool writesA() const;
+
+		/**
+			Does the instruction write the D register?
+		*/
+		bool writesD() const;
+
+		/**
+			Does the instruction write the memory (M)?
+		*/
+		bool writesM() const;
+
+		/**
+			Replaces the comp and dest fields of a C-instruction (the jump field is kept).
+
+			@param comp New comp field, with the a bit.
+
+			@param dest New dest field.
+		*/
+		void setCompDest(uint16_t comp, uint16_t dest);
+
+		HasmCommandType type;		/**< Type of the command. */
+		uint16_t word;				/**< Machine code (C-instructions) or constant (A-instructions). */
+		string_view symbol;			/**< Symbol of an A-instruction (empty for constants) or name of a label. */
+		int linePos;				/**< Source line of the command. */
+
+};
+
+#endif // INSTRUCTION_INCLUDED_H
@@ -0,0 +1,90 @@
+#ifndef MAPPED_FILE_INCLUDED_H
+#define MAPPED_FILE_INCLUDED_H
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+/**
+	A file mapped into memory (POSIX mmap). A file is either mapped read-only, to be read
+	as a contiguous buffer, or created with a given size and mapped read-write, to be
+	written in place. The mapping is released when the object is destroyed.
+*/
+class MappedFile
+{
+
+	public:
+
+		/**
+			Constructs a MappedFile object with no file mapped.
+		*/
+		MappedFile();
+
+		/**
+			Unmaps and closes the file.
+		*/
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+			Maps a whole existing file for reading.
+
+			@param fileName Name of the file.
+
+			@return True if the file was mapped. False if it could not be opened or mapped.
+		*/
+		bool openRead(const string& fileName);
+
+		/**
+			Creates (or truncates) a file, preallocates it with the given size and maps it for
+			writing.
+
+			@param fileName Name of the file.
+
+			@param size Size of the file in bytes.
+
+			@return True if the file was created and mapped. False otherwise.
+		*/
+		bool create(const string& fileName, size_t size);
+
+		/**
+			Unmaps and closes the file. Called by the destructor.
+		*/
+		void close();
+
+		/**
+			Returns the mapped memory.
+
+			@return A pointer to the first byte of the file (nullptr for an empty file).
+		*/
+		char* data();
+
+		/**
+			Returns the size of the mapped file.
+
+			@return The size of the file in bytes.
+		*/
+		size_t size() const;
+
+		/**
+			Returns the contents of the mapped file.
+
+			@return A string_view of the whole file, valid until the file is closed.
+		*/
+		string_view view() const;
+
+	private:
+
+		int fd;					/**< File descriptor (-1 if no file is open). */
+
+		char* address;			/**< Start of the mapping (nullptr if nothing is mapped). */
+
+		size_t length;			/**< Size of the mapping. */
+
+};
+
+#endif // MAPPED_FILE_INCLUDED_H
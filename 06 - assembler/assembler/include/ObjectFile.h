@@ -0,0 +1,88 @@
+#ifndef OBJECT_FILE_INCLUDED_H
+#define OBJECT_FILE_INCLUDED_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+	A relocatable object (.hobj): the machine code of a separately assembled module, and what
+	the linker needs to place it anywhere in the ROM and to resolve the symbols it shares with
+	other modules.
+
+	The A-instructions referring to a label of the module hold the offset of the label from the
+	start of the module, and are listed in @ref relocations. The A-instructions referring to a
+	symbol the module does not define hold 0, and are listed in @ref references: the linker
+	resolves the symbol to a label exported by another module or, if there is none, allocates it
+	as a variable.
+
+	The file is binary, all fields little-endian:
+
+		- offset 0: magic number, the 4 chars "HOBJ";
+
+		- offset 4: uint32 with the format @ref version;
+
+		- offset 8: five uint32 with the sizes of @ref words, @ref exports, @ref relocations,
+		  @ref variables and @ref references;
+
+		- the words (uint16 each), the exports (uint16 length, name chars, uint32 offset), the
+		  relocations (uint32 each), the variables (uint16 length, name chars) and the references
+		  (uint32 word index, uint32 variable index).
+*/
+class ObjectFile
+{
+
+	public:
+
+		/**
+			A label defined by the module.
+		*/
+		class Export {
+			public:
+				string name;		/**< Name of the label. */
+				uint32_t offset;	/**< Address of the label, from the start of the module. */
+		};
+
+		/**
+			An A-instruction referring to a symbol the module does not define.
+		*/
+		class Reference {
+			public:
+				uint32_t wordIndex;		/**< Position of the instruction in the module. */
+				uint32_t variableIndex;	/**< Position of the symbol in @ref variables. */
+		};
+
+		/**
+			Version of the format written by write().
+		*/
+		static const uint32_t version = 1;
+
+		/**
+			Writes the object to a stream.
+
+			@param outputStream Output stream, opened in binary mode.
+		*/
+		void write(ostream& outputStream) const;
+
+		/**
+			Reads an object from a stream, replacing the contents of this one.
+
+			@param inputStream Input stream, opened in binary mode.
+
+			@return True if the stream held a valid object. False otherwise (bad magic number or
+			version, truncated file, or indices out of range).
+		*/
+		bool read(istream& inputStream);
+
+		vector<uint16_t> words;				/**< Machine code of the module. */
+		vector<Export> exports;				/**< Labels defined by the module. */
+		vector<uint32_t> relocations;		/**< Positions of the instructions holding a label offset. */
+		vector<string> variables;			/**< Symbols used but not defined, in order of first use. */
+		vector<Reference> references;		/**< Instructions using them, in order. */
+
+};
+
+#endif // OBJECT_FILE_INCLUDED_H
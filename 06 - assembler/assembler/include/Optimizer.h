@@ -0,0 +1,176 @@
+#ifndef OPTIMIZER_INCLUDED_H
+#define OPTIMIZER_INCLUDED_H
+
+#include "Instruction.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+	Peephole optimizer of Hack programs. The passes track what the A and D registers are known
+	to hold along straight-line code (the knowledge is dropped at every label, where control may
+	come from elsewhere) and delete or fuse instructions that do not change the outcome of the
+	program:
+
+		- redundant A loads: \@X (or A=D, A=0...) when A already holds X;
+		- redundant D loads: D=A, D=M, D=0... when D already holds that value;
+		- increment/decrement fusions: M=M+1 followed by AM=M-1 becomes A=M (and M=M+1 followed
+		  by M=M-1 disappears);
+		- constant stores: M=D when D holds 0, 1 or -1 becomes M=0, M=1 or M=-1, which usually
+		  leaves the load of D dead;
+		- dead register writes: A-instructions and C-instructions writing only registers that
+		  are overwritten before being read.
+
+	The passes are repeated until none of them changes the program.
+
+	The optimizer can also remove the code that is never executed (see removeUnreachableCode()),
+	typically whole library functions that the program does not call. The labels nobody refers to
+	are dropped too, which gives longer straight-line code to the peephole passes.
+
+	@note Removing instructions moves the code, so labels must be resolved after optimizing.
+	Programs jumping to constant ROM addresses (\@100, 0;JMP) instead of labels are left
+	untouched: optimize() skips the peephole passes (see isPeepholeSkipped()) and the
+	unreachable code removal.
+*/
+class Optimizer
+{
+
+	public:
+
+		/**
+			Number of times an optimization was applied and of words it saved.
+		*/
+		class Pattern {
+			public:
+				Pattern(string name)
+					: name(name), count(0), wordsSaved(0)
+				{}
+
+				string name;		/**< Name of the optimization. */
+				int count;			/**< Times it was applied. */
+				int wordsSaved;		/**< Instructions it removed. */
+		};
+
+		/**
+			Optimization passes, to be combined in optimize().
+		*/
+		enum Pass {
+			PEEPHOLE = 1,			/**< Redundant loads, fusions, constant stores and dead writes. */
+			UNREACHABLE_CODE = 2	/**< Unreachable code and dead labels. */
+		};
+
+		/**
+			Constructs an Optimizer object.
+
+			@param program The program to be optimized, modified in place.
+		*/
+		Optimizer(vector<Instruction>& program);
+
+		/**
+			Optimizes the program.
+
+			@param passes Passes to run (a combination of Pass values).
+		*/
+		void optimize(unsigned int passes = PEEPHOLE);
+
+		/**
+			Were the peephole passes skipped by optimize(), because the program jumps to a
+			constant ROM address?
+		*/
+		bool isPeepholeSkipped() const;
+
+		/**
+			Returns what the optimizer did, one entry per optimization.
+
+			@return A reference to the report.
+		*/
+		const vector<Pattern>& getReport();
+
+	private:
+
+		/**
+			What a register is known to hold: a constant or the address of a symbol.
+		*/
+		class Value {
+			public:
+				bool known = false;		/**< Is the value known? */
+				int constant = 0;		/**< The constant (if symbol is empty). */
+				string_view symbol;		/**< The symbol whose address is the value. */
+
+				bool operator==(const Value& other) const;
+		};
+
+		/**
+			Indices of the patterns in @ref report.
+		*/
+		enum PatternIndex {
+			REDUNDANT_A_LOAD,
+			REDUNDANT_D_LOAD,
+			INCREMENT_FUSION,
+			CONSTANT_STORE,
+			DEAD_WRITE,
+			UNREACHABLE_INSTRUCTION,
+			DEAD_LABEL
+		};
+
+		/**
+			Forward pass: removes redundant A and D loads and rewrites constant stores.
+
+			@return True if the program changed.
+		*/
+		bool removeRedundantLoads();
+
+		/**
+			Fuses an increment of M immediately followed by a decrement (or the reverse).
+
+			@return True if the program changed.
+		*/
+		bool fuseIncrements();
+
+		/**
+			Backward pass: removes instructions writing only registers that are dead.
+
+			@return True if the program changed.
+		*/
+		bool removeDeadWrites();
+
+		/**
+			Removes the basic blocks that cannot be reached from the start of the program, and then
+			the labels no A-instruction refers to. A block is a run of instructions starting at a
+			label or after a jump; its successors are the next block (unless it ends with an
+			unconditional jump) and the label A holds at its jump, if any (\@LOOP, D;JGT).
+
+			Jumps to an address computed at run time (A=M, 0;JMP, as in the return from a VM
+			function) are assumed to reach any label whose address is taken, that is, loaded by
+			an A-instruction not followed by a jump (\@RET, D=A). Programs with jumps to constant
+			ROM addresses are left untouched.
+
+			@return True if the program changed.
+		*/
+		bool removeUnreachableCode();
+
+		/**
+			Does the program jump to a constant ROM address (\@100, 0;JMP)? Such a jump may
+			land anywhere once instructions are removed.
+		*/
+		bool jumpsToConstantAddress() const;
+
+		/**
+			Counts an optimization in the @ref report.
+
+			@param pattern The optimization.
+
+			@param wordsSaved Instructions it removed.
+		*/
+		void count(PatternIndex pattern, int wordsSaved);
+
+		vector<Instruction>& program;	/**< The program being optimized. */
+
+		vector<Pattern> report;			/**< What the optimizer did. */
+
+		bool peepholeSkipped;			/**< Were the peephole passes skipped? */
+
+};
+
+#endif // OPTIMIZER_INCLUDED_H
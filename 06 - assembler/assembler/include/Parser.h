@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 
 using namespace std;
 
@@ -16,32 +17,57 @@ enum class HasmCommandType {
     L_COMMAND       /**< L-command (pseudo command): (Xxx) */
 };
 
+/**
+    Lexer of Hack assembly programs. The parser works over a single contiguous buffer with
+    the whole program and every field it returns is a string_view into that buffer, so
+    advancing through the commands does not allocate memory. The fields of a command
+    (symbol, or dest, comp and jump) are split once, when the command is read.
+
+    Commands are separated by whitespace. Single line (//) and multi line comments are
+    skipped.
+*/
 class Parser
 {
 
     public:
 
         /**
-            Constructs a Parser object and binds it to the input stream.
+            Constructs a Parser object that reads the whole input stream into a buffer owned
+            by the parser.
 
             @param inputStream Input stream object that feeds the parser.
         */
         Parser(istream& inputStream);
 
+        /**
+            Constructs a Parser object over a buffer owned by the caller. The buffer must
+            outlive the parser and the string_views returned by it.
+
+            @param source Buffer with the Hack assembly program.
+        */
+        Parser(string_view source);
+
+        /**
+            Returns the buffer being parsed.
+
+            @return A string with the whole Hack assembly program.
+        */
+        string_view getSource();
+
         /**
             Returns the current command.
 
             @return A string with the current command.
         */
-        string getCommand();
+        string_view getCommand();
 
         /**
             Returns the current whole line (as read in the input stream) that is being
             parsed.
 
-            @return A string with the current line being parsed.
+            @return A string with the current line being parsed (without the line break).
         */
-        string getLine();
+        string_view getLine();
 
         /**
             Returns an integer value that represents the line/entry number in the input stream
@@ -84,7 +110,7 @@ class Parser
 
             @return A string with the symbol or decimal of the current command.
         */
-        string symbol();
+        string_view symbol();
 
         /**
             Returns the dest mnemonic in the current C-command (8 possibilities).
@@ -92,7 +118,7 @@ class Parser
 
             @return String with the dest mnemonic of the current C-command.
         */
-        string dest();
+        string_view dest();
 
         /**
             Returns the comp mnemonic in the current C-command (28 possibilities).
@@ -100,7 +126,7 @@ class Parser
 
             @return String with the comp mnemonic of the current C-command.
         */
-        string comp();
+        string_view comp();
 
         /**
             Returns the jump mnemonic in the current C-command (8 possibilities).
@@ -108,64 +134,67 @@ class Parser
 
             @return String with the jump mnemonic of the current C-command.
         */
-        string jump();
+        string_view jump();
 
         /**
-            Resets the parser by rewinding the input stream.
+            Resets the parser by rewinding to the beginning of the buffer.
         */
         void reset();
 
-    private:
-
         /**
-            Reads the next line from the input stream and updates both line count
-            @ref linePos and @ref currentLine.
+            Starts parsing another buffer owned by the caller (see Parser(string_view)).
 
-            @return True if another line was read successfully. False otherwise.
+            @param source Buffer with the Hack assembly program.
         */
-        bool readNextLine();
+        void setSource(string_view source);
 
-        /**
-            Updates @ref currentLine with the next valid line. A valid string line
-            is a non empty line. Line count @ref linePos is also updated.
-
-            @return True if there is a valid (non empty) line to parse. False
-            otherwise.
-        */
-        bool nextValidLine();
+    private:
 
         /**
-            Updates the input stream iterator @ref it to the next valid char.
-            A valid char is any char that is not a space nor a control char.
+            Moves @ref pos to the first char of the next command, skipping whitespace and
+            comments. Line count @ref linePos and @ref lineStart are updated on every
+            line break.
 
             @return True if there is one or more valid (non comment) chars in the
-            input stream to be read. False otherwise.
+            buffer to be read. False otherwise.
         */
         bool nextValidChar();
 
         /**
-            Updates the @ref currentLine iterator @ref it right after a comment.
+            Moves @ref pos right after the end of a multi line comment. @ref pos must point
+            to the opening chars of the comment.
 
-            Skips a comment (single and multi line comments) in the input stream of
-            commands. This function will call nextValidLine() once for line comments. For
-            multi line comments, it can call nextValidLine() any number of times until
-            the enclosing chars of the multi line comment are reached.
+            @return True if the comment is closed. False if the end of the buffer is reached.
+        */
+        bool skipMultiLineComment();
 
-            @return True if there is one or more valid (non comment) chars in the
-            input stream to be read. False otherwise.
+        /**
+            Splits the fields of the current command.
         */
-        bool skipComments();
+        void splitCommand();
 
-        istream& inputStream;       /**< Input stream that feeds the parser. */
+        string buffer;              /**< Buffer with the program when read from an input stream. */
 
-        string currentLine;         /**< Current line from the input stream being parsed. */
+        string_view source;         /**< Buffer with the program being parsed. */
 
-        string::iterator it;        /**< String iterator of the @ref currentLine. */
+        size_t pos;                 /**< Position in @ref source of the next char to be read. */
 
-        string command;             /**< The current command. May be updated after advance(). */
+        size_t lineStart;           /**< Position in @ref source where the current line starts. */
 
         int linePos;                /**< Line number of the current line. */
 
+        string_view command;        /**< The current command. May be updated after advance(). */
+
+        HasmCommandType type;       /**< Type of the current command. */
+
+        string_view symbolField;    /**< Symbol of the current A- or L-command. */
+
+        string_view destField;      /**< dest mnemonic of the current C-command. */
+
+        string_view compField;      /**< comp mnemonic of the current C-command. */
+
+        string_view jumpField;      /**< jump mnemonic of the current C-command. */
+
 };
 
 #endif // PARSER_INCLUDED_H
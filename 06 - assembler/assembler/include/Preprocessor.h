@@ -0,0 +1,322 @@
+#ifndef PREPROCESSOR_INCLUDED_H
+#define PREPROCESSOR_INCLUDED_H
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+/**
+	Preprocessor of Hack assembly programs: expands include directives and macros into plain
+	Hack assembly, before the program is assembled. Directives and macro calls take a whole line:
+
+		- <I>#include "file.asm"</I> inserts the file (named relative to the file with the
+		  directive). A file is included only once per program, so libraries may include each
+		  other freely;
+
+		- <I>MACRO NAME param1, param2...</I> starts the definition of a macro, ended by a line
+		  with <I>ENDM</I>. A macro must be defined before it is called;
+
+		- <I>NAME arg1, arg2...</I> calls a macro: its body is inserted with every parameter
+		  replaced by the argument (as a whole symbol: \@param, M=param...). A body may call
+		  other macros. Labels local to a macro start with %% (%%LOOP); each call gets its
+		  own copies (.M1.LOOP, .M2.LOOP...).
+
+	The expansion of a macro is computed once per tuple of arguments and copied at every
+	call with the same arguments. Included files are read and split into lines once and kept
+	in an IncludeCache, which may outlive the preprocessor (a server, a batch of files) and is
+	checked against the modification time of the files.
+
+	The origin of every line of the output (file and line, and call site of macro lines) is
+	recorded, so errors found by the assembler can be reported where they were written.
+*/
+class Preprocessor
+{
+
+	public:
+
+		/**
+			A line of a source file, classified once when the file is read.
+		*/
+		class Line {
+			public:
+				/**
+					Kinds of lines.
+				*/
+				enum Kind {
+					TEXT,				/**< Hack assembly, or a macro call. */
+					INCLUDE,			/**< #include directive. */
+					MACRO,				/**< Start of a macro definition. */
+					ENDM				/**< End of a macro definition. */
+				};
+
+				Kind kind;				/**< Kind of line. */
+				string_view text;		/**< The whole line, without the line break. */
+				string_view keyword;	/**< First word (the macro name of a call; empty in comments). */
+				string_view arguments;	/**< What follows the keyword, without comments. */
+		};
+
+		/**
+			A source file split into lines.
+		*/
+		class SourceFile {
+			public:
+				string path;			/**< Canonical path (empty for the program itself). */
+				timespec modified;		/**< Modification time when it was read. */
+				int64_t size;			/**< Size when it was read. */
+				string text;			/**< Contents (empty for the program itself, held by the caller). */
+				vector<Line> lines;		/**< Lines, as views into the contents. */
+		};
+
+		/**
+			Included files already read, shared by the preprocessors of many programs (and by
+			several threads at once). A file is read again when its modification time or size
+			changes.
+		*/
+		class IncludeCache {
+			public:
+				/**
+					Gets a file, reading it if it is not in the cache or changed since it was read.
+
+					@param fileName Name of the file.
+
+					@return The file, or null if it cannot be read.
+				*/
+				shared_ptr<const SourceFile> get(const string& fileName);
+
+			private:
+				mutex lock;													/**< Protects @ref files. */
+				unordered_map<string, shared_ptr<const SourceFile>> files;	/**< Files by canonical path. */
+		};
+
+		/**
+			Where a line of the output was written.
+		*/
+		class Position {
+			public:
+				uint32_t fileId;		/**< Index of the file (see getFileName()). */
+				uint32_t line;			/**< Line number in the file. */
+		};
+
+		/**
+			Origin of a line of the output.
+		*/
+		class Origin {
+			public:
+				Position source;		/**< Where the line was written (in a macro body, for macro lines). */
+				Position call;			/**< Where the macro was called (same as source if not a macro line). */
+				int mainLine;			/**< Line of the program (not an included file) that produced it. */
+		};
+
+		/**
+			An error found while preprocessing.
+		*/
+		class Diagnostic {
+			public:
+				string fileName;		/**< File with the error. */
+				int line;				/**< Line number of the error. */
+				string message;			/**< Description of the error. */
+		};
+
+		/**
+			Constructs a Preprocessor object.
+
+			@param includes Cache of the included files.
+		*/
+		Preprocessor(IncludeCache& includes);
+
+		/**
+			Does a program need to be preprocessed? A quick scan for the directives: programs
+			without them are assembled as they are.
+
+			@param source Hack assembly program.
+
+			@return True if the program may have directives. False otherwise.
+		*/
+		static bool isNeeded(string_view source);
+
+		/**
+			Preprocesses a program.
+
+			@param source Hack assembly program (must outlive the preprocessor).
+
+			@param fileName Name of the program; included files are named relative to its directory.
+
+			@return True if the program was preprocessed without errors. False otherwise.
+		*/
+		bool process(string_view source, string fileName);
+
+		/**
+			Returns the preprocessed program.
+
+			@return Plain Hack assembly, one line per origin.
+		*/
+		string_view getOutput() const;
+
+		/**
+			Returns the origin of a line of the output.
+
+			@param line Line number in the output (1 to the number of lines).
+		*/
+		const Origin& getOrigin(int line) const;
+
+		/**
+			Returns the name of a file of the program (0: the program, the others: included files).
+		*/
+		const string& getFileName(uint32_t fileId) const;
+
+		/**
+			Returns the number of files of the program (the program and the included files).
+		*/
+		size_t getFileCount() const;
+
+		/**
+			Describes where a line of the output comes from, for error messages: "file:line",
+			followed by " (expanded at file:line)" for macro lines.
+
+			@param line Line number in the output.
+		*/
+		string location(int line) const;
+
+		/**
+			Maps lines of the output to the lines of the program that produced them (see
+			Hass::Result::sourceLines and SourceMap::build()).
+
+			@param outputLines Line numbers in the output.
+
+			@return The line numbers in the program.
+		*/
+		vector<int> mainLines(const vector<int>& outputLines) const;
+
+		/**
+			Returns the errors found by process().
+		*/
+		const vector<Diagnostic>& getDiagnostics() const;
+
+		/**
+			Returns the number of macro calls expanded by process().
+		*/
+		size_t getCallCount() const;
+
+		/**
+			Returns the number of macro calls whose expansion was already computed.
+		*/
+		size_t getMemoizedCount() const;
+
+		/**
+			Splits a file into lines and classifies them.
+
+			@param text Contents of the file.
+
+			@param lines Receives the lines, as views into text.
+		*/
+		static void splitLines(string_view text, vector<Line>& lines);
+
+	private:
+
+		/**
+			A macro definition.
+		*/
+		class Macro {
+			public:
+				const SourceFile* file;		/**< File with the definition. */
+				uint32_t fileId;			/**< Index of the file. */
+				size_t first;				/**< Index of the first line of the body in the file. */
+				size_t last;				/**< Index of the ENDM line. */
+				vector<string> params;		/**< Parameter names. */
+		};
+
+		/**
+			The expansion of a macro for a tuple of arguments. Local labels are left as %%
+			until the expansion is copied to the output.
+		*/
+		class Expansion {
+			public:
+				string text;				/**< Expanded lines. */
+				vector<Position> lines;		/**< Position of every line of the text. */
+				bool hasLocals;				/**< Does the text have local labels? */
+		};
+
+		/**
+			Copies the lines of a file to the output, following its directives.
+
+			@param file The file.
+
+			@param fileId Index of the file.
+
+			@param mainLine Line of the program with the #include (0 for the program itself).
+		*/
+		void processFile(const SourceFile& file, uint32_t fileId, int mainLine);
+
+		/**
+			Reads a macro definition.
+
+			@param file The file.
+
+			@param fileId Index of the file.
+
+			@param index Index of the MACRO line, moved to its ENDM line.
+		*/
+		void defineMacro(const SourceFile& file, uint32_t fileId, size_t& index);
+
+		/**
+			Gets the expansion of a macro call, computing it the first time the arguments are seen.
+
+			@param name Name of the macro.
+
+			@param macro The macro.
+
+			@param arguments Arguments of the call.
+
+			@param call Position of the call.
+
+			@param depth Number of macro bodies the call is nested in.
+
+			@return The expansion, or null if the call has errors.
+		*/
+		const Expansion* expand(string_view name, const Macro& macro, string_view arguments, Position call, int depth);
+
+		/**
+			Copies an expansion to the output, giving its local labels names of their own.
+		*/
+		void emit(const Expansion& expansion, Position call, int mainLine);
+
+		/**
+			Adds an error at a position.
+		*/
+		void error(Position position, string message);
+
+		IncludeCache& includes;								/**< Cache of the included files. */
+
+		vector<string> fileNames;							/**< Names of the files of the program. */
+
+		vector<shared_ptr<const SourceFile>> sources;		/**< Files of the program, alive while their macros are. */
+
+		unordered_set<string> included;						/**< Canonical paths of the included files. */
+
+		unordered_map<string_view, Macro> macros;			/**< Macros by name (views into @ref sources). */
+
+		unordered_map<string, Expansion> expansions;		/**< Expansions by macro name and arguments. */
+
+		string output;										/**< The preprocessed program. */
+
+		vector<Origin> origins;								/**< Origin of every line of the output. */
+
+		vector<Diagnostic> diagnostics;						/**< Errors found. */
+
+		size_t callCount;									/**< Macro calls expanded. */
+
+		size_t memoizedCount;								/**< Calls whose expansion was already computed. */
+
+		size_t localCount;									/**< Calls that gave names to local labels. */
+
+};
+
+#endif // PREPROCESSOR_INCLUDED_H
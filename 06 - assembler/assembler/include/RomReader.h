@@ -0,0 +1,58 @@
+#ifndef ROM_READER_INCLUDED_H
+#define ROM_READER_INCLUDED_H
+
+#include "RomWriter.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+namespace RomReader
+{
+
+	/**
+		Returns the format of a ROM image file, from the extension of its name (see
+		RomWriter::getExtension()): a raw image may start with the magic number of the header,
+		so the contents do not tell.
+
+		@param fileName Name of the file.
+
+		@return RomFormat::BINARY for .bin, RomFormat::BINARY_HEADER for .hbin and
+		RomFormat::HACK otherwise.
+	*/
+	RomFormat getFormat(const string& fileName);
+
+	/**
+		Reads a ROM image written by RomWriter. The header of a RomFormat::BINARY_HEADER image
+		has its magic number, word count and checksum checked.
+
+		@param image Contents of the image (a mapped file, for instance).
+
+		@param format Format of the image.
+
+		@param rom Receives the words of the image.
+
+		@param error Receives the description of the error, if any.
+
+		@return True if the image was read. False otherwise.
+	*/
+	bool read(string_view image, RomFormat format, vector<uint16_t>& rom, string& error);
+
+	/**
+		Parses a text image (RomFormat::HACK): one line of 16 '0' and '1' chars per word.
+		Blank lines are skipped and line breaks may be CRLF.
+
+		@param text Contents of the image.
+
+		@param rom Receives the words of the image.
+
+		@return 0 if the image was parsed. Otherwise, the number of the first line that is
+		not a word.
+	*/
+	int parseHack(string_view text, vector<uint16_t>& rom);
+
+};
+
+#endif // ROM_READER_INCLUDED_H
@@ -0,0 +1,92 @@
+#ifndef ROM_WRITER_INCLUDED_H
+#define ROM_WRITER_INCLUDED_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+/**
+	The RomFormat enum class enumerates the formats in which a ROM image (the assembled
+	Hack machine code) can be written.
+*/
+enum class RomFormat {
+	HACK,           /**< Text: one 16 char line of '0' and '1' per instruction (.hack). */
+	BINARY,         /**< Raw little-endian 16 bit words (.bin). */
+	BINARY_HEADER   /**< Raw little-endian 16 bit words preceded by a @ref RomWriter::headerSize byte header (.hbin). */
+};
+
+namespace RomWriter
+{
+
+	/**
+		Size in bytes of the header written in the RomFormat::BINARY_HEADER format. All fields
+		are little-endian:
+
+			- offset 0: magic number, the 4 chars "HACK";
+
+			- offset 4: uint32 with the number of words in the image;
+
+			- offset 8: uint32 with the checksum() of the words.
+
+		The words follow the header, so they are 2 byte aligned in a mapped image.
+	*/
+	const size_t headerSize = 12;
+
+	/**
+		Writes the ROM image to the output stream in the given format. The whole image is
+		formatted in memory and handed to the stream with a single write.
+
+		@param outputStream Output stream in which the image will be written. Must be opened in
+		binary mode for the binary formats.
+
+		@param rom Words of the ROM image.
+
+		@param format Format of the image.
+	*/
+	void write(ostream& outputStream, const vector<uint16_t>& rom, RomFormat format);
+
+	/**
+		Returns the size of a ROM image in the given format.
+
+		@param wordCount Number of words of the ROM image.
+
+		@param format Format of the image.
+
+		@return The size of the image in bytes.
+	*/
+	size_t formattedSize(size_t wordCount, RomFormat format);
+
+	/**
+		Formats a ROM image into a buffer (for instance, a mapped output file).
+
+		@param buffer Buffer with at least formattedSize() bytes.
+
+		@param rom Words of the ROM image.
+
+		@param format Format of the image.
+	*/
+	void format(char* buffer, const vector<uint16_t>& rom, RomFormat format);
+
+	/**
+		Computes the Fletcher-32 checksum of the words of a ROM image.
+
+		@param rom Words of the ROM image.
+
+		@return The 32 bit checksum.
+	*/
+	uint32_t checksum(const vector<uint16_t>& rom);
+
+	/**
+		Returns the extension of the files written in a format: ".hack", ".bin" or ".hbin".
+		The readers tell the formats apart by it (see RomReader::getFormat()).
+
+		@param format Format of the image.
+	*/
+	string getExtension(RomFormat format);
+
+};
+
+#endif // ROM_WRITER_INCLUDED_H
@@ -0,0 +1,90 @@
+#ifndef SERVER_INCLUDED_H
+#define SERVER_INCLUDED_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+	Assembler server over a Unix domain socket ("hass --serve"), and the client side of the
+	protocol. A request carries a command line of the assembler, with the working directory of
+	the client and, when the input is "-", the standard input; the response carries what the
+	command wrote to the standard and error outputs, and its exit status. The server runs the
+	requests one at a time, so the handler may keep state (a warm assembler) between them; a
+	client that stops sending or receiving for 10 seconds is dropped, so that it does not
+	stall the others.
+
+	Every message is a list of strings, each one a little-endian uint32 length followed by the
+	chars, preceded by the uint32 number of strings. A request is the working directory, the
+	standard input and the arguments; a response is the exit status (in decimal), the standard
+	output and the error output. There is one request per connection.
+*/
+namespace Server
+{
+
+	/**
+		A command line to be run by the server.
+	*/
+	class Request {
+		public:
+			string workingDir;		/**< Directory the relative paths of the arguments refer to. */
+			string input;			/**< Standard input (assembled if the input argument is "-"). */
+			vector<string> args;	/**< Arguments, without the program name. */
+	};
+
+	/**
+		Outcome of a request.
+	*/
+	class Response {
+		public:
+			int status = 1;			/**< Exit status. */
+			string output;			/**< Standard output (the ROM, for the standard input). */
+			string errors;			/**< Error output (diagnostics). */
+	};
+
+	/**
+		Runs a request, filling its response.
+	*/
+	typedef function<void(const Request&, Response&)> Handler;
+
+	/**
+		Returns the socket used when none is given: $HASS_SOCKET if set, or a socket named
+		after the user in /tmp.
+
+		@return The path of the socket.
+	*/
+	string defaultSocketPath();
+
+	/**
+		Listens on a socket and runs the requests received until the process is interrupted
+		(SIGINT or SIGTERM), then removes the socket. Errors are reported to the standard error
+		output.
+
+		@param socketPath Path of the socket. A stale socket left by a dead server is replaced.
+
+		@param handler Function running the requests.
+
+		@return True if the server ran until interrupted. False if the socket could not be
+		created or another server is listening on it.
+	*/
+	bool serve(string socketPath, Handler handler);
+
+	/**
+		Sends a request to a server and waits for its response.
+
+		@param socketPath Path of the socket of the server.
+
+		@param request Request to be sent.
+
+		@param response Response received.
+
+		@return True if the response was received. False if no server is listening on the
+		socket or the connection failed.
+	*/
+	bool call(string socketPath, const Request& request, Response& response);
+
+};
+
+#endif // SERVER_INCLUDED_H
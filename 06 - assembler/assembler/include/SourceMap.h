@@ -0,0 +1,162 @@
+#ifndef SOURCE_MAP_INCLUDED_H
+#define SOURCE_MAP_INCLUDED_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+	A source map (.hackmap): links the ROM addresses of an assembled program to the lines of its
+	source, so profilers and debuggers can attribute cycles to the source without parsing it
+	again. When the source was written by the VM translator, the map also carries the VM
+	commands, taken from the comments the translator writes: "// from file: X.vm" starts the
+	commands of a VM file and the comment on the first instruction of a command
+	("// push constant 2") names the command.
+
+	The file is binary and meant to be mapped into memory and searched in place (see open()).
+	All fields are little-endian:
+
+		- offset 0: magic number, the 4 chars "HMAP";
+
+		- offset 4: uint32 with the format @ref version;
+
+		- offset 8: four uint32 with the number of files, of lines, of commands and the size of
+		  the strings;
+
+		- the files (uint32 offset of the name in the strings): file 0 is the assembly source,
+		  the others the VM files;
+
+		- the lines (uint32 ROM address, uint32 file, uint32 line), one for every source line
+		  with words, sorted by address;
+
+		- the commands (uint32 ROM address, uint32 file, uint32 offset of the command in the
+		  strings) at the first word of every VM command, sorted by address;
+
+		- the strings, each one terminated by a null char.
+*/
+class SourceMap
+{
+
+	public:
+
+		/**
+			A position in the source, or the VM command a word belongs to.
+		*/
+		class Entry {
+			public:
+				uint32_t romAddress;	/**< First word at this position. */
+				uint32_t fileId;		/**< Index of the file in the files of the map. */
+				uint32_t line;			/**< Line in the file (lines), or offset of the command text (commands). */
+		};
+
+		/**
+			Version of the format written by write().
+		*/
+		static const uint32_t version = 1;
+
+		/**
+			Constructs an empty SourceMap object.
+		*/
+		SourceMap();
+
+		/**
+			Builds the map of a program, replacing the contents of this one.
+
+			@param source Assembly source of the program.
+
+			@param sourceLines Source line of every word of the program (see Hass::Options::sourceLines).
+
+			@param inputName Name of the source, file 0 of the map.
+		*/
+		void build(string_view source, const vector<int>& sourceLines, string inputName);
+
+		/**
+			Writes the map built by build() to a stream.
+
+			@param outputStream Output stream, opened in binary mode.
+		*/
+		void write(ostream& outputStream) const;
+
+		/**
+			Uses a map written by write(), held in memory (a MappedFile, for instance), which
+			must outlive the lookups. Nothing is copied.
+
+			@param image Contents of a .hackmap file.
+
+			@return True if the image is a valid map. False otherwise (bad magic number or
+			version, truncated file, or offsets out of range).
+		*/
+		bool open(string_view image);
+
+		/**
+			Finds the source line of a word of a map opened by open().
+
+			@param romAddress Address of the word.
+
+			@param entry Receives the line (romAddress is the first word of the line).
+
+			@return True if the address has a line. False otherwise.
+		*/
+		bool findLine(uint32_t romAddress, Entry& entry) const;
+
+		/**
+			Finds the VM command of a word of a map opened by open(): the last command starting
+			at or before the word.
+
+			@param romAddress Address of the word.
+
+			@param entry Receives the command (line is the offset of its text, see text()).
+
+			@return True if the address has a command. False otherwise.
+		*/
+		bool findCommand(uint32_t romAddress, Entry& entry) const;
+
+		/**
+			Returns the name of a file of a map opened by open() (empty if out of range).
+		*/
+		string_view fileName(uint32_t fileId) const;
+
+		/**
+			Returns a string of a map opened by open() (empty if out of range).
+
+			@param offset Offset of the string, as in Entry::line of a command.
+		*/
+		string_view text(uint32_t offset) const;
+
+		/**
+			Returns the number of lines of a map opened by open().
+		*/
+		size_t lineCount() const;
+
+		/**
+			Returns the number of commands of a map opened by open().
+		*/
+		size_t commandCount() const;
+
+	private:
+
+		/**
+			Finds the last record of a table starting at or before a word.
+		*/
+		bool find(const char* table, size_t count, uint32_t romAddress, Entry& entry) const;
+
+		vector<uint32_t> files;			/**< Offsets of the file names (build()). */
+		vector<Entry> lines;			/**< Lines of the words (build()). */
+		vector<Entry> commands;			/**< VM commands (build()). */
+		string strings;					/**< File names and command texts (build()). */
+
+		const char* fileTable;			/**< Files in the image. */
+		const char* lineTable;			/**< Lines in the image. */
+		const char* commandTable;		/**< Commands in the image. */
+		string_view stringTable;		/**< Strings in the image. */
+		size_t fileTotal;				/**< Files in the image. */
+		size_t lineTotal;				/**< Lines in the image. */
+		size_t commandTotal;			/**< Commands in the image. */
+
+};
+
+#endif // SOURCE_MAP_INCLUDED_H
@@ -2,31 +2,58 @@
 #define SYMBOL_TABLE_INCLUDED_H
 
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
 
 using namespace std;
 
+/**
+	Maps symbols to addresses. The table is a flat open addressing hash table (linear probing)
+	whose slots index a dense array of entries kept in insertion order. Symbols are interned:
+	each distinct symbol is copied once into an arena owned by the table, so the string_views
+	handed to the table only need to live for the duration of the call.
+*/
 class SymbolTable
 {
 
 	public:
 
-        /**
-            Loads all entries of a map<string, int> to the symbol table. Previous
-			entries will be erased.
+		/**
+			A pair <symbol, address> of the table.
+		*/
+		class Entry {
+			public:
+				string_view symbol;		/**< Interned symbol (owned by the table). */
+				int address;			/**< Address of the symbol. */
+		};
+
+		/**
+			State of the table at some point, to rewind() to it later.
+		*/
+		class Mark {
+			public:
+				size_t entryCount;		/**< Number of entries. */
+				size_t blockCount;		/**< Number of blocks of the arena. */
+				char* arenaNext;		/**< Next free char of the arena. */
+				size_t arenaFree;		/**< Free chars in the last block of the arena. */
+		};
 
-			@param symbolMap A map with symbols to be loaded into the symbol table.
+		/**
+			Constructs an empty symbol table.
 		*/
-		void loadMap(map<string, int> symbolMap);
+		SymbolTable();
 
 		/**
-			Adds the pair <symbol, address> to the table.
+			Adds the pair <symbol, address> to the table. If the symbol is already in the table its
+			address is not changed.
 
 			@param symbol String with the symbol to be added.
 
 			@param address Integer with the address of the symbol being added.
 		*/
-		void addEntry(string symbol, int address);
+		void addEntry(string_view symbol, int address);
 
 		/**
 			Does the symbol table contain the given symbol?
@@ -36,28 +63,136 @@ class SymbolTable
 
 			@return True if the table contains the given symbol, False otherwise.
 		*/
-		bool contains(string symbol);
+		bool contains(string_view symbol) const;
 
 		/**
 			Returns the address associated with the symbol.
 
 			@param symbol String with the symbol which its address is requested.
 
-			@return An integer with the address of the given symbol.
+			@return An integer with the address of the given symbol, or -1 if the symbol is not
+			in the table.
+		*/
+		int getAddress(string_view symbol) const;
+
+		/**
+			Returns the address associated with the symbol, adding the pair <symbol, address> to
+			the table if the symbol is not there yet. Takes a single probe sequence.
+
+			@param symbol String with the symbol to be looked up.
+
+			@param address Integer with the address given to the symbol if it is added.
+
+			@param inserted Set to True if the symbol was added, False if it was already in the table.
+
+			@return An integer with the address of the symbol.
 		*/
-		int getAddress(string symbol);
+		int findOrInsert(string_view symbol, int address, bool& inserted);
 
 		/**
-			Returns a map populated with pairs <symbol, address>, where symbol is a string and
-			address an int.
+			Returns the number of entries in the table.
 
-			@return A map<string, int> with the symbol table.
+			@return The number of symbols in the table.
 		*/
-		map<string, int> getTable();
+		size_t size() const;
+
+		/**
+			Returns the entries of the table in insertion order.
+
+			@return A reference to the vector of entries (valid until the next insertion).
+		*/
+		const vector<Entry>& getEntries() const;
+
+		/**
+			Returns a view of a range of entries, in insertion order, sorted by symbol. The entries
+			are not copied.
+
+			@param first Position (in insertion order) of the first entry of the range.
+
+			@param last Position (in insertion order) past the last entry of the range.
+
+			@return A vector with pointers to the entries, sorted by symbol (valid until the next
+			insertion).
+		*/
+		vector<const Entry*> getSortedEntries(size_t first, size_t last) const;
+
+		/**
+			Removes all entries from the table.
+		*/
+		void clear();
+
+		/**
+			Returns the current state of the table.
+
+			@return A mark to be passed to rewind().
+		*/
+		Mark getMark() const;
+
+		/**
+			Removes the entries added since the mark was taken. Unlike clear(), the memory of
+			the table is kept: the arena blocks in use at the mark are reused by the next
+			insertions.
+
+			@param mark State to go back to, taken with getMark().
+		*/
+		void rewind(const Mark& mark);
 
 	private:
 
-		map<string, int> table;		/**< Symbol map. */
+		/**
+			Finds the slot of a symbol: either the slot holding it or the empty slot where it
+			should be inserted.
+
+			@param symbol Symbol to be looked up.
+
+			@param hash Hash of the symbol.
+
+			@return Position of the slot in @ref slots.
+		*/
+		size_t findSlot(string_view symbol, uint32_t hash) const;
+
+		/**
+			Adds a new entry to a free slot, growing the table if needed.
+
+			@return The address of the new entry.
+		*/
+		int insert(size_t slot, string_view symbol, uint32_t hash, int address);
+
+		/**
+			Doubles the number of slots and rehashes all entries.
+		*/
+		void grow();
+
+		/**
+			Copies a symbol to the arena.
+
+			@return A view of the copy, valid for the lifetime of the table.
+		*/
+		string_view intern(string_view symbol);
+
+		/**
+			Computes the hash of a symbol (FNV-1a).
+		*/
+		static uint32_t hashOf(string_view symbol);
+
+		/**
+			A slot of the hash table.
+		*/
+		class Slot {
+			public:
+				uint32_t hash;			/**< Hash of the symbol, to skip most string compares. */
+				uint32_t index;			/**< Position in @ref entries plus one; 0 for an empty slot. */
+		};
+
+		vector<Slot> slots;						/**< Hash table (the size is a power of 2). */
+
+		vector<Entry> entries;					/**< Entries in insertion order. */
+
+		vector<unique_ptr<char[]>> arena;		/**< Blocks holding the interned symbols. */
+
+		char* arenaNext;						/**< Next free char in the last block of the arena. */
+
+		size_t arenaFree;						/**< Free chars in the last block of the arena. */
 
 };
 
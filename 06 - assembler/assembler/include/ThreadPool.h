@@ -0,0 +1,107 @@
+#ifndef THREAD_POOL_INCLUDED_H
+#define THREAD_POOL_INCLUDED_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+	A fixed-size pool of worker threads. Each worker owns a queue of tasks: it takes work
+	from the front of its own queue and, when that is empty, steals from the back of the
+	queues of the other workers, so a few long tasks do not keep the rest of the pool idle.
+*/
+class ThreadPool
+{
+
+	public:
+
+		/**
+			Constructs a ThreadPool object and starts its workers.
+
+			@param threadCount Number of worker threads. If 0, one per hardware thread is used.
+		*/
+		ThreadPool(unsigned int threadCount);
+
+		/**
+			Waits for the pending tasks and stops the workers.
+		*/
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/**
+			Queues a task. Tasks are spread over the worker queues in a round-robin fashion.
+
+			@param task Function to be run by one of the workers.
+		*/
+		void submit(function<void()> task);
+
+		/**
+			Blocks until all submitted tasks are finished.
+		*/
+		void wait();
+
+		/**
+			Returns the number of worker threads.
+		*/
+		unsigned int size() const;
+
+	private:
+
+		/**
+			Task queue of a worker. The owner pops from the front, thieves from the back.
+		*/
+		class Queue
+		{
+			public:
+				deque<function<void()>> tasks;		/**< Queued tasks. */
+				mutex lock;							/**< Protects the tasks. */
+		};
+
+		vector<unique_ptr<Queue>> queues;			/**< One task queue per worker. */
+
+		vector<thread> workers;						/**< Worker threads. */
+
+		mutex lock;									/**< Protects the counters below. */
+
+		condition_variable available;				/**< Signaled when a task is queued or the pool stops. */
+
+		condition_variable finished;				/**< Signaled when the last pending task finishes. */
+
+		size_t queued;								/**< Tasks queued and not yet claimed by a worker. */
+
+		size_t pending;								/**< Tasks submitted and not yet finished. */
+
+		size_t next;								/**< Queue receiving the next submitted task. */
+
+		bool stopping;								/**< Set by the destructor to stop the workers. */
+
+		/**
+			Main loop of a worker: waits for a task, runs it and repeats until the pool stops.
+
+			@param index Index of the worker (and of its queue).
+		*/
+		void run(size_t index);
+
+		/**
+			Takes a task, first from the worker's own queue and then from the others.
+			Must only be called after claiming a task from @ref queued, which guarantees
+			that some queue holds one.
+
+			@param index Index of the worker.
+
+			@return The task.
+		*/
+		function<void()> take(size_t index);
+
+};
+
+#endif // THREAD_POOL_INCLUDED_H
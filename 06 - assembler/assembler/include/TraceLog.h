@@ -0,0 +1,113 @@
+#ifndef TRACE_LOG_INCLUDED_H
+#define TRACE_LOG_INCLUDED_H
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+	Format of the records of the commands in verbose mode.
+*/
+enum class TraceFormat {
+	COLUMNS,		/**< Human-readable columns (number, line, command, type, binary). */
+	JSONL			/**< One JSON object per command and line, for tools. */
+};
+
+/**
+	Buffered asynchronous log. What is written to stream() is gathered in a large buffer owned by
+	the writing thread, and full buffers are handed to a background thread that writes them to
+	the output stream, so the writer never waits for the output unless it falls a few buffers
+	behind. Flushes of the stream (endl) do not reach the output; flush() and the destructor do.
+
+	A TraceLog has one writing thread at a time (each assembly owns its own, see Hass::assemble()).
+*/
+class TraceLog : private streambuf
+{
+
+	public:
+
+		/**
+			Constructs a TraceLog object and starts its background thread.
+
+			@param outputStream Stream the log is written to.
+
+			@param bufferSize Size of each buffer, in bytes.
+		*/
+		TraceLog(ostream& outputStream, size_t bufferSize = 65536);
+
+		/**
+			Writes what is left in the buffers and stops the background thread.
+		*/
+		~TraceLog();
+
+		TraceLog(const TraceLog&) = delete;
+		TraceLog& operator=(const TraceLog&) = delete;
+
+		/**
+			Returns the stream writing to the log.
+		*/
+		ostream& stream();
+
+		/**
+			Hands the current buffer to the background thread and waits until everything
+			written so far has reached the output stream.
+		*/
+		void flush();
+
+	private:
+
+		/**
+			Called by the stream when the current buffer is full: hands it over and starts the next.
+		*/
+		int_type overflow(int_type c) override;
+
+		/**
+			Called by the stream on flushes, which are left to flush() (returns 0: success).
+		*/
+		int sync() override;
+
+		/**
+			Hands the written part of the current buffer to the background thread, waiting if too
+			many buffers are queued, and starts a new buffer.
+		*/
+		void submit();
+
+		/**
+			Main loop of the background thread: writes the queued buffers until stopped.
+		*/
+		void run();
+
+		ostream& outputStream;				/**< Output of the log. */
+
+		ostream logStream;					/**< Stream writing to the current buffer. */
+
+		size_t bufferSize;					/**< Size of each buffer. */
+
+		string current;						/**< Buffer being written. */
+
+		deque<string> queued;				/**< Full buffers waiting for the background thread. */
+
+		vector<string> spare;				/**< Written buffers, reused by submit(). */
+
+		mutex lock;							/**< Protects the queues and flags. */
+
+		condition_variable available;		/**< Signaled when a buffer is queued or the log stops. */
+
+		condition_variable written;			/**< Signaled when a buffer has been written. */
+
+		bool writing;						/**< Is the background thread writing a buffer? */
+
+		bool stopping;						/**< Set by the destructor to stop the background thread. */
+
+		thread writer;						/**< Background thread. */
+
+};
+
+#endif // TRACE_LOG_INCLUDED_H
@@ -1,49 +1,187 @@
 #include <iostream>
+#include <algorithm>
+#include <cctype>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
 #include <unistd.h>
-#include "Assembler.h"
+#include <cstdlib>
+#include <memory>
+#include "BuildCache.h"
+#include "SourceMap.h"
+#include "Hass.h"
 #include "FileHandler.h"
+#include "MappedFile.h"
+#include "Preprocessor.h"
+#include "RomWriter.h"
+#include "Server.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
+namespace {
+
+	const unsigned long maxJobs = 256; // threads at most (-j); larger counts are lowered to it
+
+}
+
 /**
-	Gets the verbose and 'very verbose' flags from the command line arguments.
+	Options of the assembler, read from the command line arguments.
+*/
+class Flags
+{
+	public:
+		bool verbose = false;					/**< Verbose flag. */
+		bool veryVerbose = false;				/**< 'Very verbose' flag. */
+		bool jsonTrace = false;					/**< Verbose details as JSON lines flag. */
+		bool symTable = false;					/**< Output symbol table flag. */
+		bool sourceMap = false;					/**< Output source map flag. */
+		bool singlePass = false;				/**< Single pass flag. */
+		bool optimize = false;					/**< Peephole optimizer flag. */
+		bool removeUnreachable = false;			/**< Unreachable code removal flag. */
+		bool object = false;					/**< Relocatable object output flag. */
+		RomFormat romFormat = RomFormat::HACK;	/**< Output format. */
+		unsigned int jobs = 1;					/**< Number of threads. */
+		bool jobsGiven = false;					/**< Was the number of threads given (-j)? One per core in batch mode otherwise. */
+		Hass::Context* context = nullptr;		/**< Warm assembler of the server (not shared by batch threads). */
+		string cacheDir;						/**< Directory of the build cache (empty: $HASS_CACHE, if set). */
+		BuildCache* cache = nullptr;			/**< Build cache, if any. */
+		Preprocessor::IncludeCache* includes = nullptr; /**< Included files already read (shared by batch threads and server requests). */
+};
 
-	@param argc Number of command line arguments.
+/**
+	Prints the usage of the assembler.
+*/
+void printUsage()
+{
+	cerr << "usage: " << "hass" << " [-v|-V|-J|-t|-m|-s|-O|-e|-c] [-f hack|bin|hbin] [-j threads] [-C dir] input..." << endl;
+	cerr << "       " << "hass" << " --serve[=socket]" << endl;
+	cerr << "       " << "hass" << " --cache-stats[=dir]" << endl;
+	cerr << "       -v verbose" << endl;
+	cerr << "       -V very verbose" << endl;
+	cerr << "       -J details of the commands as JSON lines, one per command (with -V: fields" << endl;
+	cerr << "          of the C-instructions too); the other details are left out" << endl;
+	cerr << "       -t output symbol table" << endl;
+	cerr << "       -m output source map (.hackmap: ROM addresses to source lines and VM commands)" << endl;
+	cerr << "       -s single pass (reads the input only once)" << endl;
+	cerr << "       -O optimize (peephole optimizer, report printed with -v)" << endl;
+	cerr << "       -e eliminate unreachable code and unused labels (report printed with -v)" << endl;
+	cerr << "       -c output a relocatable object (.hobj) to be linked with hlink" << endl;
+	cerr << "       -f output format: hack (text, default), bin (raw little-endian words)" << endl;
+	cerr << "          or hbin (raw words with a header holding word count and checksum)" << endl;
+	cerr << "       -j number of threads (0: one per core, 256 at most); splits a single large file," << endl;
+	cerr << "          or assembles several files concurrently (default: 1 for a single file," << endl;
+	cerr << "          one per core for several)" << endl;
+	cerr << "       -C build cache directory (default: $HASS_CACHE); outputs of sources already" << endl;
+	cerr << "          assembled with the same options are copied from it (not in verbose mode)" << endl;
+	cerr << "       input is an .asm file, a directory (all the .asm files in it) or" << endl;
+	cerr << "       @list (the files named in list, one per line); many inputs may be given" << endl;
+	cerr << "       use - as input to assemble the standard input to the standard output" << endl;
+	cerr << "       inputs may include files (#include \"file.asm\") and define macros" << endl;
+	cerr << "          (MACRO NAME param1, param2 ... ENDM, called as NAME arg1, arg2)" << endl;
+	cerr << "       --serve runs a server taking the command lines of hassc on a Unix socket" << endl;
+	cerr << "          (default: $HASS_SOCKET or /tmp/hass-uid.socket)" << endl;
+}
 
-	@param argv Array of arguments.
+/**
+	Gets the flags from the command line arguments.
 
-	@param verbose Verbose flag. Its value will be affected by the arguments.
+	@param argc Number of command line arguments.
 
-	@param veryVerbose 'Very verbose' flag. Its value will be affected by the arguments.
+	@param argv Array of arguments.
 
-	@param symTable Output symbol table flag. Its value will be affected by the arguments.
+	@param flags Flags. Their values will be affected by the arguments.
 
 	@return Returns false if an unidentified flag is present in the arguments.
 	True otherwise.
 */
-bool getFlags(int argc, char** argv, bool& verbose, bool& veryVerbose, bool& symTable)
+bool getFlags(int argc, char** argv, Flags& flags)
 {
 	char c;
-	verbose = veryVerbose = symTable = false;
 
-	while ((c = getopt(argc, argv, "vVt")) != -1) {
+	opterr = 0; // reported through cerr, which the server sends to the client
+
+	while ((c = getopt(argc, argv, ":vVJtmsOecf:j:C:")) != -1) {
 
         switch (c) {
 
             case 'V':
-                veryVerbose = true;
+                flags.veryVerbose = true;
             case 'v':
-                verbose = true;
+                flags.verbose = true;
+                break;
+
+            case 'J':
+                flags.jsonTrace = true;
                 break;
 
             case 't':
-                symTable = true;
+                flags.symTable = true;
+                break;
+
+            case 'm':
+                flags.sourceMap = true;
+                break;
+
+            case 's':
+                flags.singlePass = true;
+                break;
+
+            case 'O':
+                flags.optimize = true;
                 break;
 
+            case 'e':
+                flags.removeUnreachable = true;
+                break;
+
+            case 'c':
+                flags.object = true;
+                break;
+
+            case 'f':
+                if (string(optarg) == "hack") {
+                    flags.romFormat = RomFormat::HACK;
+                } else if (string(optarg) == "bin") {
+                    flags.romFormat = RomFormat::BINARY;
+                } else if (string(optarg) == "hbin") {
+                    flags.romFormat = RomFormat::BINARY_HEADER;
+                } else {
+                    cerr << "error: unknown output format \"" << optarg << "\"" << endl;
+                    return false;
+                }
+                break;
+
+            case 'j': {
+                char* end;
+                unsigned long jobs = strtoul(optarg, &end, 10);
+
+                if (!isdigit(optarg[0]) || *end != '\0') {
+                    cerr << "error: invalid number of threads \"" << optarg << "\"" << endl;
+                    printUsage();
+                    return false;
+                }
+
+                flags.jobs = min(jobs, maxJobs);
+                flags.jobsGiven = true;
+                break;
+            }
+
+            case 'C':
+                flags.cacheDir = optarg;
+                break;
+
+            case ':':
+                cerr << "error: option -" << char(optopt) << " requires an argument" << endl;
+                printUsage();
+                return false;
+
             case '?':
-                return 1;
+                cerr << "error: unknown option -" << char(optopt) << endl;
+                printUsage();
+                return false;
 
         }
     }
@@ -54,17 +192,19 @@ bool getFlags(int argc, char** argv, bool& verbose, bool& veryVerbose, bool& sym
 /**
 	Checks if the input string is the name of a regular file with the extension ".asm".
 
+	@param err Stream for the error messages.
+
 	@return True if the input string is the name of .asm file. False otherwise.
 */
-bool isAsmFile(string input)
+bool isAsmFile(string input, ostream& err)
 {
 	if (!FileHandler::isFile(input)) {
-		cerr << "error: input \"" << input << "\"is not a file" << endl;
+		err << "error: input \"" << input << "\" is not a file" << endl;
 		return false;
 	}
 
 	if (!FileHandler::hasExtension(input, ".asm")) {
-		cerr << "error: input file must have .asm extension" << endl;
+		err << "error: input file must have .asm extension" << endl;
 		return false;
 	}
 
@@ -72,67 +212,628 @@ bool isAsmFile(string input)
 }
 
 /**
+	Writes a relocatable object to a file.
 
+	@param object Object of the assembled program.
+
+	@param outputName Name of the output file.
+
+	@param err Stream for the error messages.
+
+	@return True if the output file was written. False otherwise.
 */
-int main(int argc, char** argv)
+bool writeObject(const ObjectFile& object, string outputName, ostream& err)
 {
-	if (argc == 1) {
-		cerr << "usage: " << "hass" << " [-v|-V|-t] input-filename.asm" << endl;
-		cerr << "       -v verbose" << endl;
-		cerr << "       -V very verbose" << endl;
-		cerr << "       -t output symbol table" << endl;
-		return 1;
+	ofstream outputFile(outputName, ios::binary);
+
+	if (!outputFile.good()) {
+		err << "error: unable to open output file \"" << outputName << "\"" << endl;
+		return false;
 	}
 
-	bool verbose, veryVerbose, symTable;
+	object.write(outputFile);
 
-	if (!getFlags(argc, argv, verbose, veryVerbose, symTable))
-		return 1;
+	return outputFile.good();
+}
 
-	string inputName(argv[argc - 1]);
+/**
+	Writes the machine code to a file, preallocated with the size of the image and mapped
+	into memory.
 
-	if (!isAsmFile(inputName))
-		return 1;
+	@param rom Words of the assembled program.
 
-	ifstream inputFile(inputName);
+	@param outputName Name of the output file.
 
-	if (!inputFile.good()) {
-		cerr << "error: unable to open input stream" << endl;
-		return 1;
+	@param romFormat Format of the output file.
+
+	@param err Stream for the error messages.
+
+	@return True if the output file was written. False otherwise.
+*/
+bool writeRom(const vector<uint16_t>& rom, string outputName, RomFormat romFormat, ostream& err)
+{
+	MappedFile outputFile;
+
+	if (!outputFile.create(outputName, RomWriter::formattedSize(rom.size(), romFormat))) {
+		err << "error: unable to open output file \"" << outputName << "\"" << endl;
+		return false;
 	}
 
-	string outputName(FileHandler::changeExtension(inputName, ".hack"));
-	ofstream outputFile(outputName);
+	RomWriter::format(outputFile.data(), rom, romFormat);
 
-	if (!outputFile.good()) {
-		cerr << "error: unable to open output stream" << endl;
+	return true;
+}
+
+/**
+	Gets the options of the assembler library from the flags.
+
+	@param flags Flags from the command line.
+
+	@param inputName Name of the input.
+
+	@param outputName Name of the output.
+
+	@param log Stream for the verbose details.
+
+	@return The options.
+*/
+Hass::Options getOptions(const Flags& flags, string inputName, string outputName, ostream& log)
+{
+	Hass::Options options;
+	options.inputName = inputName;
+	options.outputName = outputName;
+	options.singlePass = flags.singlePass;
+	options.sourceLines = flags.sourceMap;
+	options.optimize = flags.optimize;
+	options.removeUnreachable = flags.removeUnreachable;
+	options.object = flags.object;
+	options.threads = flags.jobs;
+	options.verbose = flags.verbose || flags.jsonTrace;
+	options.traceFormat = flags.jsonTrace ? TraceFormat::JSONL : TraceFormat::COLUMNS;
+	options.veryVerbose = flags.veryVerbose;
+	options.logStream = &log;
+	options.context = flags.context;
+
+	return options;
+}
+
+/**
+	Prints the errors found while assembling.
+
+	@param result Assembled program.
+
+	@param inputName Name of the input.
+
+	@param preprocessor Preprocessor of the input, which knows where its lines come from (null
+	if the input was not preprocessed).
+
+	@param err Stream for the error messages.
+*/
+void printDiagnostics(const Hass::Result& result, string inputName, const Preprocessor* preprocessor, ostream& err)
+{
+	for (auto& diagnostic: result.diagnostics) {
+		if (preprocessor != nullptr)
+			err << "error: " << preprocessor->location(diagnostic.line) << ": " << diagnostic.message << endl;
+		else
+			err << "error: " << inputName << ":" << diagnostic.line << ": " << diagnostic.message << endl;
+	}
+}
+
+/**
+	Expands the includes and macros of an input (see Preprocessor).
+
+	@param source Source of the input; receives the preprocessed program.
+
+	@param inputName Name of the input.
+
+	@param preprocessor Preprocessor of the input.
+
+	@param err Stream for the error messages.
+
+	@return True if the input was preprocessed without errors. False otherwise.
+*/
+bool preprocess(string_view& source, string inputName, Preprocessor& preprocessor, ostream& err)
+{
+	if (!preprocessor.process(source, inputName)) {
+		for (auto& diagnostic: preprocessor.getDiagnostics())
+			err << "error: " << diagnostic.fileName << ":" << diagnostic.line << ": " << diagnostic.message << endl;
+
+		return false;
+	}
+
+	source = preprocessor.getOutput();
+
+	return true;
+}
+
+/**
+	Assembles the standard input, writing the machine code to the standard output.
+
+	@return The exit status of the assembler.
+*/
+int assembleStdin(const Flags& flags)
+{
+	ostringstream input;
+	input << cin.rdbuf();
+
+	string text(input.str());
+	string_view source(text);
+	Preprocessor preprocessor(*flags.includes);
+	bool preprocessed = Preprocessor::isNeeded(source);
+
+	if (preprocessed && !preprocess(source, "stdin", preprocessor, cerr))
 		return 1;
+
+	Hass::Result result = Hass::assemble(source, getOptions(flags, "stdin", "stdout", cout));
+	printDiagnostics(result, "stdin", preprocessed ? &preprocessor : nullptr, cerr);
+
+	if (flags.object)
+		result.object.write(cout);
+	else
+		RomWriter::write(cout, result.rom, flags.romFormat);
+
+	return result.ok ? 0 : 1;
+}
+
+/**
+	Describes what the outputs of an assembly depend on, besides the source, for the keys of
+	the build cache. The options that do not change the outputs (single pass, threads) are
+	left out, so their assemblies share entries.
+
+	@param flags Flags from the command line.
+
+	@param inputName Name of the input, which appears in the source map.
+
+	@param outputName Name of the output, which appears in the symbol table.
+
+	@return The description.
+*/
+string cacheContext(const Flags& flags, string inputName, string outputName)
+{
+	string context("hass " + string(Hass::version) + " format " + to_string(static_cast<int>(flags.romFormat)));
+
+	context += flags.optimize ? " -O" : "";
+	context += flags.removeUnreachable && !flags.object ? " -e" : "";
+	context += flags.object ? " -c" : "";
+
+	if (flags.symTable)
+		context += " -t " + outputName;
+
+	if (flags.sourceMap)
+		context += " -m " + inputName;
+
+	return context;
+}
+
+/**
+	Assembles an .asm file into a .hack (or .bin, .hbin or .hobj) file and, if requested, a -symbols
+	file and a .hackmap file.
+
+	@param inputName Name of the input file.
+
+	@param flags Flags from the command line.
+
+	@param log Stream for the verbose details.
+
+	@param err Stream for the error messages.
+
+	@return True if the file was assembled without errors. False otherwise.
+*/
+bool assembleFile(string inputName, const Flags& flags, ostream& log, ostream& err)
+{
+	if (!isAsmFile(inputName, err))
+		return false;
+
+	MappedFile inputFile;
+
+	if (!inputFile.openRead(inputName)) {
+		err << "error: unable to open input file \"" << inputName << "\"" << endl;
+		return false;
 	}
 
-	Assembler hass(inputFile, inputName, outputFile, outputName, verbose, veryVerbose);
-	hass.assemble();
+	string outputName(FileHandler::changeExtension(inputName, flags.object ? ".hobj" : RomWriter::getExtension(flags.romFormat)));
+	string symOutputName(FileHandler::changeExtension(inputName, "-symbols"));
+	string mapOutputName(FileHandler::changeExtension(inputName, ".hackmap"));
+	vector<string> outputNames { outputName };
+	string key;
+
+	if (flags.symTable)
+		outputNames.push_back(symOutputName);
+
+	if (flags.sourceMap)
+		outputNames.push_back(mapOutputName);
+
+	// the included files are part of the source, so the key is made from the preprocessed one
+
+	string_view source(inputFile.view());
+	Preprocessor preprocessor(*flags.includes);
+	bool preprocessed = Preprocessor::isNeeded(source);
+
+	if (preprocessed && !preprocess(source, inputName, preprocessor, err))
+		return false;
+
+	if (flags.cache != nullptr && !flags.verbose && !flags.jsonTrace) { // a hit has no details to print
+		string context(cacheContext(flags, inputName, outputName));
+
+		if (preprocessed && flags.sourceMap) // the map points to the lines of the input itself
+			context += " " + BuildCache::makeKey(inputFile.view(), "");
+
+		key = BuildCache::makeKey(source, context);
 
-	if (symTable) {
-		string symOutputName(FileHandler::changeExtension(inputName, "-symbols"));
+		if (flags.cache->fetch(key, outputNames))
+			return true;
+	}
+
+	Hass::Result result = Hass::assemble(source, getOptions(flags, inputName, outputName, log));
+	printDiagnostics(result, inputName, preprocessed ? &preprocessor : nullptr, err);
+
+	if (preprocessed && flags.verbose) {
+		log << "preprocessed: " << preprocessor.getFileCount() - 1 << " included files, " << preprocessor.getCallCount()
+		    << " macro calls (" << preprocessor.getMemoizedCount() << " memoized)" << endl;
+	}
+
+	if (flags.object ? !writeObject(result.object, outputName, err) : !writeRom(result.rom, outputName, flags.romFormat, err))
+		return false;
+
+	if (flags.symTable) {
 		ofstream symOutputFile(symOutputName);
 
 		if (!symOutputFile.good()) {
-			cerr << "error: unable to open output stream" << endl;
-			return 1;
+			err << "error: unable to open output stream" << endl;
+			return false;
 		}
 
-		hass.outputSymbolTable(symOutputFile);
+		Hass::outputSymbolTable(symOutputFile, result, outputName);
 		symOutputFile.close();
 
-		if (verbose)
-			cout << "symbol table output: " << symOutputName << endl;
+		if (flags.verbose)
+			log << "symbol table output: " << symOutputName << endl;
 	}
 
-	if (inputFile.is_open())
-		inputFile.close();
+	if (flags.sourceMap) {
+		SourceMap sourceMap;
+		sourceMap.build(inputFile.view(), preprocessed ? preprocessor.mainLines(result.sourceLines) : result.sourceLines, inputName);
 
-	if (outputFile.is_open())
-		outputFile.close();
+		ofstream mapOutputFile(mapOutputName, ios::binary);
+
+		if (!mapOutputFile.good()) {
+			err << "error: unable to open output file \"" << mapOutputName << "\"" << endl;
+			return false;
+		}
+
+		sourceMap.write(mapOutputFile);
+		mapOutputFile.close();
+
+		if (flags.verbose)
+			log << "source map output: " << mapOutputName << endl;
+	}
+
+	if (!key.empty() && result.ok) // programs with errors are assembled again, to report them
+		flags.cache->store(key, outputNames);
+
+	return result.ok;
+}
+
+/**
+	Expands the input arguments into a list of files. A directory stands for the .asm files
+	in it and an argument starting with @ for the files listed (one per line) in the file
+	that follows.
+
+	@param args Input arguments.
+
+	@param inputNames Vector receiving the names of the files.
+
+	@return True if all the arguments could be read. False otherwise.
+*/
+bool expandInputs(const vector<string>& args, vector<string>& inputNames)
+{
+	for (const string& arg : args) {
+		if (arg.size() > 1 && arg[0] == '@') {
+			ifstream listFile(arg.substr(1));
+
+			if (!listFile.good()) {
+				cerr << "error: unable to open file list \"" << arg.substr(1) << "\"" << endl;
+				return false;
+			}
+
+			string line;
+
+			while (getline(listFile, line))
+				if (!line.empty())
+					inputNames.push_back(line);
+		} else if (FileHandler::isDirectory(arg)) {
+			vector<string> files(FileHandler::listFiles(arg, ".asm"));
+			inputNames.insert(inputNames.end(), files.begin(), files.end());
+		} else {
+			inputNames.push_back(arg);
+		}
+	}
+
+	return true;
+}
+
+/**
+	Assembles many files concurrently, one task per file on a thread pool of flags.jobs
+	workers (one per core if -j was not given). The messages of each file are buffered and printed in the order of the inputs.
+
+	@param inputNames Names of the input files.
+
+	@param flags Flags from the command line.
+
+	@return The exit status of the assembler.
+*/
+int assembleBatch(const vector<string>& inputNames, const Flags& flags)
+{
+	size_t fileCount = inputNames.size();
+	vector<ostringstream> logs(fileCount);
+	vector<ostringstream> errors(fileCount);
+	vector<char> assembled(fileCount, false);
+
+	Flags fileFlags(flags);
+	fileFlags.jobs = 1;
+	fileFlags.context = nullptr;
+
+	{
+		ThreadPool pool(flags.jobsGiven ? flags.jobs : 0);
+
+		for (size_t i = 0; i < fileCount; i++)
+			pool.submit([&, i] {
+				assembled[i] = assembleFile(inputNames[i], fileFlags, logs[i], errors[i]);
+			});
+
+		pool.wait();
+	}
+
+	size_t failed = 0;
+
+	for (size_t i = 0; i < fileCount; i++) {
+		cout << logs[i].str();
+		cerr << errors[i].str();
+
+		if (!assembled[i])
+			failed++;
+
+		if (flags.verbose)
+			cout << inputNames[i] << ": " << (assembled[i] ? "ok" : "failed") << endl;
+	}
+
+	if (failed > 0)
+		cerr << "error: " << failed << " of " << fileCount << " files failed to assemble" << endl;
+
+	return failed > 0 ? 1 : 0;
+}
+
+/**
+	Assembles the inputs given in the command line.
+
+	@param args Input arguments.
+
+	@param flags Flags from the command line.
+
+	@return The exit status of the assembler.
+*/
+int assembleInputs(const vector<string>& args, const Flags& flags)
+{
+	if (args.size() == 1 && args[0] == "-") {
+		if (flags.verbose || flags.jsonTrace || flags.symTable || flags.sourceMap) {
+			cerr << "error: -v, -V, -J, -t and -m are not available when assembling the standard input" << endl;
+			return 1;
+		}
+
+		return assembleStdin(flags);
+	}
+
+	if (args.size() == 1 && args[0][0] != '@' && !FileHandler::isDirectory(args[0]))
+		return assembleFile(args[0], flags, cout, cerr) ? 0 : 1;
+
+	vector<string> inputNames;
+
+	if (!expandInputs(args, inputNames))
+		return 1;
+
+	if (inputNames.empty()) {
+		cerr << "error: no .asm files found" << endl;
+		return 1;
+	}
+
+	return assembleBatch(inputNames, flags);
+}
+
+/**
+	Opens the build cache of the command line: the directory given with -C or, if none, the one
+	in $HASS_CACHE. The size bound is $HASS_CACHE_SIZE megabytes (256 by default).
+
+	@param cacheDir Directory given with -C (may be empty).
+
+	@param cache Receives the cache (null if there is no cache directory).
+
+	@return True if there is no cache directory or the cache could be opened. False otherwise.
+*/
+bool openCache(string cacheDir, unique_ptr<BuildCache>& cache)
+{
+	const char* envDir = getenv("HASS_CACHE");
+	const char* envSize = getenv("HASS_CACHE_SIZE");
+
+	if (cacheDir.empty() && envDir != nullptr)
+		cacheDir = envDir;
+
+	if (cacheDir.empty())
+		return true;
+
+	uint64_t megabytes = envSize != nullptr && atoll(envSize) > 0 ? atoll(envSize) : 256;
+	cache.reset(new BuildCache(cacheDir, megabytes << 20));
+
+	if (!cache->open()) {
+		cerr << "error: unable to use cache directory \"" << cacheDir << "\"" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+	Prints the statistics of a build cache.
+
+	@param cacheDir Directory of the cache (empty: $HASS_CACHE).
+
+	@return The exit status of the assembler.
+*/
+int printCacheStats(string cacheDir)
+{
+	unique_ptr<BuildCache> cache;
+
+	if (!openCache(cacheDir, cache))
+		return 1;
+
+	if (cache == nullptr) {
+		cerr << "error: no cache directory (set HASS_CACHE or use --cache-stats=dir)" << endl;
+		return 1;
+	}
+
+	BuildCache::Stats stats = cache->loadStats();
+	size_t fileCount;
+	uint64_t size = cache->size(fileCount);
+	uint64_t lookups = stats.hits + stats.misses;
+
+	cout << "files:     " << fileCount << " (" << size << " bytes)" << endl;
+	cout << "hits:      " << stats.hits << endl;
+	cout << "misses:    " << stats.misses << endl;
+	cout << "hit rate:  " << fixed << setprecision(1) << (lookups > 0 ? 100.0 * stats.hits / lookups : 0.0) << "%" << endl;
+	cout << "stores:    " << stats.stores << endl;
+	cout << "evictions: " << stats.evictions << endl;
 
 	return 0;
 }
+
+/**
+	Runs the assembler command line.
+
+	@param argc Number of command line arguments.
+
+	@param argv Array of arguments.
+
+	@param context Warm assembler to reuse, or null.
+
+	@param includes Included files already read, or null.
+
+	@return The exit status of the assembler.
+*/
+int run(int argc, char** argv, Hass::Context* context, Preprocessor::IncludeCache* includes)
+{
+	if (argc == 1) {
+		printUsage();
+		return 1;
+	}
+
+	Preprocessor::IncludeCache ownIncludes;
+	Flags flags;
+	flags.context = context;
+	flags.includes = includes != nullptr ? includes : &ownIncludes;
+
+	if (!getFlags(argc, argv, flags))
+		return 1;
+
+	if (flags.jsonTrace) // -V only adds the fields of the C-instructions
+		flags.verbose = false;
+
+	vector<string> args(argv + optind, argv + argc);
+
+	if (args.empty()) {
+		cerr << "error: no input file" << endl;
+		return 1;
+	}
+
+	unique_ptr<BuildCache> cache;
+
+	if (!openCache(flags.cacheDir, cache))
+		return 1;
+
+	flags.cache = cache.get();
+
+	int status = assembleInputs(args, flags);
+
+	if (cache != nullptr) {
+		cache->evict();
+		cache->saveStats();
+	}
+
+	return status;
+}
+
+/**
+	Runs a command line received by the server, with the standard streams redirected to the
+	request and its response.
+
+	@param request Command line of the client.
+
+	@param response Outputs and exit status of the command.
+
+	@param context Warm assembler kept by the server.
+
+	@param includes Included files kept by the server.
+*/
+void serveRequest(const Server::Request& request, Server::Response& response, Hass::Context& context,
+                  Preprocessor::IncludeCache& includes)
+{
+	if (chdir(request.workingDir.c_str()) != 0) {
+		response.errors = "error: unable to change to directory \"" + request.workingDir + "\"\n";
+		return;
+	}
+
+	istringstream in(request.input);
+	ostringstream out, err;
+
+	streambuf* cinBuffer = cin.rdbuf(in.rdbuf());
+	streambuf* coutBuffer = cout.rdbuf(out.rdbuf());
+	streambuf* cerrBuffer = cerr.rdbuf(err.rdbuf());
+
+	vector<string> args(request.args);
+	args.insert(args.begin(), "hass");
+
+	vector<char*> argv;
+
+	for (string& arg: args)
+		argv.push_back(&arg[0]);
+
+	argv.push_back(nullptr);
+
+	optind = 0; // rescans the arguments from the start (GNU getopt)
+	response.status = run(argv.size() - 1, argv.data(), &context, &includes);
+
+	cin.rdbuf(cinBuffer);
+	cout.rdbuf(coutBuffer);
+	cerr.rdbuf(cerrBuffer);
+
+	response.output = out.str();
+	response.errors = err.str();
+}
+
+/**
+	Assembles the given input files into .hack files, or, with --serve, runs the requests of
+	hassc until interrupted.
+*/
+int main(int argc, char** argv)
+{
+	const string serveOption("--serve");
+	const string cacheStatsOption("--cache-stats");
+
+	if (argc == 2 && (string(argv[1]) == cacheStatsOption || string(argv[1]).compare(0, cacheStatsOption.size() + 1, cacheStatsOption + "=") == 0)) {
+		string cacheDir(argv[1] + cacheStatsOption.size());
+		return printCacheStats(cacheDir.empty() ? cacheDir : cacheDir.substr(1));
+	}
+
+	if (argc == 2 && (string(argv[1]) == serveOption || string(argv[1]).compare(0, serveOption.size() + 1, serveOption + "=") == 0)) {
+		string socketPath(argv[1] + serveOption.size());
+		socketPath = socketPath.empty() ? Server::defaultSocketPath() : socketPath.substr(1);
+
+		Hass::Context context;
+		Preprocessor::IncludeCache includes;
+		cout << "hass: serving on " << socketPath << endl;
+
+		return Server::serve(socketPath, [&context, &includes](const Server::Request& request, Server::Response& response) {
+			serveRequest(request, response, context, includes);
+		}) ? 0 : 1;
+	}
+
+	return run(argc, argv, nullptr, nullptr);
+}
@@ -1,254 +1,1040 @@
 #include "Assembler.h"
+#include <algorithm>
 #include <iomanip>
 #include <bitset>
+#include <thread>
+#include <unordered_map>
 
-Assembler::Assembler(istream& inputStream, string inputName, ostream& outputStream, string outputName,
-	                 bool verbose, bool veryVerbose)
+namespace {
 
-	: inputStream(inputStream),
-	  outputStream(outputStream),
+	const size_t minChunkSize = 65536; // bytes of source per thread of assembleParallel()
+
+	const char* const commandTypeNames[] = { "A_COMMAND", "C_COMMAND", "L_COMMAND" };
+
+	/**
+		Appends a number in lowercase hexadecimal, padded with zeros to a minimum width.
+	*/
+	void appendHex(string& text, unsigned int value, size_t width)
+	{
+		char digits[8];
+		size_t count = 0;
+
+		do {
+			digits[count++] = "0123456789abcdef"[value & 0xf];
+			value >>= 4;
+		} while (value != 0);
+
+		if (count < width)
+			text.append(width - count, '0');
+
+		while (count > 0)
+			text += digits[--count];
+	}
+
+	/**
+		Appends a number in decimal.
+	*/
+	void appendDecimal(string& text, unsigned int value)
+	{
+		char digits[10];
+		size_t count = 0;
+
+		do {
+			digits[count++] = '0' + value % 10;
+			value /= 10;
+		} while (value != 0);
+
+		while (count > 0)
+			text += digits[--count];
+	}
+
+	/**
+		Appends a word as 16 binary digits.
+	*/
+	void appendBinary(string& text, uint16_t word)
+	{
+		for (int bit = 15; bit >= 0; bit--)
+			text += '0' + (word >> bit & 1);
+	}
+
+	/**
+		Appends a JSON string field ("name":"value"), with the value escaped.
+	*/
+	void appendJsonField(string& text, const char* name, string_view value)
+	{
+		text += ",\"";
+		text += name;
+		text += "\":\"";
+
+		for (char c: value) {
+			if (c == '"' || c == '\\') {
+				text += '\\';
+				text += c;
+			} else if (static_cast<unsigned char>(c) < 0x20) {
+				text += "\\u00";
+				appendHex(text, static_cast<unsigned char>(c), 2);
+			} else {
+				text += c;
+			}
+		}
+
+		text += '"';
+	}
+
+}
+
+template<class SymbolPolicy>
+BasicAssembler<SymbolPolicy>::BasicAssembler(istream& inputStream, string inputName, ostream& outputStream, string outputName,
+	                                         bool verbose, bool veryVerbose)
+
+	: outputStream(&outputStream),
+	  logStream(&cout),
+	  errorStream(&cerr),
+	  traceStream(nullptr),
 	  inputName(inputName),
 	  outputName(outputName),
 	  parser(inputStream),
 	  verbose(verbose),
 	  veryVerbose(veryVerbose),
+	  romFormat(RomFormat::HACK),
+	  traceFormat(TraceFormat::COLUMNS),
+	  recordLines(false),
+	  errorCount(0),
+	  predefinedCount(0),
+	  predefinedMark(),
+	  variableAddress(16),
+	  cmdCount(1),
+	  assemblerTitle("hass"),
+	  assemblerSubtitle(SymbolPolicy::subtitle),
+	  assemblerVersion(version)
+{
+	mapPredefinedSymbols();
+}
+
+template<class SymbolPolicy>
+BasicAssembler<SymbolPolicy>::BasicAssembler(string_view source, string inputName, string outputName,
+	                                         bool verbose, bool veryVerbose)
+
+	: outputStream(nullptr),
+	  logStream(&cout),
+	  errorStream(&cerr),
+	  traceStream(nullptr),
+	  inputName(inputName),
+	  outputName(outputName),
+	  parser(source),
+	  verbose(verbose),
+	  veryVerbose(veryVerbose),
+	  romFormat(RomFormat::HACK),
+	  traceFormat(TraceFormat::COLUMNS),
+	  recordLines(false),
+	  errorCount(0),
+	  predefinedCount(0),
+	  predefinedMark(),
+	  variableAddress(16),
+	  cmdCount(1),
 	  assemblerTitle("hass"),
-	  assemblerSubtitle("hack assembler (nand2tetris, chap. 6)"),
-	  assemblerVersion("0.3")
+	  assemblerSubtitle(SymbolPolicy::subtitle),
+	  assemblerVersion(version)
 {
 	mapPredefinedSymbols();
 }
 
-void Assembler::assemble()
+template<class SymbolPolicy>
+bool BasicAssembler<SymbolPolicy>::assemble()
 {
 	assembleFirstPass();
 	assembleSecondPass();
-	if (verbose) cout << "done" << endl << endl;
+	if (verbose) *logStream << "done" << endl << endl;
+	return errorCount == 0;
 }
 
-void Assembler::assembleFirstPass()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::assembleFirstPass()
 {
 	if (verbose) printHeader();
-	firstPass();
+	if constexpr (SymbolPolicy::hasSymbols) firstPass();
 }
 
-void Assembler::assembleSecondPass()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::assembleSecondPass()
 {
 	if (verbose) printCmdHeader();
 	parser.reset();
 	secondPass();
+
+	if (outputStream != nullptr)
+		RomWriter::write(*outputStream, rom, romFormat);
+}
+
+template<class SymbolPolicy>
+bool BasicAssembler<SymbolPolicy>::assembleSinglePass()
+{
+	if (verbose) {
+		printHeader();
+		printCmdHeader();
+	}
+
+	singlePass();
+	resolveFixups();
+
+	if (outputStream != nullptr)
+		RomWriter::write(*outputStream, rom, romFormat);
+
+	if (verbose) *logStream << "done" << endl << endl;
+	return errorCount == 0;
 }
 
-void Assembler::outputSymbolTable(ostream& symOutputStream)
+template<class SymbolPolicy>
+bool BasicAssembler<SymbolPolicy>::assembleParallel(unsigned int threadCount)
 {
-	if (!predefinedMap.empty()) { // if there are predefined symbols, print them
-		symOutputStream << "**** predefined symbols:" << endl << endl;
+	if (threadCount == 0)
+		threadCount = max(thread::hardware_concurrency(), 1u);
+
+	string_view source = parser.getSource();
+	size_t chunkCount = min<size_t>(threadCount, source.size() / minChunkSize);
 
-		for (auto& it: predefinedMap)
-			symOutputStream << "0x" << setfill('0') << setw(4) << setbase(16) << it.second << " " << it.first << endl;
+	if (verbose || chunkCount <= 1 || source.find("/*") != string_view::npos)
+		return assemble();
 
-		symOutputStream << endl;
+	vector<Chunk> chunks = splitChunks(chunkCount);
+	vector<thread> threads;
+
+	// first pass: labels
+
+	for (auto& chunk: chunks)
+		threads.emplace_back([this, &chunk] { firstPassChunk(chunk); });
+
+	for (auto& t: threads)
+		t.join();
+
+	size_t romSize = 0;
+	int linePos = 1;
+
+	for (auto& chunk: chunks) {
+		chunk.romOffset = romSize;
+		chunk.linePos = linePos;
+		romSize += chunk.instructionCount;
+		linePos += chunk.lineCount;
+
+		if constexpr (SymbolPolicy::hasSymbols)
+			for (auto& label: chunk.labels)
+				symbolTable.addEntry(label.first, chunk.romOffset + label.second);
+	}
+
+	// second pass: code
+
+	rom.assign(romSize, 0);
+	sourceLines.assign(recordLines ? romSize : 0, 0);
+	fixups.clear();
+	threads.clear();
+
+	for (auto& chunk: chunks)
+		threads.emplace_back([this, &chunk] { secondPassChunk(chunk); });
+
+	for (auto& t: threads)
+		t.join();
+
+	for (auto& chunk: chunks) {
+		for (auto& error: chunk.errors)
+			reportError(chunk.linePos + error.first - 1, error.second);
+
+		fixups.insert(fixups.end(), chunk.fixups.begin(), chunk.fixups.end());
 	}
 
-	map<string, int> table = symbolTable.getTable();
-	symOutputStream << "**** " << outputName << " symbols:" << endl << endl;
+	resolveFixups();
+
+	if (outputStream != nullptr)
+		RomWriter::write(*outputStream, rom, romFormat);
+
+	return errorCount == 0;
+}
+
+template<class SymbolPolicy>
+bool BasicAssembler<SymbolPolicy>::assembleOptimized(unsigned int passes)
+{
+	if constexpr (!SymbolPolicy::hasSymbols) {
+		return assemble();
+	} else {
+		if (verbose) printHeader();
+
+		vector<Instruction> program = decode();
+		size_t wordsBefore = count_if(program.begin(), program.end(),
+		                              [](const Instruction& i) { return i.type != HasmCommandType::L_COMMAND; });
 
-	for (auto& it: table) {
-		if (predefinedMap.find(it.first) != predefinedMap.end())
-			continue;
+		Optimizer optimizer(program);
+		optimizer.optimize(passes);
+		optimizationReport = optimizer.getReport();
 
-		symOutputStream << "0x" << setfill('0') << setw(4) << setbase(16) << it.second << " " << it.first << endl;
+		layout(program);
+
+		if (verbose && optimizer.isPeepholeSkipped()) printPeepholeSkipped();
+		if (verbose) printOptimizationReport(wordsBefore);
+
+		if (outputStream != nullptr)
+			RomWriter::write(*outputStream, rom, romFormat);
+
+		if (verbose) *logStream << "done" << endl << endl;
+		return errorCount == 0;
 	}
 }
 
-void Assembler::setVerbose(bool verbose)
+template<class SymbolPolicy>
+bool BasicAssembler<SymbolPolicy>::assembleObject(unsigned int passes)
+{
+	if constexpr (!SymbolPolicy::hasSymbols) { // no labels: the words are the whole object
+		ostream* romStream = outputStream;
+		outputStream = nullptr;
+
+		bool assembled = assemble();
+
+		outputStream = romStream;
+		object = ObjectFile();
+		object.words = rom;
+
+		if (outputStream != nullptr)
+			object.write(*outputStream);
+
+		return assembled;
+	} else {
+		if (verbose) printHeader();
+
+		vector<Instruction> program = decode();
+
+		if (passes & Optimizer::PEEPHOLE) {
+			Optimizer optimizer(program);
+			optimizer.optimize(Optimizer::PEEPHOLE);
+			optimizationReport = optimizer.getReport();
+
+			if (verbose && optimizer.isPeepholeSkipped()) printPeepholeSkipped();
+		}
+
+		layoutObject(program);
+
+		if (verbose) {
+			*logStream << "object: " << object.words.size() << " words, " << object.exports.size() << " exported labels, ";
+			*logStream << object.relocations.size() << " relocations, " << object.variables.size() << " external symbols";
+			*logStream << endl << endl;
+		}
+
+		if (outputStream != nullptr)
+			object.write(*outputStream);
+
+		if (verbose) *logStream << "done" << endl << endl;
+		return errorCount == 0;
+	}
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::reset(string_view source, string inputName, string outputName)
+{
+	this->inputName = inputName;
+	this->outputName = outputName;
+	parser.setSource(source);
+
+	rom.clear();
+	fixups.clear();
+	diagnostics.clear();
+	optimizationReport.clear();
+	sourceLines.clear();
+	object = ObjectFile();
+
+	if constexpr (SymbolPolicy::hasSymbols)
+		symbolTable.rewind(predefinedMark);
+
+	errorCount = 0;
+	variableAddress = 16;
+	cmdCount = 1;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::setVerbose(bool verbose)
 {
 	this->verbose = verbose;
 }
 
-bool Assembler::isVerbose()
+template<class SymbolPolicy>
+bool BasicAssembler<SymbolPolicy>::isVerbose()
 {
 	return verbose;
 }
 
-void Assembler::setVeryVerbose(bool veryVerbose)
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::setVeryVerbose(bool veryVerbose)
 {
 	this->veryVerbose = veryVerbose;
 	if (veryVerbose)
 		verbose = true;
 }
 
-bool Assembler::isVeryVerbose()
+template<class SymbolPolicy>
+bool BasicAssembler<SymbolPolicy>::isVeryVerbose()
 {
 	return veryVerbose;
 }
 
-void Assembler::firstPass()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::setRomFormat(RomFormat romFormat)
+{
+	this->romFormat = romFormat;
+}
+
+template<class SymbolPolicy>
+RomFormat BasicAssembler<SymbolPolicy>::getRomFormat()
+{
+	return romFormat;
+}
+
+template<class SymbolPolicy>
+const vector<uint16_t>& BasicAssembler<SymbolPolicy>::getRom()
+{
+	return rom;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::setLogStream(ostream& logStream)
+{
+	this->logStream = &logStream;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::setTraceStream(ostream* traceStream, TraceFormat traceFormat)
+{
+	this->traceStream = traceStream;
+	this->traceFormat = traceFormat;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::setErrorStream(ostream* errorStream)
+{
+	this->errorStream = errorStream;
+}
+
+template<class SymbolPolicy>
+const vector<typename BasicAssembler<SymbolPolicy>::Diagnostic>& BasicAssembler<SymbolPolicy>::getDiagnostics()
+{
+	return diagnostics;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::setSourceLines(bool sourceLines)
+{
+	recordLines = sourceLines;
+}
+
+template<class SymbolPolicy>
+const vector<int>& BasicAssembler<SymbolPolicy>::getSourceLines()
+{
+	return sourceLines;
+}
+
+template<class SymbolPolicy>
+const typename SymbolPolicy::Table& BasicAssembler<SymbolPolicy>::getSymbolTable()
+{
+	return symbolTable;
+}
+
+template<class SymbolPolicy>
+const vector<Optimizer::Pattern>& BasicAssembler<SymbolPolicy>::getOptimizationReport()
+{
+	return optimizationReport;
+}
+
+template<class SymbolPolicy>
+const ObjectFile& BasicAssembler<SymbolPolicy>::getObject()
 {
-	int num = 0;
-	bool symAdded = false;
-	string symbol;
+	return object;
+}
+
+template<class SymbolPolicy>
+size_t BasicAssembler<SymbolPolicy>::getPredefinedCount()
+{
+	return predefinedCount;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::firstPass()
+{
+	if constexpr (SymbolPolicy::hasSymbols) { // only labels are collected
+		int num = 0;
+		bool symAdded = false;
+		string_view symbol;
+
+		while (parser.advance()) {
+
+			switch (parser.commandType()) {
+
+				case HasmCommandType::L_COMMAND:
+					symbol = parser.symbol();
+					symbolTable.addEntry(symbol, num);
+
+					if (verbose) {
+						if (!symAdded) {
+							*logStream << "symbols from first pass:" << endl;
+							symAdded = true;
+						}
+
+						*logStream << setfill('0');
+						*logStream << symbol << " mapped to address 0x" << setw(4) << setbase(16) << num << endl;
+						*logStream << setfill(' ');
+					}
+
+					break;
+
+				default:
+					num++;
+
+			}
+		}
+
+		if (verbose && symAdded) *logStream << endl;
+	}
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::secondPass()
+{
+	rom.clear();
+	sourceLines.clear();
 
 	while (parser.advance()) {
 
 		switch (parser.commandType()) {
 
+			case HasmCommandType::A_COMMAND:
+				assembleACommand();
+				break;
+
+			case HasmCommandType::C_COMMAND:
+				assembleCCommand();
+				break;
+
 			case HasmCommandType::L_COMMAND:
+				if (verbose) printCmdDetails();
+				continue;
+
+		}
+
+		if (recordLines) sourceLines.push_back(parser.getLinePos());
+		if (verbose) printCmdDetails();
+
+	}
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::singlePass()
+{
+	string_view symbol;
+	int val;
+
+	rom.clear();
+	fixups.clear();
+	sourceLines.clear();
+
+	while (parser.advance()) {
+
+		switch (parser.commandType()) {
+
+			case HasmCommandType::A_COMMAND:
 				symbol = parser.symbol();
-				symbolTable.addEntry(symbol, num);
 
-				if (verbose) {
-					if (!symAdded) {
-						cout << "symbols from first pass:" << endl;
-						symAdded = true;
+				if (!SymbolPolicy::hasSymbols || symbol.empty() || isdigit(symbol.front())) {
+					val = toConstant(symbol);
+				} else if constexpr (SymbolPolicy::hasSymbols) {
+					if ((val = symbolTable.getAddress(symbol)) < 0) {
+						// label defined further on or variable: patched by resolveFixups()
+						fixups.push_back(Fixup(rom.size(), symbol));
+						val = 0;
 					}
-
-					cout << setfill('0');
-					cout << symbol << " mapped to address 0x" << setw(4) << setbase(16) << num << endl;
-					cout << setfill(' ');
 				}
 
+				rom.push_back(val);
+				break;
+
+			case HasmCommandType::C_COMMAND:
+				rom.push_back(encodeCCommand());
 				break;
 
-			default:
-				num++;
+			case HasmCommandType::L_COMMAND:
+				if constexpr (SymbolPolicy::hasSymbols)
+					symbolTable.addEntry(parser.symbol(), rom.size());
+
+				if (verbose) printCmdDetails();
+				continue;
+
+		}
+
+		if (recordLines) sourceLines.push_back(parser.getLinePos());
+		if (verbose) printCmdDetails();
+
+	}
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::resolveFixups()
+{
+	if constexpr (SymbolPolicy::hasSymbols) { // the symbol-less assembler has no fixups
+		if (verbose && !fixups.empty()) *logStream << endl << "fixups from single pass:" << endl;
+
+		for (auto& fixup: fixups) {
+			bool inserted;
+			rom[fixup.index] = symbolTable.findOrInsert(fixup.symbol, variableAddress, inserted);
+
+			if (inserted)
+				variableAddress++;
+
+			if (verbose) {
+				*logStream << setfill('0') << right;
+				*logStream << setw(4) << setbase(16) << fixup.index << " " << fixup.symbol;
+				*logStream << " patched with address 0x" << setw(4) << setbase(16) << rom[fixup.index] << endl;
+				*logStream << setfill(' ');
+			}
+		}
+
+		if (verbose && !fixups.empty()) *logStream << endl;
+	}
+}
+
+template<class SymbolPolicy>
+vector<typename BasicAssembler<SymbolPolicy>::Chunk> BasicAssembler<SymbolPolicy>::splitChunks(size_t chunkCount)
+{
+	string_view source = parser.getSource();
+	vector<Chunk> chunks;
+	size_t start = 0;
+
+	for (size_t i = 1; i <= chunkCount && start < source.size(); i++) {
+		size_t end = source.size();
 
+		if (i < chunkCount) {
+			end = source.find('\n', max(start, source.size() / chunkCount * i));
+			end = end == string_view::npos ? source.size() : end + 1;
 		}
+
+		chunks.push_back(Chunk(source.substr(start, end - start)));
+		start = end;
+	}
+
+	return chunks;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::firstPassChunk(Chunk& chunk) const
+{
+	Parser chunkParser(chunk.source);
+	size_t num = 0;
+
+	while (chunkParser.advance()) {
+		if (chunkParser.commandType() == HasmCommandType::L_COMMAND)
+			chunk.labels.push_back(make_pair(chunkParser.symbol(), num));
+		else
+			num++;
 	}
 
-	if (verbose && symAdded) cout << endl;
+	chunk.instructionCount = num;
+	chunk.lineCount = chunkParser.getLinePos() - 1;
 }
 
-void Assembler::secondPass()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::secondPassChunk(Chunk& chunk)
 {
+	Parser chunkParser(chunk.source);
+	size_t index = chunk.romOffset;
+	string_view symbol;
+	int val = 0;
+
+	while (chunkParser.advance()) {
+
+		switch (chunkParser.commandType()) {
+
+			case HasmCommandType::A_COMMAND:
+				symbol = chunkParser.symbol();
+
+				if (!SymbolPolicy::hasSymbols || symbol.empty() || isdigit(symbol.front())) {
+					val = parseConstant(symbol);
+				} else if constexpr (SymbolPolicy::hasSymbols) {
+					if ((val = symbolTable.getAddress(symbol)) < 0) {
+						chunk.fixups.push_back(Fixup(index, symbol));
+						val = 0;
+					}
+				}
+
+				break;
+
+			case HasmCommandType::C_COMMAND:
+				val = code.cCommand(chunkParser.getCommand());
+				break;
+
+			case HasmCommandType::L_COMMAND:
+				continue;
+
+		}
+
+		if (val < 0) {
+			chunk.errors.push_back(make_pair(chunkParser.getLinePos(), chunkParser.getCommand()));
+			val = 0;
+		}
+
+		if (recordLines)
+			sourceLines[index] = chunk.linePos + chunkParser.getLinePos() - 1;
+
+		rom[index++] = val;
+	}
+}
+
+template<class SymbolPolicy>
+vector<Instruction> BasicAssembler<SymbolPolicy>::decode()
+{
+	vector<Instruction> program;
+	string_view symbol;
+	int val = 0;
+
+	parser.reset();
+
 	while (parser.advance()) {
 
 		switch (parser.commandType()) {
 
 			case HasmCommandType::A_COMMAND:
-				assembleACommand();
+				symbol = parser.symbol();
+
+				if (symbol.empty() || isdigit(symbol.front())) {
+					val = toConstant(symbol);
+					symbol = string_view();
+				} else if constexpr (SymbolPolicy::hasSymbols) {
+					// only the predefined symbols are in the table yet
+					if ((val = symbolTable.getAddress(symbol)) >= 0)
+						symbol = string_view();
+					else
+						val = 0;
+				}
+
+				program.push_back(Instruction::aCommand(val, symbol, parser.getLinePos()));
 				break;
 
 			case HasmCommandType::C_COMMAND:
-				assembleCCommand();
+				program.push_back(Instruction::cCommand(encodeCCommand(), parser.getLinePos()));
 				break;
 
 			case HasmCommandType::L_COMMAND:
+				program.push_back(Instruction::label(parser.symbol(), parser.getLinePos()));
 				break;
 
 		}
+	}
 
-		if (verbose) printCmdDetails();
+	return program;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::layout(const vector<Instruction>& program)
+{
+	if constexpr (SymbolPolicy::hasSymbols) { // only the symbolic assembler optimizes
+		size_t address = 0;
+
+		for (auto& instruction: program) {
+			if (instruction.type == HasmCommandType::L_COMMAND)
+				symbolTable.addEntry(instruction.symbol, address);
+			else
+				address++;
+		}
 
+		rom.clear();
+		sourceLines.clear();
+
+		for (auto& instruction: program) {
+			if (instruction.type == HasmCommandType::L_COMMAND)
+				continue;
+
+			uint16_t word = instruction.word;
+
+			if (!instruction.symbol.empty()) {
+				bool inserted;
+				word = symbolTable.findOrInsert(instruction.symbol, variableAddress, inserted);
+
+				if (inserted)
+					variableAddress++;
+			}
+
+			rom.push_back(word);
+			if (recordLines) sourceLines.push_back(instruction.linePos);
+		}
 	}
 }
 
-void Assembler::assembleACommand()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::layoutObject(const vector<Instruction>& program)
 {
-	static int RAMadr = 16;
-	string symbol = parser.symbol();
-	int val;
+	if constexpr (SymbolPolicy::hasSymbols) { // the symbol-less assembler has no labels to relocate
+		object = ObjectFile();
+		uint32_t address = 0;
+
+		for (auto& instruction: program) {
+			if (instruction.type == HasmCommandType::L_COMMAND) {
+				bool inserted;
+				symbolTable.findOrInsert(instruction.symbol, address, inserted);
+
+				if (inserted) // the first definition is the one used
+					object.exports.push_back(ObjectFile::Export { string(instruction.symbol), address });
+			} else {
+				address++;
+			}
+		}
 
-	if (isdigit(symbol.front())) {
+		unordered_map<string_view, uint32_t> externals; // symbol -> index in object.variables
+		rom.clear();
+		sourceLines.clear();
 
-		val = stoi(parser.symbol());
+		for (auto& instruction: program) {
+			if (instruction.type == HasmCommandType::L_COMMAND)
+				continue;
 
-	} else {
+			uint16_t word = instruction.word;
+
+			if (!instruction.symbol.empty()) {
+				int address = symbolTable.getAddress(instruction.symbol);
+
+				if (address >= 0) { // a label of the module (predefined symbols were decoded)
+					word = address;
+					object.relocations.push_back(rom.size());
+				} else {
+					auto external = externals.emplace(instruction.symbol, object.variables.size());
 
-		if (symbolTable.contains(symbol)) {
-			val = symbolTable.getAddress(symbol);
-		} else {
-			symbolTable.addEntry(symbol, RAMadr);
-			val = RAMadr++;
+					if (external.second)
+						object.variables.push_back(string(instruction.symbol));
+
+					object.references.push_back(ObjectFile::Reference { uint32_t(rom.size()), external.first->second });
+					word = 0;
+				}
+			}
+
+			rom.push_back(word);
+			if (recordLines) sourceLines.push_back(instruction.linePos);
 		}
 
+		object.words = rom;
 	}
+}
 
-	bin = bitset< 16 >(val).to_string();
-	outputStream << bin << endl;
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::printPeepholeSkipped()
+{
+	*logStream << "peephole optimizer skipped: the program jumps to constant ROM addresses" << endl << endl;
 }
 
-void Assembler::assembleCCommand()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::printOptimizationReport(size_t wordsBefore)
 {
-	string dest = parser.dest();
-	string comp = parser.comp();
-	string jump = parser.jump();
-	unsigned int cc = 0; // c_command
+	*logStream << "optimizations:" << endl;
+
+	for (auto& pattern: optimizationReport) {
+		*logStream << setfill(' ') << setbase(10) << left << setw(30) << pattern.name << right;
+		*logStream << setw(8) << pattern.count << setw(8) << pattern.wordsSaved << " words saved" << endl;
+	}
 
-	cc = code.dest(dest);
-	cc |= code.comp(comp);
-	cc |= code.jump(jump);
-	cc |= 0b1110000000000000;
+	size_t saved = wordsBefore - rom.size();
 
-	bin = bitset< 16 >(cc).to_string();
-	outputStream << bin << endl;
+	*logStream << "words: " << wordsBefore << " -> " << rom.size() << " (" << saved << " saved, ";
+	*logStream << fixed << setprecision(1) << (wordsBefore > 0 ? 100.0 * saved / wordsBefore : 0.0) << "%)" << endl << endl;
+	*logStream << defaultfloat;
 }
 
-void Assembler::printHeader()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::assembleACommand()
 {
-	cout << assemblerTitle << " - " << assemblerSubtitle << " v" << assemblerVersion << endl;
-	cout << "input: " << inputName << endl;
-	cout << "output: " << outputName << endl << endl;
+	string_view symbol = parser.symbol();
+	int val;
+
+	if (!SymbolPolicy::hasSymbols || symbol.empty() || isdigit(symbol.front())) {
+
+		val = toConstant(symbol);
+
+	} else if constexpr (SymbolPolicy::hasSymbols) {
+
+		bool inserted;
+		val = symbolTable.findOrInsert(symbol, variableAddress, inserted);
+
+		if (inserted)
+			variableAddress++;
+
+	}
+
+	rom.push_back(val);
 }
 
-void Assembler::printCmdHeader()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::assembleCCommand()
 {
-	cout << "#num  #pos  cmd" << setw(29) << "type       bin" << endl;
+	rom.push_back(encodeCCommand());
 }
 
-void Assembler::printCmdDetails()
+template<class SymbolPolicy>
+unsigned int BasicAssembler<SymbolPolicy>::encodeCCommand()
 {
-	static int count = 1;
-	cout << setfill('0');
-	cout << setw(4) << right << setbase(16) << count++ << " ";
-	cout << "[" << setw(4) << setbase(16) << parser.getLinePos() << "] ";
-	cout << setfill(' ');
-	cout << setw(18) << left << parser.getCommand();
+	int cc = code.cCommand(parser.getCommand());
 
-	switch (parser.commandType()) {
+	if (cc < 0) {
+		reportError(parser.getLinePos(), parser.getCommand());
+		return 0;
+	}
+
+	return cc;
+}
 
-		case HasmCommandType::A_COMMAND:
-			cout << "A_COMMAND  ";
-			cout << bin << endl;
-			break;
+template<class SymbolPolicy>
+int BasicAssembler<SymbolPolicy>::toConstant(string_view digits)
+{
+	int val = parseConstant(digits);
 
-		case HasmCommandType::L_COMMAND:
-			cout << "L_COMMAND  " << endl;
-			break;
+	if (val < 0) {
+		reportError(parser.getLinePos(), parser.getCommand());
+		return 0;
+	}
 
-		case HasmCommandType::C_COMMAND:
-			cout << "C_COMMAND  " << bin;
+	return val;
+}
 
-			if (veryVerbose) {
-				string dest = parser.dest();
-				string comp = parser.comp();
-				string jump = parser.jump();
-			 	cout << " ";
-				if (!dest.empty()) cout << "dest: " << dest << " ";
-				if (!comp.empty()) cout << "comp: " << comp << " ";
-				if (!jump.empty()) cout << "jump: " << jump;
-			}
+template<class SymbolPolicy>
+int BasicAssembler<SymbolPolicy>::parseConstant(string_view digits)
+{
+	if (digits.size() > 8) { // only leading zeros can make a valid constant this long
+		digits.remove_prefix(min(digits.find_first_not_of('0'), digits.size() - 1));
 
-			cout << endl;
+		if (digits.size() > 8)
+			return -1;
 	}
+
+	// the digits, right aligned and padded with '0', as the bytes of a word (first byte lowest)
+
+	uint64_t word = 0x3030303030303030;
+
+	for (char c: digits)
+		word = (word >> 8) | (uint64_t(uint8_t(c)) << 56);
+
+	// every byte is a digit if its high nibble is 3, and still is after adding 6
+
+	bool valid = ((word & 0xf0f0f0f0f0f0f0f0) | (((word + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4))
+	             == 0x3333333333333333;
+
+	// sums the digits pairwise: 8 digits, 4 pairs, 2 quads, 1 value
+
+	word -= 0x3030303030303030;
+	word = word * 10 + (word >> 8);
+	word = ((word & 0x000000ff000000ff) * (100 + (1000000ull << 32))
+	        + ((word >> 16) & 0x000000ff000000ff) * (1 + (10000ull << 32))) >> 32;
+
+	uint32_t val = word;
+
+	return (valid & !digits.empty() & (val <= 32767)) ? int(val) : -1;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::reportError(int linePos, string_view command)
+{
+	string message;
+
+	if (command.front() == '@')
+		message = "invalid constant \"" + string(command.substr(1)) + "\" (must be a decimal number from 0 to 32767)";
+	else
+		message = "illegal C-instruction \"" + string(command) + "\"";
+
+	if (errorStream != nullptr)
+		*errorStream << "error: " << inputName << ":" << linePos << ": " << message << endl;
+
+	diagnostics.push_back(Diagnostic(linePos, message));
+	errorCount++;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::printHeader()
+{
+	*logStream << assemblerTitle << " - " << assemblerSubtitle << " v" << assemblerVersion << endl;
+	*logStream << "input: " << inputName << endl;
+	*logStream << "output: " << outputName << endl << endl;
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::printCmdHeader()
+{
+	*logStream << "#num  #pos  cmd" << setw(29) << "type       bin" << endl;
 }
 
-void Assembler::mapPredefinedSymbols()
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::printCmdDetails()
 {
-	predefinedMap.insert(pair<string, int>("SP",   0x0000));
-	predefinedMap.insert(pair<string, int>("LCL",  0x0001));
-	predefinedMap.insert(pair<string, int>("ARG",  0x0002));
-	predefinedMap.insert(pair<string, int>("THIS", 0x0003));
-	predefinedMap.insert(pair<string, int>("THAT", 0x0004));
+	HasmCommandType type = parser.commandType();
+	string_view command = parser.getCommand();
+	string& record = traceRecord;
+
+	record.clear();
+
+	if (traceFormat == TraceFormat::JSONL) {
+		record += "{\"num\":";
+		appendDecimal(record, cmdCount++);
+		record += ",\"line\":";
+		appendDecimal(record, parser.getLinePos());
+		appendJsonField(record, "cmd", command);
+		appendJsonField(record, "type", commandTypeNames[static_cast<int>(type)]);
+
+		if (type != HasmCommandType::L_COMMAND) {
+			record += ",\"word\":";
+			appendDecimal(record, rom.back());
+		}
+
+		if (type == HasmCommandType::C_COMMAND && veryVerbose) {
+			if (!parser.dest().empty()) appendJsonField(record, "dest", parser.dest());
+			if (!parser.comp().empty()) appendJsonField(record, "comp", parser.comp());
+			if (!parser.jump().empty()) appendJsonField(record, "jump", parser.jump());
+		}
+
+		record += "}\n";
+	} else {
+		appendHex(record, cmdCount++, 4);
+		record += " [";
+		appendHex(record, parser.getLinePos(), 4);
+		record += "] ";
+		record += command;
+
+		if (command.size() < 18)
+			record.append(18 - command.size(), ' ');
 
-	for (int i = 0; i < 16; i++) {
-		string reg("R");
-		reg.append(to_string(i));
-		predefinedMap.insert(pair<string, int>(reg, i));
+		record += commandTypeNames[static_cast<int>(type)];
+		record += "  ";
+
+		if (type != HasmCommandType::L_COMMAND)
+			appendBinary(record, rom.back());
+
+		if (type == HasmCommandType::C_COMMAND && veryVerbose) {
+			record += ' ';
+			if (!parser.dest().empty()) { record += "dest: "; record += parser.dest(); record += ' '; }
+			if (!parser.comp().empty()) { record += "comp: "; record += parser.comp(); record += ' '; }
+			if (!parser.jump().empty()) { record += "jump: "; record += parser.jump(); }
+		}
+
+		record += '\n';
 	}
 
-	predefinedMap.insert(pair<string, int>("SCREEN", 0x4000));
-	predefinedMap.insert(pair<string, int>("KBD",    0x6000));
+	(traceStream != nullptr ? traceStream : logStream)->write(record.data(), record.size());
+}
+
+template<class SymbolPolicy>
+void BasicAssembler<SymbolPolicy>::mapPredefinedSymbols()
+{
+	if constexpr (SymbolPolicy::hasSymbols) { // the symbol-less assembler has no symbol table
+		static const SymbolTable::Entry predefinedSymbols[] = {
+			{ "SP",   0x0000 }, { "LCL",  0x0001 }, { "ARG",  0x0002 }, { "THIS", 0x0003 }, { "THAT", 0x0004 },
+			{ "R0",   0x0000 }, { "R1",   0x0001 }, { "R2",   0x0002 }, { "R3",   0x0003 },
+			{ "R4",   0x0004 }, { "R5",   0x0005 }, { "R6",   0x0006 }, { "R7",   0x0007 },
+			{ "R8",   0x0008 }, { "R9",   0x0009 }, { "R10",  0x000a }, { "R11",  0x000b },
+			{ "R12",  0x000c }, { "R13",  0x000d }, { "R14",  0x000e }, { "R15",  0x000f },
+			{ "SCREEN", 0x4000 }, { "KBD", 0x6000 }
+		};
+
+		for (auto& entry: predefinedSymbols)
+			symbolTable.addEntry(entry.symbol, entry.address);
 
-	symbolTable.loadMap(predefinedMap);
+		predefinedCount = symbolTable.size();
+		predefinedMark = symbolTable.getMark();
+	}
 }
+
+template class BasicAssembler<Symbolic>;
+template class BasicAssembler<SymbolLess>;
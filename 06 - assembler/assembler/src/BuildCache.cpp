@@ -0,0 +1,247 @@
+#include "BuildCache.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+namespace {
+
+	const char* const statsName = "stats";
+
+	const char* const tempPrefix = "tmp-";
+
+	/**
+		Parses the lines "name value" of a stats file into the counters.
+	*/
+	BuildCache::Stats parseStats(const string& text)
+	{
+		BuildCache::Stats stats;
+		istringstream lines(text);
+		string name;
+		uint64_t value;
+
+		while (lines >> name >> value) {
+			if (name == "hits") stats.hits = value;
+			else if (name == "misses") stats.misses = value;
+			else if (name == "stores") stats.stores = value;
+			else if (name == "evictions") stats.evictions = value;
+		}
+
+		return stats;
+	}
+
+}
+
+BuildCache::BuildCache(string dirName, uint64_t maxSize)
+	: dirName(dirName), maxSize(maxSize), hits(0), misses(0), stores(0), evictions(0)
+{
+}
+
+bool BuildCache::open()
+{
+	struct stat info;
+
+	if (mkdir(dirName.c_str(), 0777) != 0 && errno != EEXIST)
+		return false;
+
+	return stat(dirName.c_str(), &info) == 0 && S_ISDIR(info.st_mode) && access(dirName.c_str(), R_OK | W_OK | X_OK) == 0;
+}
+
+string BuildCache::makeKey(string_view source, string context)
+{
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(Hash::xxh64(source, Hash::xxh64(context))));
+	return key;
+}
+
+bool BuildCache::fetch(string key, const vector<string>& outputNames)
+{
+	for (size_t i = 0; i < outputNames.size(); i++) {
+		if (!cloneFile(entryPath(key, i), outputNames[i])) {
+			misses++;
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < outputNames.size(); i++)
+		utimensat(AT_FDCWD, entryPath(key, i).c_str(), nullptr, 0); // now: most recently used
+
+	hits++;
+	return true;
+}
+
+void BuildCache::store(string key, const vector<string>& outputNames)
+{
+	for (size_t i = 0; i < outputNames.size(); i++) {
+		string tempName(dirName + "/" + tempPrefix + "XXXXXX");
+		int fd = mkstemp(&tempName[0]);
+
+		if (fd < 0)
+			return;
+
+		close(fd);
+
+		if (!cloneFile(outputNames[i], tempName) || rename(tempName.c_str(), entryPath(key, i).c_str()) != 0) {
+			unlink(tempName.c_str());
+			return;
+		}
+	}
+
+	stores++;
+}
+
+void BuildCache::evict()
+{
+	vector<File> files(listFiles());
+	uint64_t total = 0;
+
+	for (auto& file: files)
+		total += file.size;
+
+	if (total <= maxSize)
+		return;
+
+	sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.lastUse < b.lastUse; });
+
+	for (auto& file: files) {
+		if (total <= maxSize / 10 * 9)
+			break;
+
+		if (unlink(file.name.c_str()) == 0) {
+			total -= file.size;
+			evictions++;
+		}
+	}
+}
+
+bool BuildCache::saveStats()
+{
+	string statsPath(dirName + "/" + statsName);
+	int fd = ::open(statsPath.c_str(), O_RDWR | O_CREAT, 0666);
+
+	if (fd < 0)
+		return false;
+
+	flock(fd, LOCK_EX);
+
+	string text;
+	char buffer[256];
+	ssize_t count;
+
+	while ((count = read(fd, buffer, sizeof(buffer))) > 0)
+		text.append(buffer, count);
+
+	Stats stats = parseStats(text);
+	stats.hits += hits.exchange(0);
+	stats.misses += misses.exchange(0);
+	stats.stores += stores.exchange(0);
+	stats.evictions += evictions.exchange(0);
+
+	text = "hits " + to_string(stats.hits) + "\nmisses " + to_string(stats.misses) + "\nstores " + to_string(stats.stores)
+	       + "\nevictions " + to_string(stats.evictions) + "\n";
+
+	bool written = lseek(fd, 0, SEEK_SET) == 0 && ftruncate(fd, 0) == 0
+	               && write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+
+	flock(fd, LOCK_UN);
+	close(fd);
+
+	return written;
+}
+
+BuildCache::Stats BuildCache::loadStats()
+{
+	ifstream statsFile(dirName + "/" + statsName);
+	ostringstream text;
+	text << statsFile.rdbuf();
+
+	return parseStats(text.str());
+}
+
+uint64_t BuildCache::size(size_t& fileCount)
+{
+	vector<File> files(listFiles());
+	uint64_t total = 0;
+
+	for (auto& file: files)
+		total += file.size;
+
+	fileCount = files.size();
+	return total;
+}
+
+vector<BuildCache::File> BuildCache::listFiles()
+{
+	vector<File> files;
+	DIR* dir = opendir(dirName.c_str());
+
+	if (dir == nullptr)
+		return files;
+
+	while (dirent* entry = readdir(dir)) {
+		string name(entry->d_name);
+		struct stat info;
+
+		if (name[0] == '.' || name == statsName || name.compare(0, string(tempPrefix).size(), tempPrefix) == 0)
+			continue;
+
+		string path(dirName + "/" + name);
+
+		if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+			files.push_back(File { path, uint64_t(info.st_size), info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec });
+	}
+
+	closedir(dir);
+	return files;
+}
+
+string BuildCache::entryPath(string key, size_t index)
+{
+	return dirName + "/" + key + "." + to_string(index);
+}
+
+bool BuildCache::cloneFile(string from, string to)
+{
+	int in = ::open(from.c_str(), O_RDONLY);
+
+	if (in < 0)
+		return false;
+
+	int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	bool copied = out >= 0;
+
+#ifdef FICLONE
+	if (copied && ioctl(out, FICLONE, in) == 0) {
+		close(in);
+		close(out);
+		return true;
+	}
+#endif
+
+	char buffer[65536];
+	ssize_t count = 0;
+
+	while (copied && (count = read(in, buffer, sizeof(buffer))) > 0)
+		copied = write(out, buffer, count) == count;
+
+	copied = copied && count == 0;
+
+	close(in);
+
+	if (out >= 0)
+		close(out);
+
+	return copied;
+}
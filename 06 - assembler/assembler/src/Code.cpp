@@ -1,64 +1,285 @@
 #include "Code.h"
-#include <algorithm>
+#include <array>
+#include <cstdint>
 
-unsigned int Code::dest(string mnemonic)
-{
-	// format 0000000000ddd000
+namespace {
+
+	// The table maps a whole C-instruction to its binary code. Every command is packed into a 64 bit
+	// key using 5 bits per char (the mnemonics use only 20 distinct chars), which keeps keys unique
+	// for commands up to 12 chars long. The keys are placed at compile time with a perfect hash
+	// ("hash and displace"): keys are grouped in buckets and every bucket gets a displacement that
+	// moves all of its keys to free slots, so a lookup reads one displacement and one slot.
+
+	constexpr size_t maxCommandLength = 12;
+
+	constexpr size_t tableBits = 13;
+
+	constexpr size_t tableSize = size_t(1) << tableBits;
+
+	constexpr size_t tableMask = tableSize - 1;
+
+	constexpr size_t bucketBits = 11;
+
+	constexpr size_t bucketCount = size_t(1) << bucketBits;
+
+	constexpr const char* dests[] = {
+		"", "M", "D", "MD", "A", "AM", "AD", "AMD",
+		"DM", "MA", "DA", "ADM", "MAD", "MDA", "DAM", "DMA" // same as above, letters in any order
+	};
+
+	constexpr unsigned int destBits[] = {
+		0b000, 0b001, 0b010, 0b011, 0b100, 0b101, 0b110, 0b111,
+		0b011, 0b101, 0b110, 0b111, 0b111, 0b111, 0b111, 0b111
+	};
+
+	constexpr const char* jumps[] = {
+		"", "JGT", "JEQ", "JGE", "JLT", "JNE", "JLE", "JMP"
+	};
+
+	struct Comp {
+		const char* mnemonic;
+		unsigned int bits; // format acccccc
+	};
+
+	constexpr Comp comps[] = {
+		{ "0",   0b0101010 }, { "1",   0b0111111 }, { "-1",  0b0111010 },
+		{ "D",   0b0001100 }, { "A",   0b0110000 }, { "!D",  0b0001101 },
+		{ "!A",  0b0110001 }, { "-D",  0b0001111 }, { "-A",  0b0110011 },
+		{ "D+1", 0b0011111 }, { "A+1", 0b0110111 }, { "D-1", 0b0001110 },
+		{ "A-1", 0b0110010 }, { "D+A", 0b0000010 }, { "D-A", 0b0010011 },
+		{ "A-D", 0b0000111 }, { "D&A", 0b0000000 }, { "D|A", 0b0010101 },
+		{ "A+D", 0b0000010 }, { "A&D", 0b0000000 }, { "A|D", 0b0010101 },
+		{ "M",   0b1110000 }, { "!M",  0b1110001 }, { "-M",  0b1110011 },
+		{ "M+1", 0b1110111 }, { "M-1", 0b1110010 }, { "D+M", 0b1000010 },
+		{ "D-M", 0b1010011 }, { "M-D", 0b1000111 }, { "D&M", 0b1000000 },
+		{ "D|M", 0b1010101 }, { "M+D", 0b1000010 }, { "M&D", 0b1000000 },
+		{ "M|D", 0b1010101 }
+	};
+
+	constexpr size_t entryCount = size(dests) * size(comps) * size(jumps);
+
+	constexpr array<uint8_t, 256> makeCharCodes()
+	{
+		array<uint8_t, 256> codes {};
+		const char* chars = "AMD=;JGTEQLNP01-+!&|";
+
+		for (uint8_t i = 0; chars[i] != '\0'; i++)
+			codes[static_cast<unsigned char>(chars[i])] = i + 1;
+
+		return codes;
+	}
+
+	constexpr array<uint8_t, 256> charCodes = makeCharCodes();
+
+	constexpr uint64_t pack(uint64_t key, const char* str)
+	{
+		for (; *str != '\0'; str++)
+			key = key << 5 | charCodes[static_cast<unsigned char>(*str)];
+
+		return key;
+	}
+
+	constexpr size_t bucketOf(uint64_t key)
+	{
+		return (key * 0x9e3779b97f4a7c15ull) >> (64 - bucketBits);
+	}
+
+	constexpr size_t slotOf(uint64_t key, uint16_t displacement)
+	{
+		return (((key ^ key >> 27) * 0xbf58476d1ce4e5b9ull >> (64 - tableBits)) + displacement) & tableMask;
+	}
+
+	struct Table {
+		array<uint16_t, bucketCount> displacements {};
+		array<uint64_t, tableSize> keys {};		// 0 for empty slots
+		array<uint16_t, tableSize> codes {};
+		bool perfect = true;					// false if some bucket could not be placed
+	};
+
+	struct Entry {
+		uint64_t key;
+		uint16_t code;
+	};
+
+	constexpr Table makeTable()
+	{
+		array<Entry, entryCount> entries {};
+		size_t n = 0;
+
+		for (size_t d = 0; d < size(dests); d++) {
+			for (auto& comp: comps) {
+				for (unsigned int j = 0; j < size(jumps); j++) {
+					uint64_t key = 0;
+
+					if (*dests[d] != '\0')
+						key = pack(pack(key, dests[d]), "=");
+
+					key = pack(key, comp.mnemonic);
+
+					if (*jumps[j] != '\0')
+						key = pack(pack(key, ";"), jumps[j]);
+
+					entries[n++] = Entry { key, uint16_t(0b1110000000000000 | comp.bits << 6 | destBits[d] << 3 | j) };
+				}
+			}
+		}
+
+		// groups the entries by bucket (counting sort)
+
+		array<size_t, bucketCount + 1> first {};
+		array<Entry, entryCount> sorted {};
+		size_t maxBucketSize = 0;
+
+		for (auto& entry: entries)
+			first[bucketOf(entry.key) + 1]++;
+
+		for (size_t b = 0; b < bucketCount; b++) {
+			if (first[b + 1] > maxBucketSize)
+				maxBucketSize = first[b + 1];
+			first[b + 1] += first[b];
+		}
 
-	unsigned int dest = 0;
+		array<size_t, bucketCount> next {};
 
-	if (mnemonic.find('M') != string::npos) dest |= 0b001;
-	if (mnemonic.find('D') != string::npos) dest |= 0b010;
-	if (mnemonic.find('A') != string::npos) dest |= 0b100;
+		for (size_t b = 0; b < bucketCount; b++)
+			next[b] = first[b];
+
+		for (auto& entry: entries)
+			sorted[next[bucketOf(entry.key)]++] = entry;
+
+		// places the buckets, largest first
+
+		Table table {};
+
+		for (size_t bucketSize = maxBucketSize; bucketSize > 0; bucketSize--) {
+			for (size_t b = 0; b < bucketCount; b++) {
+				if (first[b + 1] - first[b] != bucketSize)
+					continue;
+
+				bool placed = false;
+
+				for (size_t d = 0; d < tableSize && !placed; d++) {
+					placed = true;
+
+					for (size_t i = first[b]; i < first[b + 1] && placed; i++) {
+						size_t slot = slotOf(sorted[i].key, d);
+
+						if (table.keys[slot] != 0) {
+							placed = false;
+						} else {
+							for (size_t k = first[b]; k < i; k++) {
+								if (slotOf(sorted[k].key, d) == slot)
+									placed = false;
+							}
+						}
+					}
+
+					if (placed) {
+						table.displacements[b] = d;
+
+						for (size_t i = first[b]; i < first[b + 1]; i++) {
+							table.keys[slotOf(sorted[i].key, d)] = sorted[i].key;
+							table.codes[slotOf(sorted[i].key, d)] = sorted[i].code;
+						}
+					}
+				}
+
+				if (!placed)
+					table.perfect = false;
+			}
+		}
+
+		return table;
+	}
+
+	constexpr Table table = makeTable();
+
+	static_assert(table.perfect, "unable to build a perfect hash for the C-instruction table");
+
+	// The decode table maps every 16 bit word to the offset of its mnemonic in a pool of
+	// null-terminated strings, or to noMnemonic. Only the first 8 dests and the first comp
+	// with given bits are used, so the mnemonics are canonical.
+
+	constexpr uint16_t noMnemonic = 0xffff;
+
+	constexpr size_t canonicalDests = 8;
+
+	constexpr size_t poolSize = canonicalDests * 28 * size(jumps) * (maxCommandLength + 1);
+
+	struct DecodeTable {
+		array<uint16_t, 65536> offsets {};
+		array<char, poolSize> pool {};
+	};
+
+	constexpr DecodeTable makeDecodeTable()
+	{
+		DecodeTable decodeTable {};
+		size_t n = 0;
+
+		for (auto& offset: decodeTable.offsets)
+			offset = noMnemonic;
+
+		for (size_t d = 0; d < canonicalDests; d++) {
+			for (auto& comp: comps) {
+				for (unsigned int j = 0; j < size(jumps); j++) {
+					size_t word = 0b1110000000000000 | comp.bits << 6 | destBits[d] << 3 | j;
+
+					if (decodeTable.offsets[word] != noMnemonic) // same bits as an earlier comp
+						continue;
+
+					decodeTable.offsets[word] = n;
+
+					for (const char* c = dests[d]; *c != '\0'; c++)
+						decodeTable.pool[n++] = *c;
+
+					if (*dests[d] != '\0')
+						decodeTable.pool[n++] = '=';
+
+					for (const char* c = comp.mnemonic; *c != '\0'; c++)
+						decodeTable.pool[n++] = *c;
+
+					if (*jumps[j] != '\0')
+						decodeTable.pool[n++] = ';';
+
+					for (const char* c = jumps[j]; *c != '\0'; c++)
+						decodeTable.pool[n++] = *c;
+
+					decodeTable.pool[n++] = '\0';
+				}
+			}
+		}
+
+		return decodeTable;
+	}
+
+	constexpr DecodeTable decodeTable = makeDecodeTable();
 
-	return dest << 3;
 }
 
-unsigned int Code::comp(string mnemonic)
+int Code::cCommand(string_view command) const
 {
-	// format 000ccccccc000000
+	if (command.empty() || command.size() > maxCommandLength)
+		return -1;
 
-	unsigned int mask = 0;
-	unsigned int comp;
+	uint64_t key = 0;
 
-	if (mnemonic.find('M') != string::npos) {
-		mask = 64; // 0b1000000
-		replace(mnemonic.begin(), mnemonic.end(), 'M', 'A');
+	for (char c: command) {
+		uint8_t code = charCodes[static_cast<unsigned char>(c)];
+
+		if (code == 0)
+			return -1;
+
+		key = key << 5 | code;
 	}
 
-	if (mnemonic == "0") 		comp = 0b101010;
-	else if (mnemonic == "1")  	comp = 0b111111;
-	else if (mnemonic == "-1")  comp = 0b111010;
-	else if (mnemonic == "D")   comp = 0b001100;
-	else if (mnemonic == "A")   comp = 0b110000;
-	else if (mnemonic == "!D")  comp = 0b001101;
-	else if (mnemonic == "!A")  comp = 0b110001;
-	else if (mnemonic == "-D")  comp = 0b001111;
-	else if (mnemonic == "-A")  comp = 0b110011;
-	else if (mnemonic == "D+1") comp = 0b011111;
-	else if (mnemonic == "A+1") comp = 0b110111;
-	else if (mnemonic == "D-1") comp = 0b001110;
-	else if (mnemonic == "A-1") comp = 0b110010;
-	else if (mnemonic == "D+A") comp = 0b000010;
-	else if (mnemonic == "D-A") comp = 0b010011;
-	else if (mnemonic == "A-D") comp = 0b000111;
-	else if (mnemonic == "D&A") comp = 0b000000;
-	else 						comp = 0b010101;
-
-	return (comp |= mask) << 6;
+	size_t slot = slotOf(key, table.displacements[bucketOf(key)]);
+
+	return table.keys[slot] == key ? table.codes[slot] : -1;
 }
 
-unsigned int Code::jump(string mnemonic)
+const char* Code::cMnemonic(uint16_t word) const
 {
-	// format 0000000000000jjj
-
-	if (mnemonic == "JGT") return 0b001;
-	if (mnemonic == "JEQ") return 0b010;
-	if (mnemonic == "JGE") return 0b011;
-	if (mnemonic == "JLT") return 0b100;
-	if (mnemonic == "JNE") return 0b101;
-	if (mnemonic == "JLE") return 0b110;
-	if (mnemonic == "JMP") return 0b111;
+	uint16_t offset = decodeTable.offsets[word];
 
-	return 0; // null case
+	return offset != noMnemonic ? &decodeTable.pool[offset] : nullptr;
 }
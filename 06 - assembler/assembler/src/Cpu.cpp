@@ -0,0 +1,34 @@
+#include "Cpu.h"
+
+// the functions are written once, compiled here and pasted into the translated programs as
+// source (Cpu::source); they cannot use the constants of Cpu.h, which those programs lack
+
+#define FUNCTIONS \
+	uint16_t alu(uint16_t x, uint16_t y, unsigned int control) \
+	{ \
+		x = control & 0x20 ? 0 : x; \
+		x = control & 0x10 ? ~x : x; \
+		y = control & 0x08 ? 0 : y; \
+		y = control & 0x04 ? ~y : y; \
+		uint16_t out = control & 0x02 ? x + y : x & y; \
+		return control & 0x01 ? ~out : out; \
+	} \
+	bool isJumpOnly(uint16_t word) \
+	{ \
+		return (word & 0x8000) && (word & 0x003f) == 0x0007; \
+	} \
+	bool isEnd(uint16_t word, uint16_t address, uint16_t next) \
+	{ \
+		return word == address && isJumpOnly(next); \
+	}
+
+#define SOURCE(...) #__VA_ARGS__
+#define SOURCE_OF(...) SOURCE(__VA_ARGS__)
+
+namespace Cpu {
+
+	FUNCTIONS
+
+	const char* const source = SOURCE_OF(namespace Cpu { FUNCTIONS });
+
+}
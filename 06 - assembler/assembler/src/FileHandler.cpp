@@ -1,6 +1,7 @@
 #include "FileHandler.h"
 #include <sys/stat.h>
 #include <dirent.h>
+#include <algorithm>
 
 namespace FileHandler {
 
@@ -26,4 +27,36 @@ namespace FileHandler {
 		return S_ISREG(buf.st_mode);
 	}
 
+	bool isDirectory(string fileName)
+	{
+		struct stat buf;
+		return stat(fileName.c_str(), &buf) == 0 && S_ISDIR(buf.st_mode);
+	}
+
+	vector<string> listFiles(string dirName, string extension)
+	{
+		vector<string> files;
+		DIR* dir = opendir(dirName.c_str());
+
+		if (dir == nullptr)
+			return files;
+
+		if (!dirName.empty() && dirName.back() != '/')
+			dirName.push_back('/');
+
+		struct dirent* entry;
+
+		while ((entry = readdir(dir)) != nullptr) {
+			string fileName(dirName + entry->d_name);
+
+			if (hasExtension(fileName, extension) && isFile(fileName))
+				files.push_back(fileName);
+		}
+
+		closedir(dir);
+		sort(files.begin(), files.end());
+
+		return files;
+	}
+
 }
@@ -0,0 +1,106 @@
+#include "Hash.h"
+#include <cstring>
+
+namespace Hash {
+
+	namespace {
+
+		const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+		const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+		const uint64_t prime3 = 0x165667B19E3779F9ull;
+		const uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+		const uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+		uint64_t rotl(uint64_t x, int r)
+		{
+			return (x << r) | (x >> (64 - r));
+		}
+
+		uint64_t read64(const char* p) // little-endian, whatever the alignment
+		{
+			const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+			uint64_t v = 0;
+
+			for (int i = 7; i >= 0; i--)
+				v = v << 8 | b[i];
+
+			return v;
+		}
+
+		uint32_t read32(const char* p)
+		{
+			const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+			return b[0] | b[1] << 8 | b[2] << 16 | uint32_t(b[3]) << 24;
+		}
+
+		uint64_t round(uint64_t acc, uint64_t input)
+		{
+			acc += input * prime2;
+			acc = rotl(acc, 31);
+			return acc * prime1;
+		}
+
+		uint64_t mergeRound(uint64_t acc, uint64_t val)
+		{
+			acc ^= round(0, val);
+			return acc * prime1 + prime4;
+		}
+
+	}
+
+	uint64_t xxh64(string_view data, uint64_t seed)
+	{
+		const char* p = data.data();
+		const char* end = p + data.size();
+		uint64_t h;
+
+		if (data.size() >= 32) { // four lanes of 8 bytes
+			uint64_t v1 = seed + prime1 + prime2;
+			uint64_t v2 = seed + prime2;
+			uint64_t v3 = seed;
+			uint64_t v4 = seed - prime1;
+
+			for (; end - p >= 32; p += 32) {
+				v1 = round(v1, read64(p));
+				v2 = round(v2, read64(p + 8));
+				v3 = round(v3, read64(p + 16));
+				v4 = round(v4, read64(p + 24));
+			}
+
+			h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+			h = mergeRound(h, v1);
+			h = mergeRound(h, v2);
+			h = mergeRound(h, v3);
+			h = mergeRound(h, v4);
+		} else {
+			h = seed + prime5;
+		}
+
+		h += data.size();
+
+		for (; end - p >= 8; p += 8) {
+			h ^= round(0, read64(p));
+			h = rotl(h, 27) * prime1 + prime4;
+		}
+
+		if (end - p >= 4) {
+			h ^= read32(p) * prime1;
+			h = rotl(h, 23) * prime2 + prime3;
+			p += 4;
+		}
+
+		for (; p < end; p++) {
+			h ^= static_cast<unsigned char>(*p) * prime5;
+			h = rotl(h, 11) * prime1;
+		}
+
+		h ^= h >> 33;
+		h *= prime2;
+		h ^= h >> 29;
+		h *= prime3;
+		h ^= h >> 32;
+
+		return h;
+	}
+
+}
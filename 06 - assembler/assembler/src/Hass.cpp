@@ -0,0 +1,117 @@
+#include "Hass.h"
+#include "Assembler.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace Hass {
+
+	const char* const version = Assembler::version;
+
+	Context::Context()
+	{}
+
+	Context::~Context()
+	{}
+
+	Result assemble(string_view source, const Options& options)
+	{
+		bool verbose = options.logStream != nullptr && (options.verbose || options.veryVerbose);
+		unique_ptr<Assembler> ownAssembler;
+		unique_ptr<Assembler>& assembler = options.context != nullptr ? options.context->assembler : ownAssembler;
+
+		if (assembler == nullptr) {
+			assembler.reset(new Assembler(source, options.inputName, options.outputName, verbose,
+			                              verbose && options.veryVerbose));
+		} else {
+			assembler->reset(source, options.inputName, options.outputName);
+			assembler->setVerbose(verbose);
+			assembler->setVeryVerbose(verbose && options.veryVerbose);
+		}
+
+		Assembler& hass = *assembler;
+		hass.setErrorStream(nullptr);
+		hass.setSourceLines(options.sourceLines);
+
+		// the details go through a buffered log written by a background thread; in JSONL only
+		// the records of the commands are kept
+
+		unique_ptr<TraceLog> trace;
+		ostream nullStream(nullptr);
+
+		if (verbose) {
+			trace.reset(new TraceLog(*options.logStream));
+
+			if (options.traceFormat == TraceFormat::JSONL) {
+				hass.setLogStream(nullStream);
+				hass.setTraceStream(&trace->stream(), TraceFormat::JSONL);
+			} else {
+				hass.setLogStream(trace->stream());
+				hass.setTraceStream(nullptr);
+			}
+		}
+
+		Result result;
+
+		unsigned int passes = (options.optimize ? Optimizer::PEEPHOLE : 0)
+		                      | (options.removeUnreachable ? Optimizer::UNREACHABLE_CODE : 0);
+
+		if (options.object)
+			result.ok = hass.assembleObject(passes);
+		else if (passes != 0)
+			result.ok = hass.assembleOptimized(passes);
+		else if (options.singlePass)
+			result.ok = hass.assembleSinglePass();
+		else if (options.threads != 1)
+			result.ok = hass.assembleParallel(options.threads);
+		else
+			result.ok = hass.assemble();
+
+		if (verbose) {
+			trace.reset(); // writes the rest of the details
+			hass.setLogStream(*options.logStream);
+			hass.setTraceStream(nullptr);
+		}
+
+		result.rom = hass.getRom();
+		result.sourceLines = hass.getSourceLines();
+		result.object = hass.getObject();
+
+		for (auto& pattern: hass.getOptimizationReport())
+			result.optimizations.push_back(Optimization { pattern.name, pattern.count, pattern.wordsSaved });
+
+		for (auto& diagnostic: hass.getDiagnostics())
+			result.diagnostics.push_back(Diagnostic { diagnostic.linePos, diagnostic.message });
+
+		const SymbolTable& symbolTable = hass.getSymbolTable();
+		size_t predefinedCount = hass.getPredefinedCount();
+
+		for (auto entry: symbolTable.getSortedEntries(0, predefinedCount))
+			result.symbols.push_back(Symbol { string(entry->symbol), entry->address, true });
+
+		for (auto entry: symbolTable.getSortedEntries(predefinedCount, symbolTable.size()))
+			result.symbols.push_back(Symbol { string(entry->symbol), entry->address, false });
+
+		return result;
+	}
+
+	void outputSymbolTable(ostream& symOutputStream, const Result& result, string outputName)
+	{
+		auto program = find_if(result.symbols.begin(), result.symbols.end(),
+		                       [](const Symbol& symbol) { return !symbol.predefined; });
+
+		if (program != result.symbols.begin()) { // if there are predefined symbols, print them
+			symOutputStream << "**** predefined symbols:" << endl << endl;
+
+			for (auto symbol = result.symbols.begin(); symbol != program; ++symbol)
+				symOutputStream << "0x" << setfill('0') << setw(4) << setbase(16) << symbol->address << " " << symbol->name << endl;
+
+			symOutputStream << endl;
+		}
+
+		symOutputStream << "**** " << outputName << " symbols:" << endl << endl;
+
+		for (auto symbol = program; symbol != result.symbols.end(); ++symbol)
+			symOutputStream << "0x" << setfill('0') << setw(4) << setbase(16) << symbol->address << " " << symbol->name << endl;
+	}
+
+}
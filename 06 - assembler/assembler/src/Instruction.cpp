@@ -0,0 +1,105 @@
+#include "Instruction.h"
+
+namespace {
+
+	// bits of a C-instruction: 111a cccc ccdd djjj, where the c bits are zx nx zy ny f no
+
+	const uint16_t zxBit = 1 << 11;		// zeroes the x (D) input of the ALU
+	const uint16_t zyBit = 1 << 9;		// zeroes the y (A or M) input of the ALU
+	const uint16_t aBit = 1 << 12;		// y is M instead of A
+
+	const uint16_t jumpLT = 0b100;
+	const uint16_t jumpEQ = 0b010;
+	const uint16_t jumpGT = 0b001;
+
+}
+
+Instruction Instruction::aCommand(uint16_t value, string_view symbol, int linePos)
+{
+	return Instruction { HasmCommandType::A_COMMAND, value, symbol, linePos };
+}
+
+Instruction Instruction::cCommand(uint16_t word, int linePos)
+{
+	return Instruction { HasmCommandType::C_COMMAND, word, string_view(), linePos };
+}
+
+Instruction Instruction::label(string_view symbol, int linePos)
+{
+	return Instruction { HasmCommandType::L_COMMAND, 0, symbol, linePos };
+}
+
+uint16_t Instruction::comp() const
+{
+	return (word >> 6) & 0x7f;
+}
+
+uint16_t Instruction::dest() const
+{
+	return (word >> 3) & 0x7;
+}
+
+bool Instruction::jumps() const
+{
+	return type == HasmCommandType::C_COMMAND && (word & 0x7) != 0;
+}
+
+bool Instruction::jumpsAlways() const
+{
+	if (type != HasmCommandType::C_COMMAND)
+		return false;
+
+	uint16_t jump = word & 0x7;
+
+	switch (comp()) {
+		case 0b0101010: return jump & jumpEQ;	// 0
+		case 0b0111111: return jump & jumpGT;	// 1
+		case 0b0111010: return jump & jumpLT;	// -1
+		default: 		return jump == (jumpLT | jumpEQ | jumpGT);
+	}
+}
+
+bool Instruction::readsA() const
+{
+	return readsAOperand() || jumps();
+}
+
+bool Instruction::readsAOperand() const
+{
+	if (type != HasmCommandType::C_COMMAND)
+		return false;
+
+	bool readsY = !(word & zyBit);
+
+	return (readsY && !(word & aBit)) || readsM() || writesM();
+}
+
+bool Instruction::readsD() const
+{
+	return type == HasmCommandType::C_COMMAND && !(word & zxBit);
+}
+
+bool Instruction::readsM() const
+{
+	return type == HasmCommandType::C_COMMAND && !(word & zyBit) && (word & aBit);
+}
+
+bool Instruction::writesA() const
+{
+	return type == HasmCommandType::A_COMMAND || (type == HasmCommandType::C_COMMAND && (dest() & DEST_A));
+}
+
+bool Instruction::writesD() const
+{
+	return type == HasmCommandType::C_COMMAND && (dest() & DEST_D);
+}
+
+bool Instruction::writesM() const
+{
+	return type == HasmCommandType::C_COMMAND && (dest() & DEST_M);
+}
+
+void Instruction::setCompDest(uint16_t comp, uint16_t dest)
+{
+	word = 0xe000 | (comp << 6) | (dest << 3) | (word & 0x7);
+}
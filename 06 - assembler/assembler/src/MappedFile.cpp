@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile::MappedFile()
+	: fd(-1),
+	  address(nullptr),
+	  length(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::openRead(const string& fileName)
+{
+	close();
+
+	if ((fd = open(fileName.c_str(), O_RDONLY)) < 0)
+		return false;
+
+	struct stat buf;
+
+	if (fstat(fd, &buf) < 0) {
+		close();
+		return false;
+	}
+
+	length = buf.st_size;
+
+	if (length == 0) // nothing to map
+		return true;
+
+	void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (map == MAP_FAILED) {
+		close();
+		return false;
+	}
+
+	address = static_cast<char*>(map);
+	madvise(address, length, MADV_SEQUENTIAL);
+
+	return true;
+}
+
+bool MappedFile::create(const string& fileName, size_t size)
+{
+	close();
+
+	if ((fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+		return false;
+
+	if (ftruncate(fd, size) < 0) {
+		close();
+		return false;
+	}
+
+	length = size;
+
+	if (length == 0)
+		return true;
+
+	void* map = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (map == MAP_FAILED) {
+		close();
+		return false;
+	}
+
+	address = static_cast<char*>(map);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (address != nullptr)
+		munmap(address, length);
+
+	if (fd >= 0)
+		::close(fd);
+
+	fd = -1;
+	address = nullptr;
+	length = 0;
+}
+
+char* MappedFile::data()
+{
+	return address;
+}
+
+size_t MappedFile::size() const
+{
+	return length;
+}
+
+string_view MappedFile::view() const
+{
+	return string_view(address, length);
+}
@@ -0,0 +1,171 @@
+#include "ObjectFile.h"
+#include <cstring>
+
+namespace {
+
+	const char magic[4] = { 'H', 'O', 'B', 'J' };
+
+	void putWord(string& buffer, uint16_t word)
+	{
+		buffer += static_cast<char>(word & 0xff);
+		buffer += static_cast<char>(word >> 8);
+	}
+
+	void putDoubleWord(string& buffer, uint32_t dword)
+	{
+		putWord(buffer, dword & 0xffff);
+		putWord(buffer, dword >> 16);
+	}
+
+	void putName(string& buffer, const string& name)
+	{
+		putWord(buffer, name.size());
+		buffer += name;
+	}
+
+	/**
+		Reads the fields of an object from a buffer, failing once the end is reached.
+	*/
+	class Reader {
+		public:
+			Reader(const string& buffer)
+				: buffer(buffer), pos(0), ok(true)
+			{}
+
+			uint16_t word()
+			{
+				if (!available(2))
+					return 0;
+
+				uint16_t word = static_cast<uint8_t>(buffer[pos]) | static_cast<uint8_t>(buffer[pos + 1]) << 8;
+				pos += 2;
+				return word;
+			}
+
+			uint32_t doubleWord()
+			{
+				uint32_t low = word();
+				return low | uint32_t(word()) << 16;
+			}
+
+			string name()
+			{
+				size_t size = word();
+
+				if (!available(size))
+					return string();
+
+				pos += size;
+				return buffer.substr(pos - size, size);
+			}
+
+			bool available(size_t size)
+			{
+				ok = ok && buffer.size() - pos >= size;
+				return ok;
+			}
+
+			const string& buffer;
+			size_t pos;
+			bool ok;
+	};
+
+}
+
+void ObjectFile::write(ostream& outputStream) const
+{
+	string buffer(magic, sizeof(magic));
+
+	putDoubleWord(buffer, version);
+	putDoubleWord(buffer, words.size());
+	putDoubleWord(buffer, exports.size());
+	putDoubleWord(buffer, relocations.size());
+	putDoubleWord(buffer, variables.size());
+	putDoubleWord(buffer, references.size());
+
+	for (uint16_t word: words)
+		putWord(buffer, word);
+
+	for (auto& entry: exports) {
+		putName(buffer, entry.name);
+		putDoubleWord(buffer, entry.offset);
+	}
+
+	for (uint32_t relocation: relocations)
+		putDoubleWord(buffer, relocation);
+
+	for (auto& variable: variables)
+		putName(buffer, variable);
+
+	for (auto& reference: references) {
+		putDoubleWord(buffer, reference.wordIndex);
+		putDoubleWord(buffer, reference.variableIndex);
+	}
+
+	outputStream.write(buffer.data(), buffer.size());
+}
+
+bool ObjectFile::read(istream& inputStream)
+{
+	string buffer((istreambuf_iterator<char>(inputStream)), istreambuf_iterator<char>());
+	Reader reader(buffer);
+
+	if (!reader.available(sizeof(magic)) || memcmp(buffer.data(), magic, sizeof(magic)) != 0)
+		return false;
+
+	reader.pos += sizeof(magic);
+
+	if (reader.doubleWord() != version)
+		return false;
+
+	uint32_t wordCount = reader.doubleWord();
+	uint32_t exportCount = reader.doubleWord();
+	uint32_t relocationCount = reader.doubleWord();
+	uint32_t variableCount = reader.doubleWord();
+	uint32_t referenceCount = reader.doubleWord();
+
+	if (!reader.available(size_t(wordCount) * 2)) // the counts must not be trusted for reserving memory
+		return false;
+
+	words.assign(wordCount, 0);
+	exports.clear();
+	relocations.clear();
+	variables.clear();
+	references.clear();
+
+	for (auto& word: words)
+		word = reader.word();
+
+	for (uint32_t i = 0; i < exportCount && reader.ok; i++) {
+		string name(reader.name());
+		exports.push_back(Export { name, reader.doubleWord() });
+	}
+
+	for (uint32_t i = 0; i < relocationCount && reader.ok; i++)
+		relocations.push_back(reader.doubleWord());
+
+	for (uint32_t i = 0; i < variableCount && reader.ok; i++)
+		variables.push_back(reader.name());
+
+	for (uint32_t i = 0; i < referenceCount && reader.ok; i++) {
+		uint32_t wordIndex = reader.doubleWord();
+		references.push_back(Reference { wordIndex, reader.doubleWord() });
+	}
+
+	if (!reader.ok)
+		return false;
+
+	for (auto& entry: exports)
+		if (entry.offset > words.size())
+			return false;
+
+	for (uint32_t relocation: relocations)
+		if (relocation >= words.size())
+			return false;
+
+	for (auto& reference: references)
+		if (reference.wordIndex >= words.size() || reference.variableIndex >= variables.size())
+			return false;
+
+	return true;
+}
@@ -0,0 +1,432 @@
+#include "Optimizer.h"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+	// comp fields (a bit and zx nx zy ny f no) of the computations the passes look at
+
+	const uint16_t compZero = 0b0101010;
+	const uint16_t compOne = 0b0111111;
+	const uint16_t compMinusOne = 0b0111010;
+	const uint16_t compD = 0b0001100;
+	const uint16_t compA = 0b0110000;
+	const uint16_t compM = 0b1110000;
+	const uint16_t compMPlusOne = 0b1110111;
+	const uint16_t compMMinusOne = 0b1110010;
+
+	const int keyboard = 0x6000; // memory mapped keyboard: reading it twice may give different values
+
+	const int maxIterations = 16;
+
+}
+
+bool Optimizer::Value::operator==(const Value& other) const
+{
+	return known && other.known && symbol == other.symbol && (!symbol.empty() || constant == other.constant);
+}
+
+Optimizer::Optimizer(vector<Instruction>& program)
+	: program(program), peepholeSkipped(false)
+{
+	report.push_back(Pattern("redundant A loads"));
+	report.push_back(Pattern("redundant D loads"));
+	report.push_back(Pattern("increment/decrement fusions"));
+	report.push_back(Pattern("constant stores"));
+	report.push_back(Pattern("dead register writes"));
+	report.push_back(Pattern("unreachable instructions"));
+	report.push_back(Pattern("dead labels"));
+}
+
+void Optimizer::optimize(unsigned int passes)
+{
+	if ((passes & PEEPHOLE) && jumpsToConstantAddress()) {
+		passes &= ~PEEPHOLE;
+		peepholeSkipped = true;
+	}
+
+	for (int i = 0; i < maxIterations; i++) {
+		bool changed = false;
+
+		if (passes & UNREACHABLE_CODE)
+			changed |= removeUnreachableCode();
+
+		if (passes & PEEPHOLE) {
+			changed |= removeRedundantLoads();
+			changed |= fuseIncrements();
+			changed |= removeDeadWrites();
+		}
+
+		if (!changed)
+			break;
+	}
+}
+
+bool Optimizer::isPeepholeSkipped() const
+{
+	return peepholeSkipped;
+}
+
+const vector<Optimizer::Pattern>& Optimizer::getReport()
+{
+	return report;
+}
+
+bool Optimizer::removeRedundantLoads()
+{
+	Value a, d, dMemory; // dMemory: address whose contents D is known to hold
+	size_t kept = 0;
+	bool changed = false;
+
+	for (Instruction instruction: program) {
+
+		switch (instruction.type) {
+
+			case HasmCommandType::L_COMMAND:
+				a = d = dMemory = Value();
+				break;
+
+			case HasmCommandType::A_COMMAND: {
+				Value v { true, instruction.word, instruction.symbol };
+
+				if (v == a) {
+					count(REDUNDANT_A_LOAD, 1);
+					changed = true;
+					continue;
+				}
+
+				a = v;
+				break;
+			}
+
+			case HasmCommandType::C_COMMAND: {
+				uint16_t comp = instruction.comp();
+				uint16_t dest = instruction.dest();
+				bool volatileM = !a.known || (a.symbol.empty() && a.constant == keyboard);
+				Value result;
+
+				switch (comp) {
+					case compZero: 		result = Value { true, 0, string_view() }; break;
+					case compOne: 		result = Value { true, 1, string_view() }; break;
+					case compMinusOne: 	result = Value { true, -1, string_view() }; break;
+					case compA: 		result = a; break;
+					case compD: 		result = d; break;
+				}
+
+				if (!instruction.jumps()) {
+					bool redundantD = dest == Instruction::DEST_D && (result == d || (comp == compM && !volatileM && a == dMemory));
+					bool redundantA = dest == Instruction::DEST_A && result == a;
+
+					if (redundantD || redundantA) {
+						count(redundantD ? REDUNDANT_D_LOAD : REDUNDANT_A_LOAD, 1);
+						changed = true;
+						continue;
+					}
+
+					if (dest == Instruction::DEST_M && comp == compD && d.known && d.symbol.empty()
+						&& d.constant >= -1 && d.constant <= 1) {
+						instruction.setCompDest(d.constant == 0 ? compZero : d.constant == 1 ? compOne : compMinusOne, dest);
+						comp = instruction.comp();
+						count(CONSTANT_STORE, 0);
+						changed = true;
+					}
+				}
+
+				Value stored = !volatileM ? a : Value(); // address of M, if known
+
+				if (instruction.writesM()) // RAM[A] equals D if D is written the same value, or holds it already
+					dMemory = instruction.writesD() || comp == compD || result == d ? stored : Value();
+				else if (instruction.writesD())
+					dMemory = comp == compM ? stored : Value();
+
+				if (instruction.writesD())
+					d = result;
+
+				if (instruction.writesA())
+					a = result;
+
+				break;
+			}
+
+		}
+
+		program[kept++] = instruction;
+	}
+
+	program.resize(kept);
+	return changed;
+}
+
+bool Optimizer::fuseIncrements()
+{
+	size_t kept = 0;
+	bool changed = false;
+
+	for (size_t i = 0; i < program.size(); i++) {
+		Instruction& first = program[i];
+
+		if (i + 1 < program.size() && first.type == HasmCommandType::C_COMMAND && !first.jumps()
+			&& first.dest() == Instruction::DEST_M && (first.comp() == compMPlusOne || first.comp() == compMMinusOne)) {
+
+			Instruction& second = program[i + 1];
+			uint16_t inverse = first.comp() == compMPlusOne ? compMMinusOne : compMPlusOne;
+
+			if (second.type == HasmCommandType::C_COMMAND && !second.jumps() && second.comp() == inverse) {
+
+				if (second.dest() == (Instruction::DEST_A | Instruction::DEST_M)) {
+					second.setCompDest(compM, Instruction::DEST_A); // AM=M-1 after M=M+1: A=M
+					count(INCREMENT_FUSION, 1);
+					changed = true;
+					continue;
+				}
+
+				if (second.dest() == Instruction::DEST_M) { // M=M-1 after M=M+1: nothing
+					count(INCREMENT_FUSION, 2);
+					changed = true;
+					i++;
+					continue;
+				}
+			}
+		}
+
+		program[kept++] = first;
+	}
+
+	program.resize(kept);
+	return changed;
+}
+
+bool Optimizer::removeDeadWrites()
+{
+	bool liveA = true, liveD = true; // everything is live at labels, jumps and the end of the program
+	vector<bool> removed(program.size(), false);
+	bool changed = false;
+
+	for (size_t i = program.size(); i-- > 0; ) {
+		const Instruction& instruction = program[i];
+
+		switch (instruction.type) {
+
+			case HasmCommandType::L_COMMAND:
+				liveA = liveD = true;
+				break;
+
+			case HasmCommandType::A_COMMAND:
+				if (!liveA) {
+					removed[i] = true;
+					break;
+				}
+
+				liveA = false;
+				break;
+
+			case HasmCommandType::C_COMMAND:
+				if (instruction.jumps()) {
+					liveA = liveD = true;
+				} else if (!instruction.writesM() && !(instruction.writesA() && liveA) && !(instruction.writesD() && liveD)) {
+					removed[i] = true;
+					break;
+				}
+
+				if (instruction.writesA()) liveA = false;
+				if (instruction.writesD()) liveD = false;
+				if (instruction.readsA()) liveA = true;
+				if (instruction.readsD()) liveD = true;
+
+				break;
+
+		}
+	}
+
+	size_t kept = 0;
+
+	for (size_t i = 0; i < program.size(); i++) {
+		if (removed[i]) {
+			count(DEAD_WRITE, 1);
+			changed = true;
+		} else {
+			program[kept++] = program[i];
+		}
+	}
+
+	program.resize(kept);
+	return changed;
+}
+
+bool Optimizer::removeUnreachableCode()
+{
+	if (program.empty() || jumpsToConstantAddress()) // the code cannot be moved
+		return false;
+
+	// split the program into basic blocks; consecutive labels start a single block
+
+	vector<size_t> blockOf(program.size());
+	unordered_map<string_view, size_t> labels; // label -> its block
+	size_t blockCount = 0;
+
+	for (size_t i = 0; i < program.size(); i++) {
+		const Instruction& instruction = program[i];
+
+		if (i == 0 || program[i - 1].jumps()
+			|| (instruction.type == HasmCommandType::L_COMMAND && program[i - 1].type != HasmCommandType::L_COMMAND))
+			blockCount++;
+
+		blockOf[i] = blockCount - 1;
+
+		if (instruction.type == HasmCommandType::L_COMMAND)
+			labels.emplace(instruction.symbol, blockOf[i]); // the first definition is the one used
+	}
+
+	// edges of the control flow graph
+
+	vector<vector<size_t>> successors(blockCount);
+	vector<vector<size_t>> taken(blockCount);	// blocks whose address each block loads into A
+	vector<bool> computedJump(blockCount, false);
+	Value a;
+
+	for (size_t i = 0; i < program.size(); i++) {
+		const Instruction& instruction = program[i];
+		size_t block = blockOf[i];
+		bool last = i + 1 == program.size() || blockOf[i + 1] != block;
+
+		if (i == 0 || blockOf[i - 1] != block)
+			a = Value();
+
+		if (instruction.type == HasmCommandType::A_COMMAND) {
+			a = Value { true, instruction.word, instruction.symbol };
+			auto label = labels.find(instruction.symbol);
+
+			if (label != labels.end() && !(i + 1 < program.size() && program[i + 1].jumps() && !program[i + 1].readsAOperand()))
+				taken[block].push_back(label->second);
+
+		} else if (instruction.type == HasmCommandType::C_COMMAND) {
+
+			if (instruction.jumps()) {
+				if (!a.known) {
+					computedJump[block] = true;
+				} else {
+					auto label = labels.find(a.symbol);
+
+					if (label != labels.end())
+						successors[block].push_back(label->second);
+					else
+						computedJump[block] = true; // jump to the address of a variable
+				}
+			}
+
+			if (instruction.writesA())
+				a = Value();
+		}
+
+		if (last && i + 1 < program.size() && !instruction.jumpsAlways())
+			successors[block].push_back(block + 1);
+	}
+
+	// blocks reachable from the start; computed jumps reach every taken label found so far
+
+	vector<bool> reached(blockCount, false);
+	vector<size_t> pending;
+	vector<size_t> takenBlocks;
+	bool computedReached = false;
+
+	auto reach = [&](size_t block) {
+		if (!reached[block]) {
+			reached[block] = true;
+			pending.push_back(block);
+		}
+	};
+
+	reach(0);
+
+	while (!pending.empty()) {
+		size_t block = pending.back();
+		pending.pop_back();
+
+		for (size_t successor: successors[block])
+			reach(successor);
+
+		for (size_t target: taken[block]) {
+			takenBlocks.push_back(target);
+			if (computedReached) reach(target);
+		}
+
+		if (computedJump[block] && !computedReached) {
+			computedReached = true;
+			for (size_t target: takenBlocks) reach(target);
+		}
+	}
+
+	// remove the unreachable blocks, and then the labels that are not referred to
+
+	size_t kept = 0;
+	bool changed = false;
+
+	for (size_t i = 0; i < program.size(); i++) {
+		if (reached[blockOf[i]]) {
+			program[kept++] = program[i];
+		} else {
+			bool isLabel = program[i].type == HasmCommandType::L_COMMAND;
+			count(isLabel ? DEAD_LABEL : UNREACHABLE_INSTRUCTION, isLabel ? 0 : 1);
+			changed = true;
+		}
+	}
+
+	program.resize(kept);
+
+	unordered_set<string_view> referenced;
+
+	for (auto& instruction: program)
+		if (instruction.type == HasmCommandType::A_COMMAND && !instruction.symbol.empty())
+			referenced.insert(instruction.symbol);
+
+	kept = 0;
+
+	for (size_t i = 0; i < program.size(); i++) {
+		if (program[i].type == HasmCommandType::L_COMMAND && referenced.count(program[i].symbol) == 0) {
+			count(DEAD_LABEL, 0);
+			changed = true;
+		} else {
+			program[kept++] = program[i];
+		}
+	}
+
+	program.resize(kept);
+	return changed;
+}
+
+bool Optimizer::jumpsToConstantAddress() const
+{
+	Value a; // what A holds since the start of the basic block
+
+	for (auto& instruction: program) {
+
+		switch (instruction.type) {
+
+			case HasmCommandType::L_COMMAND:
+				a = Value();
+				break;
+
+			case HasmCommandType::A_COMMAND:
+				a = Value { true, instruction.word, instruction.symbol };
+				break;
+
+			case HasmCommandType::C_COMMAND:
+				if (instruction.jumps() && a.known && a.symbol.empty())
+					return true;
+
+				if (instruction.jumps() || instruction.writesA())
+					a = Value();
+
+				break;
+
+		}
+	}
+
+	return false;
+}
+
+void Optimizer::count(PatternIndex pattern, int wordsSaved)
+{
+	report[pattern].count++;
+	report[pattern].wordsSaved += wordsSaved;
+}
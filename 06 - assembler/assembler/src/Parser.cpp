@@ -1,20 +1,68 @@
 #include "Parser.h"
 
+namespace {
+
+    /**
+        Reads the whole input stream, in blocks, into a string.
+    */
+    string readAll(istream& inputStream)
+    {
+        const size_t blockSize = 65536;
+        string buffer;
+        streamsize count;
+
+        do {
+            size_t size = buffer.size();
+            buffer.resize(size + blockSize);
+            count = inputStream.rdbuf()->sgetn(&buffer[size], blockSize);
+            buffer.resize(size + count);
+        } while (count == static_cast<streamsize>(blockSize));
+
+        return buffer;
+    }
+
+}
+
 Parser::Parser(istream& inputStream)
-    : inputStream(inputStream),
-      linePos(0)
+    : buffer(readAll(inputStream)),
+      source(buffer),
+      pos(0),
+      lineStart(0),
+      linePos(1),
+      type(HasmCommandType::C_COMMAND)
+{
+}
+
+Parser::Parser(string_view source)
+    : source(source),
+      pos(0),
+      lineStart(0),
+      linePos(1),
+      type(HasmCommandType::C_COMMAND)
 {
-    readNextLine(); // ???????????
 }
 
-string Parser::getCommand()
+string_view Parser::getSource()
+{
+    return source;
+}
+
+string_view Parser::getCommand()
 {
     return command;
 }
 
-string Parser::getLine()
+string_view Parser::getLine()
 {
-    return currentLine;
+    size_t end = source.find('\n', lineStart);
+
+    if (end == string_view::npos)
+        end = source.size();
+
+    if (end > lineStart && source[end - 1] == '\r')
+        end--;
+
+    return source.substr(lineStart, end - lineStart);
 }
 
 int Parser::getLinePos()
@@ -27,148 +75,127 @@ bool Parser::advance()
     if (!nextValidChar())
         return false;
 
-    command.clear();
+    size_t start = pos;
+
+    while (pos < source.size() && !isspace(static_cast<unsigned char>(source[pos]))) {
+        if (source[pos] == '/' && pos + 1 < source.size() && (source[pos + 1] == '/' || source[pos + 1] == '*'))
+            break; // comment right after the command
 
-    while (it != currentLine.end() && !isspace(*it)) {
-        command.append(1, *it);
-        ++it;
+        ++pos;
     }
 
+    command = source.substr(start, pos - start);
+    splitCommand();
+
     return true;
 }
 
 HasmCommandType Parser::commandType()
 {
-    if (command.front() == '@')
-        return HasmCommandType::A_COMMAND;
-    if (command.front() == '(')
-        return HasmCommandType::L_COMMAND;
-
-    return HasmCommandType::C_COMMAND;
+    return type;
 }
 
-string Parser::symbol()
+string_view Parser::symbol()
 {
-    if (commandType() == HasmCommandType::A_COMMAND)
-        return command.substr(1);
-
-    return command.substr(1, command.size() - 2);
+    return symbolField;
 }
 
-string Parser::dest()
+string_view Parser::dest()
 {
-    // C_COMMAND dest=comp;jump
-
-    if (command.find('=') != string::npos)
-        return command.substr(0, command.find('='));
-
-    return "";
+    return destField;
 }
 
-string Parser::comp()
+string_view Parser::comp()
 {
-    // C_COMMAND dest=comp;jump
-
-    if (command.find('=') == string::npos)  // dest omitted
-        return command.substr(0, command.find(';'));
-
-    if (command.find(';') == string::npos)  // jump omitted
-        return command.substr(command.find('=') + 1);
-
-    return command.substr(command.find('=') + 1, command.find(';'));
+    return compField;
 }
 
-string Parser::jump()
+string_view Parser::jump()
 {
-    // C_COMMAND dest=comp;jump
-
-    if (command.find(';') != string::npos)
-        return command.substr(command.find(';') + 1);
-
-    return "";
+    return jumpField;
 }
 
 void Parser::reset()
 {
-    inputStream.clear();
-    inputStream.seekg(0);
-    linePos = 0;
-    readNextLine(); // ?????????????????????????????????????????
+    pos = 0;
+    lineStart = 0;
+    linePos = 1;
 }
 
-bool Parser::readNextLine()
+void Parser::setSource(string_view source)
 {
-    if (getline(inputStream, currentLine)) {
-        linePos++;
-        it = currentLine.begin();
-        return true;
-    }
-
-    return false;
+    this->source = source;
+    reset();
 }
 
-bool Parser::nextValidLine()
+bool Parser::nextValidChar()
 {
-    if (!readNextLine())
-        return false;
-
-    while (true) {
-        if (currentLine.empty() || it == currentLine.end()) {
-            if (!readNextLine())
+    while (pos < source.size()) {
+        char c = source[pos];
+
+        if (c == '\n') {
+            lineStart = ++pos;
+            linePos++;
+        } else if (isspace(static_cast<unsigned char>(c))) {
+            ++pos;
+        } else if (c == '/' && pos + 1 < source.size() && source[pos + 1] == '/') { // single line comment
+            pos = source.find('\n', pos);
+
+            if (pos == string_view::npos)
+                pos = source.size();
+        } else if (c == '/' && pos + 1 < source.size() && source[pos + 1] == '*') { // multi line comment
+            if (!skipMultiLineComment())
                 return false;
         } else {
-            break;
+            return true;
         }
     }
 
-    return true;
+    return false;
 }
 
-bool Parser::nextValidChar()
+bool Parser::skipMultiLineComment()
 {
-    while (isspace(*it) || it == currentLine.end()) { // skipping whitespaces
+    size_t end = source.find("*/", pos + 2);
 
-        if (*it == '\n' || it == currentLine.end()) { // if so, read next valid line
-            if (!nextValidLine())
-                return false;
-        } else {
-            it++;
-        }
+    if (end == string_view::npos)
+        end = source.size();
+    else
+        end += 2; // + 2 for num of chars in "*/"
+
+    for (size_t nl = source.find('\n', pos); nl < end; nl = source.find('\n', nl + 1)) {
+        lineStart = nl + 1;
+        linePos++;
     }
 
-    if (!skipComments()) // skip comments here
-        return false;
+    pos = end;
 
-    return true;
+    return pos < source.size();
 }
 
-bool Parser::skipComments()
+void Parser::splitCommand()
 {
-    if (*it != '/') // if not char '/' then it can't be a comment
-        return true;
-
-    ++it;
-
-    if (*it == '/') // single line comment
-        return nextValidLine() && nextValidChar();
-
-    if (*it == '*') { // multi line comment
+    // C_COMMAND dest=comp;jump
 
-        while (true) {
+    if (command.front() == '@') {
+        type = HasmCommandType::A_COMMAND;
+        symbolField = command.substr(1);
+        return;
+    }
 
-            int dist = distance(currentLine.begin(), it);
-            size_t pos = currentLine.find("*/", dist);
+    if (command.front() == '(') {
+        type = HasmCommandType::L_COMMAND;
+        symbolField = command.substr(1, command.back() == ')' ? command.size() - 2 : string_view::npos);
+        return;
+    }
 
-            if (pos != string::npos) {
-                it = currentLine.begin() + pos + 2; // + 2 for num of chars in "*/"
-                return nextValidChar();
-            }
+    type = HasmCommandType::C_COMMAND;
 
-            if (!nextValidLine())
-                return false;
-        }
-    }
+    size_t eq = command.find('=');
+    size_t semicolon = command.find(';');
+    size_t compStart = eq == string_view::npos ? 0 : eq + 1;
 
-    --it; // if not a comment, go back to previous valid char
-    return true;
+    destField = eq == string_view::npos ? string_view() : command.substr(0, eq);
+    compField = command.substr(compStart, semicolon == string_view::npos ? string_view::npos : semicolon - compStart);
+    jumpField = semicolon == string_view::npos ? string_view() : command.substr(semicolon + 1);
 }
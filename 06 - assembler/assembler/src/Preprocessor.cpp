@@ -0,0 +1,483 @@
+#include "Preprocessor.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+
+namespace {
+
+	const int maxDepth = 64; // macro calls nested deeper are taken for a recursion
+
+	const string_view includeKeyword("#include");
+
+	string_view trim(string_view str)
+	{
+		size_t first = str.find_first_not_of(" \t\r");
+
+		if (first == string_view::npos)
+			return string_view();
+
+		return str.substr(first, str.find_last_not_of(" \t\r") - first + 1);
+	}
+
+	/**
+		Can the char be part of a symbol (letters, digits, _ . $ :)?
+	*/
+	bool isSymbolChar(char c)
+	{
+		return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '$' || c == ':';
+	}
+
+	/**
+		Splits the arguments of a directive or call, separated by commas or whitespace.
+	*/
+	vector<string_view> splitArguments(string_view arguments)
+	{
+		vector<string_view> words;
+		size_t pos = 0;
+
+		while ((pos = arguments.find_first_not_of(", \t", pos)) != string_view::npos) {
+			size_t end = min(arguments.find_first_of(", \t", pos), arguments.size());
+			words.push_back(arguments.substr(pos, end - pos));
+			pos = end;
+		}
+
+		return words;
+	}
+
+	/**
+		Replaces the parameters of a macro by the arguments of a call in a line of its body.
+		Comments and the names of local labels (%%name) are left alone.
+	*/
+	string substitute(string_view text, const vector<string>& params, const vector<string_view>& args)
+	{
+		string result;
+		size_t comment = text.find("//");
+		size_t i = 0;
+
+		result.reserve(text.size());
+
+		while (i < text.size()) {
+			if (i == comment) {
+				result.append(text.substr(i));
+				break;
+			}
+
+			if (!isSymbolChar(text[i])) {
+				result += text[i++];
+				continue;
+			}
+
+			size_t start = i;
+
+			while (i < text.size() && isSymbolChar(text[i]))
+				i++;
+
+			string_view word(text.substr(start, i - start));
+			auto param = start > 0 && text[start - 1] == '%' ? params.end() : find(params.begin(), params.end(), word);
+
+			if (param != params.end())
+				result.append(args[param - params.begin()]);
+			else
+				result.append(word);
+		}
+
+		return result;
+	}
+
+	/**
+		Appends text to a string, replacing every occurrence of a pattern.
+	*/
+	void appendReplacing(string& output, string_view text, string_view pattern, string_view replacement)
+	{
+		size_t pos = 0, found;
+
+		while ((found = text.find(pattern, pos)) != string_view::npos) {
+			output.append(text.substr(pos, found - pos));
+			output.append(replacement);
+			pos = found + pattern.size();
+		}
+
+		output.append(text.substr(pos));
+	}
+
+	/**
+		Returns the directory of a file name, with the trailing slash (empty for the current one).
+	*/
+	string directoryOf(const string& fileName)
+	{
+		size_t slash = fileName.rfind('/');
+		return slash == string::npos ? string() : fileName.substr(0, slash + 1);
+	}
+
+}
+
+shared_ptr<const Preprocessor::SourceFile> Preprocessor::IncludeCache::get(const string& fileName)
+{
+	struct stat info;
+
+	if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+		return nullptr;
+
+	char* resolved = realpath(fileName.c_str(), nullptr);
+
+	if (resolved == nullptr)
+		return nullptr;
+
+	string path(resolved);
+	free(resolved);
+
+	{
+		lock_guard<mutex> guard(lock);
+		auto found = files.find(path);
+
+		if (found != files.end() && found->second->size == info.st_size
+		    && found->second->modified.tv_sec == info.st_mtim.tv_sec
+		    && found->second->modified.tv_nsec == info.st_mtim.tv_nsec)
+			return found->second;
+	}
+
+	// reads the file without the lock, other threads may be reading other files
+
+	ifstream inputFile(path, ios::binary);
+
+	if (!inputFile.good())
+		return nullptr;
+
+	auto file = make_shared<SourceFile>();
+	file->path = path;
+	file->modified = info.st_mtim;
+	file->size = info.st_size;
+	file->text.assign(istreambuf_iterator<char>(inputFile), istreambuf_iterator<char>());
+	splitLines(file->text, file->lines);
+
+	lock_guard<mutex> guard(lock);
+	files[path] = file;
+
+	return file;
+}
+
+Preprocessor::Preprocessor(IncludeCache& includes)
+	: includes(includes), callCount(0), memoizedCount(0), localCount(0)
+{
+}
+
+bool Preprocessor::isNeeded(string_view source)
+{
+	return source.find(includeKeyword) != string_view::npos || source.find("MACRO") != string_view::npos;
+}
+
+void Preprocessor::splitLines(string_view text, vector<Line>& lines)
+{
+	bool inComment = false; // inside a multi line comment
+	size_t pos = 0;
+
+	lines.clear();
+
+	while (pos < text.size()) {
+		size_t end = min(text.find('\n', pos), text.size());
+		Line line { Line::TEXT, text.substr(pos, end - pos), string_view(), string_view() };
+		pos = end + 1;
+
+		// the first word, if the line does not start with a comment
+
+		size_t start = line.text.find_first_not_of(" \t\r");
+
+		if (!inComment && start != string_view::npos && line.text.compare(start, 2, "//") != 0
+		    && line.text.compare(start, 2, "/*") != 0) {
+			string_view code(trim(line.text.substr(start, min(line.text.find("//", start), line.text.find("/*", start)) - start)));
+			size_t space = code.compare(0, includeKeyword.size(), includeKeyword) == 0
+			               ? includeKeyword.size() : min(code.find_first_of(" \t"), code.size());
+
+			line.keyword = code.substr(0, space);
+			line.arguments = trim(code.substr(space));
+
+			if (line.keyword == includeKeyword)
+				line.kind = Line::INCLUDE;
+			else if (line.keyword == "MACRO")
+				line.kind = Line::MACRO;
+			else if (line.keyword == "ENDM")
+				line.kind = Line::ENDM;
+		}
+
+		// follows the multi line comments to the next line
+
+		for (size_t i = 0; i + 1 < line.text.size(); i++) {
+			if (inComment && line.text.compare(i, 2, "*/") == 0) {
+				inComment = false;
+				i++;
+			} else if (!inComment && line.text.compare(i, 2, "//") == 0) {
+				break;
+			} else if (!inComment && line.text.compare(i, 2, "/*") == 0) {
+				inComment = true;
+				i++;
+			}
+		}
+
+		lines.push_back(line);
+	}
+}
+
+bool Preprocessor::process(string_view source, string fileName)
+{
+	fileNames.assign(1, fileName);
+	sources.clear();
+	included.clear();
+	macros.clear();
+	expansions.clear();
+	output.clear();
+	origins.clear();
+	diagnostics.clear();
+	callCount = memoizedCount = localCount = 0;
+
+	auto program = make_shared<SourceFile>();
+	program->modified = timespec();
+	program->size = source.size();
+	splitLines(source, program->lines);
+	sources.push_back(program);
+
+	char* resolved = realpath(fileName.c_str(), nullptr); // a library including the program skips it
+
+	if (resolved != nullptr) {
+		included.insert(resolved);
+		free(resolved);
+	}
+
+	output.reserve(source.size() + source.size() / 2);
+	origins.reserve(program->lines.size());
+
+	processFile(*program, 0, 0);
+
+	return diagnostics.empty();
+}
+
+string_view Preprocessor::getOutput() const
+{
+	return output;
+}
+
+const Preprocessor::Origin& Preprocessor::getOrigin(int line) const
+{
+	return origins[line - 1];
+}
+
+const string& Preprocessor::getFileName(uint32_t fileId) const
+{
+	return fileNames[fileId];
+}
+
+size_t Preprocessor::getFileCount() const
+{
+	return fileNames.size();
+}
+
+string Preprocessor::location(int line) const
+{
+	if (line < 1 || static_cast<size_t>(line) > origins.size())
+		return fileNames[0] + ":" + to_string(line);
+
+	const Origin& origin = getOrigin(line);
+	string text(fileNames[origin.source.fileId] + ":" + to_string(origin.source.line));
+
+	if (origin.call.fileId != origin.source.fileId || origin.call.line != origin.source.line)
+		text += " (expanded at " + fileNames[origin.call.fileId] + ":" + to_string(origin.call.line) + ")";
+
+	return text;
+}
+
+vector<int> Preprocessor::mainLines(const vector<int>& outputLines) const
+{
+	vector<int> lines;
+	lines.reserve(outputLines.size());
+
+	for (int line: outputLines)
+		lines.push_back(line >= 1 && static_cast<size_t>(line) <= origins.size() ? getOrigin(line).mainLine : line);
+
+	return lines;
+}
+
+const vector<Preprocessor::Diagnostic>& Preprocessor::getDiagnostics() const
+{
+	return diagnostics;
+}
+
+size_t Preprocessor::getCallCount() const
+{
+	return callCount;
+}
+
+size_t Preprocessor::getMemoizedCount() const
+{
+	return memoizedCount;
+}
+
+void Preprocessor::processFile(const SourceFile& file, uint32_t fileId, int mainLine)
+{
+	for (size_t i = 0; i < file.lines.size(); i++) {
+		const Line& line = file.lines[i];
+		Position position { fileId, static_cast<uint32_t>(i + 1) };
+		int lineOfMain = mainLine != 0 ? mainLine : i + 1;
+
+		if (line.kind == Line::INCLUDE) {
+			if (line.arguments.size() < 3 || line.arguments.front() != '"' || line.arguments.back() != '"') {
+				error(position, "expected #include \"file\"");
+				continue;
+			}
+
+			string includeName(line.arguments.substr(1, line.arguments.size() - 2));
+
+			if (includeName[0] != '/')
+				includeName = directoryOf(fileNames[fileId]) + includeName;
+
+			shared_ptr<const SourceFile> includedFile = includes.get(includeName);
+
+			if (includedFile == nullptr) {
+				error(position, "unable to open include file \"" + includeName + "\"");
+				continue;
+			}
+
+			if (!included.insert(includedFile->path).second) // already in the program
+				continue;
+
+			sources.push_back(includedFile);
+			fileNames.push_back(includeName);
+			processFile(*includedFile, fileNames.size() - 1, lineOfMain);
+		} else if (line.kind == Line::MACRO) {
+			defineMacro(file, fileId, i);
+		} else if (line.kind == Line::ENDM) {
+			error(position, "ENDM without MACRO");
+		} else {
+			auto macro = line.keyword.empty() ? macros.end() : macros.find(line.keyword);
+
+			if (macro != macros.end()) {
+				const Expansion* expansion = expand(macro->first, macro->second, line.arguments, position, 0);
+
+				if (expansion != nullptr)
+					emit(*expansion, position, lineOfMain);
+			} else {
+				output.append(line.text);
+				output += '\n';
+				origins.push_back(Origin { position, position, lineOfMain });
+			}
+		}
+	}
+}
+
+void Preprocessor::defineMacro(const SourceFile& file, uint32_t fileId, size_t& index)
+{
+	Position position { fileId, static_cast<uint32_t>(index + 1) };
+	vector<string_view> words(splitArguments(file.lines[index].arguments));
+	size_t end = index + 1;
+
+	for (; end < file.lines.size() && file.lines[end].kind != Line::ENDM; end++) {
+		if (file.lines[end].kind != Line::TEXT)
+			error(Position { fileId, static_cast<uint32_t>(end + 1) }, "MACRO and #include are not allowed in a macro body");
+	}
+
+	if (end == file.lines.size()) {
+		error(position, "MACRO without ENDM");
+		index = end;
+		return;
+	}
+
+	if (words.empty()) {
+		error(position, "expected a macro name after MACRO");
+		index = end;
+		return;
+	}
+
+	Macro macro { &file, fileId, index + 1, end, vector<string>() };
+
+	for (size_t i = 1; i < words.size(); i++) {
+		if (find(macro.params.begin(), macro.params.end(), words[i]) != macro.params.end())
+			error(position, "duplicate parameter \"" + string(words[i]) + "\"");
+
+		macro.params.push_back(string(words[i]));
+	}
+
+	if (!macros.emplace(words[0], macro).second)
+		error(position, "macro \"" + string(words[0]) + "\" already defined");
+
+	index = end;
+}
+
+const Preprocessor::Expansion* Preprocessor::expand(string_view name, const Macro& macro, string_view arguments, Position call, int depth)
+{
+	vector<string_view> args(splitArguments(arguments));
+
+	callCount++;
+
+	if (args.size() != macro.params.size()) {
+		error(call, "macro \"" + string(name) + "\" takes " + to_string(macro.params.size()) + " arguments, "
+		            + to_string(args.size()) + " given");
+		return nullptr;
+	}
+
+	string key(name);
+
+	for (auto arg: args) {
+		key += '\0';
+		key += arg;
+	}
+
+	auto found = expansions.find(key);
+
+	if (found != expansions.end()) {
+		memoizedCount++;
+		return &found->second;
+	}
+
+	if (depth >= maxDepth) {
+		error(call, "macro calls nested too deeply (recursive macro \"" + string(name) + "\"?)");
+		return nullptr;
+	}
+
+	Expansion expansion;
+
+	for (size_t i = macro.first; i < macro.last; i++) {
+		const Line& line = macro.file->lines[i];
+		Position position { macro.fileId, static_cast<uint32_t>(i + 1) };
+		auto inner = line.keyword.empty() ? macros.end() : macros.find(line.keyword);
+
+		if (inner == macros.end()) {
+			expansion.text += substitute(line.text, macro.params, args);
+			expansion.text += '\n';
+			expansion.lines.push_back(position);
+			continue;
+		}
+
+		// a call in the body: its local labels get the index of the line, to tell them from
+		// the labels of other calls of the same expansion
+
+		string innerArguments(substitute(line.arguments, macro.params, args));
+		const Expansion* nested = expand(inner->first, inner->second, innerArguments, position, depth + 1);
+
+		if (nested == nullptr)
+			return nullptr;
+
+		appendReplacing(expansion.text, nested->text, "%%", "%%" + to_string(i - macro.first) + ".");
+		expansion.lines.insert(expansion.lines.end(), nested->lines.begin(), nested->lines.end());
+	}
+
+	expansion.hasLocals = expansion.text.find("%%") != string::npos;
+
+	return &expansions.emplace(key, move(expansion)).first->second;
+}
+
+void Preprocessor::emit(const Expansion& expansion, Position call, int mainLine)
+{
+	if (expansion.hasLocals)
+		appendReplacing(output, expansion.text, "%%", ".M" + to_string(++localCount) + ".");
+	else
+		output.append(expansion.text);
+
+	for (auto& position: expansion.lines)
+		origins.push_back(Origin { position, call, mainLine });
+}
+
+void Preprocessor::error(Position position, string message)
+{
+	diagnostics.push_back(Diagnostic { fileNames[position.fileId], static_cast<int>(position.line), message });
+}
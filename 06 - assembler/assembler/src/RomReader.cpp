@@ -0,0 +1,126 @@
+#include "RomReader.h"
+#include "FileHandler.h"
+#include <cstring>
+
+namespace RomReader {
+
+	namespace {
+
+		uint16_t wordAt(const char* src)
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(src);
+			return bytes[0] | bytes[1] << 8;
+		}
+
+		uint32_t doubleWordAt(const char* src)
+		{
+			return wordAt(src) | uint32_t(wordAt(src + 2)) << 16;
+		}
+
+	}
+
+	RomFormat getFormat(const string& fileName)
+	{
+		if (FileHandler::hasExtension(fileName, RomWriter::getExtension(RomFormat::BINARY)))
+			return RomFormat::BINARY;
+
+		if (FileHandler::hasExtension(fileName, RomWriter::getExtension(RomFormat::BINARY_HEADER)))
+			return RomFormat::BINARY_HEADER;
+
+		return RomFormat::HACK;
+	}
+
+	bool read(string_view image, RomFormat format, vector<uint16_t>& rom, string& error)
+	{
+		if (format == RomFormat::HACK) {
+			int badLine = parseHack(image, rom);
+
+			if (badLine != 0) {
+				error = "line " + to_string(badLine) + " is not a 16 bit binary word";
+				return false;
+			}
+
+			return true;
+		}
+
+		bool header = format == RomFormat::BINARY_HEADER;
+
+		if (header) {
+			if (image.size() < RomWriter::headerSize || memcmp(image.data(), "HACK", 4) != 0) {
+				error = "missing header";
+				return false;
+			}
+
+			image.remove_prefix(RomWriter::headerSize);
+		}
+
+		if (image.size() % 2 != 0) {
+			error = "odd size of a binary image";
+			return false;
+		}
+
+		rom.resize(image.size() / 2);
+
+		for (size_t i = 0; i < rom.size(); i++)
+			rom[i] = wordAt(image.data() + i * 2);
+
+		if (header) {
+			const char* fields = image.data() - RomWriter::headerSize;
+
+			if (doubleWordAt(fields + 4) != rom.size()) {
+				error = "word count in the header does not match the image";
+				return false;
+			}
+
+			if (doubleWordAt(fields + 8) != RomWriter::checksum(rom)) {
+				error = "bad checksum";
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	int parseHack(string_view text, vector<uint16_t>& rom)
+	{
+		size_t pos = 0;
+		int lineNumber = 0;
+
+		rom.clear();
+		rom.reserve(text.size() / 17);
+
+		while (pos < text.size()) {
+			size_t end = text.find('\n', pos);
+
+			if (end == string_view::npos)
+				end = text.size();
+
+			string_view line(text.substr(pos, end - pos));
+			lineNumber++;
+			pos = end + 1;
+
+			if (!line.empty() && line.back() == '\r')
+				line.remove_suffix(1);
+
+			if (line.empty())
+				continue;
+
+			if (line.size() != 16)
+				return lineNumber;
+
+			uint16_t word = 0;
+
+			for (char c: line) {
+				if (c != '0' && c != '1')
+					return lineNumber;
+
+				word = word << 1 | (c - '0');
+			}
+
+			rom.push_back(word);
+		}
+
+		return 0;
+	}
+
+}
@@ -0,0 +1,122 @@
+#include "RomWriter.h"
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+namespace RomWriter {
+
+	namespace {
+
+		void putWord(char* dst, uint16_t word)
+		{
+			dst[0] = static_cast<char>(word & 0xff);
+			dst[1] = static_cast<char>(word >> 8);
+		}
+
+		void putDoubleWord(char* dst, uint32_t dword)
+		{
+			putWord(dst, dword & 0xffff);
+			putWord(dst + 2, dword >> 16);
+		}
+
+	}
+
+	void write(ostream& outputStream, const vector<uint16_t>& rom, RomFormat romFormat)
+	{
+		string buffer(formattedSize(rom.size(), romFormat), '\0');
+		format(&buffer[0], rom, romFormat);
+		outputStream.write(buffer.data(), buffer.size());
+	}
+
+	size_t formattedSize(size_t wordCount, RomFormat format)
+	{
+		switch (format) {
+
+			case RomFormat::HACK:
+				return wordCount * 17;
+
+			case RomFormat::BINARY:
+				return wordCount * 2;
+
+			case RomFormat::BINARY_HEADER:
+				return headerSize + wordCount * 2;
+
+		}
+
+		return 0;
+	}
+
+	void format(char* buffer, const vector<uint16_t>& rom, RomFormat format)
+	{
+		switch (format) {
+
+			case RomFormat::HACK:
+				for (size_t i = 0; i < rom.size(); i++) {
+					char* line = buffer + i * 17;
+
+					for (int bit = 0; bit < 16; bit++)
+						line[bit] = rom[i] & (0x8000 >> bit) ? '1' : '0';
+
+					line[16] = '\n';
+				}
+
+				break;
+
+			case RomFormat::BINARY_HEADER:
+				memcpy(buffer, "HACK", 4);
+				putDoubleWord(buffer + 4, rom.size());
+				putDoubleWord(buffer + 8, checksum(rom));
+				buffer += headerSize;
+				// falls through
+
+			case RomFormat::BINARY:
+				for (size_t i = 0; i < rom.size(); i++)
+					putWord(buffer + i * 2, rom[i]);
+
+				break;
+
+		}
+	}
+
+	uint32_t checksum(const vector<uint16_t>& rom)
+	{
+		uint32_t sum1 = 0xffff, sum2 = 0xffff;
+		size_t i = 0;
+
+		while (i < rom.size()) {
+			size_t block = min(rom.size() - i, size_t(359)); // largest block without overflow
+
+			for (size_t end = i + block; i < end; i++) {
+				sum1 += rom[i];
+				sum2 += sum1;
+			}
+
+			sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+			sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+		}
+
+		sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+		sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+
+		return sum2 << 16 | sum1;
+	}
+
+	string getExtension(RomFormat format)
+	{
+		switch (format) {
+
+			case RomFormat::HACK:
+				return ".hack";
+
+			case RomFormat::BINARY:
+				return ".bin";
+
+			case RomFormat::BINARY_HEADER:
+				return ".hbin";
+
+		}
+
+		return "";
+	}
+
+}
@@ -0,0 +1,261 @@
+#include "Server.h"
+#include <iostream>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Server {
+
+	namespace {
+
+		const int backlog = 16;
+
+		const int timeout = 10;						// seconds a stalled client may hold the server
+
+		const uint32_t maxStrings = 65536;			// limits of a message, against garbage
+		const uint32_t maxStringSize = 1u << 30;
+
+		volatile sig_atomic_t stopping = 0;
+
+		void stop(int)
+		{
+			stopping = 1;
+		}
+
+		bool socketAddress(string socketPath, sockaddr_un& address)
+		{
+			if (socketPath.size() >= sizeof(address.sun_path))
+				return false;
+
+			memset(&address, 0, sizeof(address));
+			address.sun_family = AF_UNIX;
+			memcpy(address.sun_path, socketPath.data(), socketPath.size());
+
+			return true;
+		}
+
+		int connectTo(string socketPath)
+		{
+			sockaddr_un address;
+
+			if (!socketAddress(socketPath, address))
+				return -1;
+
+			int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+
+			if (connection >= 0 && connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+				close(connection);
+				return -1;
+			}
+
+			return connection;
+		}
+
+		bool sendAll(int connection, const char* data, size_t size)
+		{
+			while (size > 0) {
+				ssize_t count = send(connection, data, size, MSG_NOSIGNAL);
+
+				if (count < 0 && errno == EINTR)
+					continue;
+
+				if (count <= 0)
+					return false;
+
+				data += count;
+				size -= count;
+			}
+
+			return true;
+		}
+
+		bool receiveAll(int connection, char* data, size_t size)
+		{
+			while (size > 0) {
+				ssize_t count = recv(connection, data, size, 0);
+
+				if (count < 0 && errno == EINTR)
+					continue;
+
+				if (count <= 0)
+					return false;
+
+				data += count;
+				size -= count;
+			}
+
+			return true;
+		}
+
+		void putLength(string& message, uint32_t length)
+		{
+			for (int i = 0; i < 4; i++)
+				message += static_cast<char>(length >> (8 * i));
+		}
+
+		bool sendMessage(int connection, const vector<string>& strings)
+		{
+			string message;
+			putLength(message, strings.size());
+
+			for (auto& s: strings) {
+				putLength(message, s.size());
+				message += s;
+			}
+
+			return sendAll(connection, message.data(), message.size());
+		}
+
+		bool receiveLength(int connection, uint32_t& length)
+		{
+			unsigned char bytes[4];
+
+			if (!receiveAll(connection, reinterpret_cast<char*>(bytes), sizeof(bytes)))
+				return false;
+
+			length = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | uint32_t(bytes[3]) << 24;
+			return true;
+		}
+
+		bool receiveMessage(int connection, vector<string>& strings)
+		{
+			uint32_t count;
+
+			if (!receiveLength(connection, count) || count > maxStrings)
+				return false;
+
+			strings.resize(count);
+
+			for (auto& s: strings) {
+				uint32_t size;
+
+				if (!receiveLength(connection, size) || size > maxStringSize)
+					return false;
+
+				s.resize(size);
+
+				if (!receiveAll(connection, &s[0], size))
+					return false;
+			}
+
+			return true;
+		}
+
+	}
+
+	string defaultSocketPath()
+	{
+		const char* socketPath = getenv("HASS_SOCKET");
+
+		if (socketPath != nullptr && *socketPath != '\0')
+			return socketPath;
+
+		return "/tmp/hass-" + to_string(getuid()) + ".socket";
+	}
+
+	bool serve(string socketPath, Handler handler)
+	{
+		sockaddr_un address;
+
+		if (!socketAddress(socketPath, address)) {
+			cerr << "error: socket path \"" << socketPath << "\" is too long" << endl;
+			return false;
+		}
+
+		int probe = connectTo(socketPath);
+
+		if (probe >= 0) {
+			close(probe);
+			cerr << "error: a server is already listening on \"" << socketPath << "\"" << endl;
+			return false;
+		}
+
+		unlink(socketPath.c_str()); // stale socket of a server that died
+
+		int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		mode_t mask = umask(0077); // only the user may connect
+
+		bool listening = listener >= 0 && bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0
+		                 && listen(listener, backlog) == 0;
+
+		umask(mask);
+
+		if (!listening) {
+			cerr << "error: unable to listen on socket \"" << socketPath << "\": " << strerror(errno) << endl;
+
+			if (listener >= 0)
+				close(listener);
+
+			return false;
+		}
+
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = stop; // no SA_RESTART: accept() returns when interrupted
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGINT, &action, nullptr);
+		sigaction(SIGTERM, &action, nullptr);
+
+		while (!stopping) {
+			int connection = accept(listener, nullptr, nullptr);
+
+			if (connection < 0)
+				continue;
+
+			timeval limit { timeout, 0 }; // the requests are served one at a time
+
+			setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+			setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+
+			vector<string> strings;
+
+			if (receiveMessage(connection, strings) && strings.size() >= 2) {
+				Request request { strings[0], strings[1], vector<string>(strings.begin() + 2, strings.end()) };
+				Response response;
+
+				handler(request, response);
+				sendMessage(connection, { to_string(response.status), response.output, response.errors });
+			}
+
+			close(connection);
+		}
+
+		close(listener);
+		unlink(socketPath.c_str());
+
+		return true;
+	}
+
+	bool call(string socketPath, const Request& request, Response& response)
+	{
+		int connection = connectTo(socketPath);
+
+		if (connection < 0)
+			return false;
+
+		vector<string> strings { request.workingDir, request.input };
+		strings.insert(strings.end(), request.args.begin(), request.args.end());
+
+		vector<string> reply;
+		bool received = sendMessage(connection, strings) && receiveMessage(connection, reply) && reply.size() == 3;
+
+		close(connection);
+
+		if (!received)
+			return false;
+
+		response.status = atoi(reply[0].c_str());
+		response.output = reply[1];
+		response.errors = reply[2];
+
+		return true;
+	}
+
+}
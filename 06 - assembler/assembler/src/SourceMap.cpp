@@ -0,0 +1,235 @@
+#include "SourceMap.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+	const char magic[4] = { 'H', 'M', 'A', 'P' };
+
+	const size_t headerSize = 24;
+
+	const size_t entrySize = 12;
+
+	void putDoubleWord(string& buffer, uint32_t dword)
+	{
+		for (int i = 0; i < 4; i++)
+			buffer += static_cast<char>(dword >> (8 * i));
+	}
+
+	uint32_t doubleWordAt(const char* data)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+		return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | uint32_t(bytes[3]) << 24;
+	}
+
+	string_view trim(string_view str)
+	{
+		size_t first = str.find_first_not_of(" \t\r");
+
+		if (first == string_view::npos)
+			return string_view();
+
+		return str.substr(first, str.find_last_not_of(" \t\r") - first + 1);
+	}
+
+	bool startsWith(string_view str, string_view prefix)
+	{
+		return str.substr(0, prefix.size()) == prefix;
+	}
+
+}
+
+SourceMap::SourceMap()
+	: fileTable(nullptr), lineTable(nullptr), commandTable(nullptr), fileTotal(0), lineTotal(0), commandTotal(0)
+{
+}
+
+void SourceMap::build(string_view source, const vector<int>& sourceLines, string inputName)
+{
+	unordered_map<string, uint32_t> offsets; // the command texts repeat, they are stored once
+
+	files.clear();
+	lines.clear();
+	commands.clear();
+	strings.clear();
+
+	auto addString = [this, &offsets](string_view str) {
+		auto inserted = offsets.emplace(str, strings.size());
+
+		if (inserted.second) {
+			strings.append(str.data(), str.size());
+			strings += '\0';
+		}
+
+		return inserted.first->second;
+	};
+
+	files.push_back(addString(inputName));
+
+	// finds the VM commands in the comments written by the VM translator (the source lines
+	// of the commands go in romAddress until the words are known)
+
+	vector<Entry> lineCommands;
+	bool fromVm = false;
+	uint32_t fileId = 0;
+	size_t pos = 0;
+	int lineNumber = 1;
+	size_t comment;
+
+	while ((comment = source.find("//", pos)) != string_view::npos) {
+		lineNumber += count(source.begin() + pos, source.begin() + comment, '\n');
+
+		size_t lineStart = source.rfind('\n', comment);
+		lineStart = lineStart == string_view::npos ? 0 : lineStart + 1;
+
+		size_t lineEnd = source.find('\n', comment);
+		lineEnd = lineEnd == string_view::npos ? source.size() : lineEnd;
+
+		string_view code(trim(source.substr(lineStart, comment - lineStart)));
+		string_view text(trim(source.substr(comment + 2, lineEnd - comment - 2)));
+
+		if (code.empty() && startsWith(text, "from file:")) { // header of a VM file
+			fromVm = true;
+			files.push_back(addString(trim(text.substr(10))));
+			fileId = files.size() - 1;
+		} else if (code.empty() && startsWith(text, "program:")) { // header of the program
+			fromVm = true;
+		} else if (!code.empty() && !text.empty() && fromVm) {
+			lineCommands.push_back(Entry { uint32_t(lineNumber), fileId, addString(text) });
+		}
+
+		pos = lineEnd;
+	}
+
+	// maps the words (in source order, so the commands are merged in one pass)
+
+	size_t next = 0;
+
+	for (size_t i = 0; i < sourceLines.size(); i++) {
+		uint32_t line = sourceLines[i];
+
+		if (lines.empty() || lines.back().line != line)
+			lines.push_back(Entry { uint32_t(i), 0, line });
+
+		while (next < lineCommands.size() && lineCommands[next].romAddress < line)
+			next++;
+
+		if (next < lineCommands.size() && lineCommands[next].romAddress == line) {
+			commands.push_back(Entry { uint32_t(i), lineCommands[next].fileId, lineCommands[next].line });
+			next++;
+		}
+	}
+}
+
+void SourceMap::write(ostream& outputStream) const
+{
+	string buffer(magic, sizeof(magic));
+
+	putDoubleWord(buffer, version);
+	putDoubleWord(buffer, files.size());
+	putDoubleWord(buffer, lines.size());
+	putDoubleWord(buffer, commands.size());
+	putDoubleWord(buffer, strings.size());
+
+	for (auto file: files)
+		putDoubleWord(buffer, file);
+
+	for (auto table: { &lines, &commands }) {
+		for (auto& entry: *table) {
+			putDoubleWord(buffer, entry.romAddress);
+			putDoubleWord(buffer, entry.fileId);
+			putDoubleWord(buffer, entry.line);
+		}
+	}
+
+	buffer += strings;
+
+	outputStream.write(buffer.data(), buffer.size());
+}
+
+bool SourceMap::open(string_view image)
+{
+	fileTotal = lineTotal = commandTotal = 0;
+
+	if (image.size() < headerSize || memcmp(image.data(), magic, sizeof(magic)) != 0
+	    || doubleWordAt(image.data() + 4) != version)
+		return false;
+
+	uint64_t files = doubleWordAt(image.data() + 8);
+	uint64_t lines = doubleWordAt(image.data() + 12);
+	uint64_t commands = doubleWordAt(image.data() + 16);
+	uint64_t stringsSize = doubleWordAt(image.data() + 20);
+
+	if (headerSize + files * 4 + (lines + commands) * entrySize + stringsSize != image.size())
+		return false;
+
+	fileTable = image.data() + headerSize;
+	lineTable = fileTable + files * 4;
+	commandTable = lineTable + lines * entrySize;
+	stringTable = image.substr(image.size() - stringsSize);
+
+	if (!stringTable.empty() && stringTable.back() != '\0')
+		return false;
+
+	fileTotal = files;
+	lineTotal = lines;
+	commandTotal = commands;
+
+	return true;
+}
+
+bool SourceMap::findLine(uint32_t romAddress, Entry& entry) const
+{
+	return find(lineTable, lineTotal, romAddress, entry);
+}
+
+bool SourceMap::findCommand(uint32_t romAddress, Entry& entry) const
+{
+	return find(commandTable, commandTotal, romAddress, entry);
+}
+
+string_view SourceMap::fileName(uint32_t fileId) const
+{
+	return fileId < fileTotal ? text(doubleWordAt(fileTable + fileId * 4)) : string_view();
+}
+
+string_view SourceMap::text(uint32_t offset) const
+{
+	if (offset >= stringTable.size())
+		return string_view();
+
+	return stringTable.substr(offset, stringTable.find('\0', offset) - offset);
+}
+
+size_t SourceMap::lineCount() const
+{
+	return lineTotal;
+}
+
+size_t SourceMap::commandCount() const
+{
+	return commandTotal;
+}
+
+bool SourceMap::find(const char* table, size_t count, uint32_t romAddress, Entry& entry) const
+{
+	size_t low = 0, high = count; // the record is the last one before high with address <= romAddress
+
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+
+		if (doubleWordAt(table + middle * entrySize) <= romAddress)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if (low == 0)
+		return false;
+
+	const char* record = table + (low - 1) * entrySize;
+	entry = Entry { doubleWordAt(record), doubleWordAt(record + 4), doubleWordAt(record + 8) };
+
+	return true;
+}
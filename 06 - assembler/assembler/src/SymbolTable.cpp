@@ -1,29 +1,184 @@
 #include "SymbolTable.h"
+#include <algorithm>
+#include <cstring>
 
-void SymbolTable::loadMap(map<string, int> symbolMap)
+namespace {
+
+	const size_t initialSlots = 1024;		// power of 2
+
+	const size_t arenaBlockSize = 16384;
+
+}
+
+SymbolTable::SymbolTable()
+	: slots(initialSlots),
+	  arenaNext(nullptr),
+	  arenaFree(0)
+{
+}
+
+void SymbolTable::addEntry(string_view symbol, int address)
+{
+	bool inserted;
+	findOrInsert(symbol, address, inserted);
+}
+
+bool SymbolTable::contains(string_view symbol) const
+{
+	return slots[findSlot(symbol, hashOf(symbol))].index != 0;
+}
+
+int SymbolTable::getAddress(string_view symbol) const
+{
+	const Slot& slot = slots[findSlot(symbol, hashOf(symbol))];
+	return slot.index != 0 ? entries[slot.index - 1].address : -1;
+}
+
+int SymbolTable::findOrInsert(string_view symbol, int address, bool& inserted)
+{
+	uint32_t hash = hashOf(symbol);
+	size_t slot = findSlot(symbol, hash);
+
+	inserted = slots[slot].index == 0;
+
+	if (!inserted)
+		return entries[slots[slot].index - 1].address;
+
+	return insert(slot, symbol, hash, address);
+}
+
+size_t SymbolTable::size() const
+{
+	return entries.size();
+}
+
+const vector<SymbolTable::Entry>& SymbolTable::getEntries() const
+{
+	return entries;
+}
+
+vector<const SymbolTable::Entry*> SymbolTable::getSortedEntries(size_t first, size_t last) const
+{
+	vector<const Entry*> view;
+	view.reserve(last - first);
+
+	for (size_t i = first; i < last; i++)
+		view.push_back(&entries[i]);
+
+	sort(view.begin(), view.end(), [](const Entry* a, const Entry* b) { return a->symbol < b->symbol; });
+
+	return view;
+}
+
+void SymbolTable::clear()
+{
+	fill(slots.begin(), slots.end(), Slot { 0, 0 });
+	entries.clear();
+	arena.clear();
+	arenaNext = nullptr;
+	arenaFree = 0;
+}
+
+SymbolTable::Mark SymbolTable::getMark() const
+{
+	return Mark { entries.size(), arena.size(), arenaNext, arenaFree };
+}
+
+void SymbolTable::rewind(const Mark& mark)
+{
+	if (mark.entryCount >= entries.size())
+		return;
+
+	entries.resize(mark.entryCount);
+	arena.resize(mark.blockCount);
+	arenaNext = mark.arenaNext;
+	arenaFree = mark.arenaFree;
+
+	// rehash the entries kept, in a table of the size they need
+
+	size_t slotCount = initialSlots;
+
+	while (entries.size() * 2 > slotCount)
+		slotCount *= 2;
+
+	slots.assign(slotCount, Slot { 0, 0 });
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		uint32_t hash = hashOf(entries[i].symbol);
+		slots[findSlot(entries[i].symbol, hash)] = Slot { hash, static_cast<uint32_t>(i + 1) };
+	}
+}
+
+size_t SymbolTable::findSlot(string_view symbol, uint32_t hash) const
 {
-	table.clear();
-	table = symbolMap;
+	size_t mask = slots.size() - 1;
+	size_t i = hash & mask;
+
+	while (slots[i].index != 0) {
+		if (slots[i].hash == hash && entries[slots[i].index - 1].symbol == symbol)
+			break;
+
+		i = (i + 1) & mask;
+	}
+
+	return i;
 }
 
-void SymbolTable::addEntry(string symbol, int address)
+int SymbolTable::insert(size_t slot, string_view symbol, uint32_t hash, int address)
 {
-	table.insert(pair<string, int>(symbol, address));
+	entries.push_back(Entry { intern(symbol), address });
+	slots[slot] = Slot { hash, static_cast<uint32_t>(entries.size()) };
+
+	if (entries.size() * 2 > slots.size()) // keeps the load factor under 0.5
+		grow();
+
+	return address;
 }
 
-bool SymbolTable::contains(string symbol)
+void SymbolTable::grow()
 {
-	map<string,int>::iterator it = table.find(symbol);
-	return it != table.end() ? true : false;
+	vector<Slot> oldSlots(slots.size() * 2);
+	oldSlots.swap(slots);
+
+	size_t mask = slots.size() - 1;
+
+	for (auto& slot: oldSlots) {
+		if (slot.index == 0)
+			continue;
+
+		size_t i = slot.hash & mask;
+
+		while (slots[i].index != 0)
+			i = (i + 1) & mask;
+
+		slots[i] = slot;
+	}
 }
 
-int SymbolTable::getAddress(string symbol)
+string_view SymbolTable::intern(string_view symbol)
 {
-	map<string,int>::iterator it = table.find(symbol);
-	return it != table.end() ? it->second : -1;
+	if (symbol.size() > arenaFree) {
+		arenaFree = max(arenaBlockSize, symbol.size());
+		arena.push_back(unique_ptr<char[]>(new char[arenaFree]));
+		arenaNext = arena.back().get();
+	}
+
+	char* copy = arenaNext;
+	memcpy(copy, symbol.data(), symbol.size());
+	arenaNext += symbol.size();
+	arenaFree -= symbol.size();
+
+	return string_view(copy, symbol.size());
 }
 
-map<string, int> SymbolTable::getTable()
+uint32_t SymbolTable::hashOf(string_view symbol)
 {
-	return table;
+	uint32_t hash = 2166136261u;
+
+	for (char c: symbol) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 16777619u;
+	}
+
+	return hash;
 }
@@ -0,0 +1,121 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+	: queued(0),
+	  pending(0),
+	  next(0),
+	  stopping(false)
+{
+	if (threadCount == 0)
+		threadCount = max(thread::hardware_concurrency(), 1u);
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		queues.push_back(make_unique<Queue>());
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+
+	available.notify_all();
+
+	for (thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::submit(function<void()> task)
+{
+	size_t index;
+
+	{
+		lock_guard<mutex> guard(lock);
+		index = next++ % queues.size();
+	}
+
+	{
+		lock_guard<mutex> guard(queues[index]->lock);
+		queues[index]->tasks.push_back(move(task));
+	}
+
+	{
+		lock_guard<mutex> guard(lock);
+		queued++;
+		pending++;
+	}
+
+	available.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	unique_lock<mutex> guard(lock);
+	finished.wait(guard, [this] { return pending == 0; });
+}
+
+unsigned int ThreadPool::size() const
+{
+	return workers.size();
+}
+
+void ThreadPool::run(size_t index)
+{
+	for (;;) {
+		{
+			unique_lock<mutex> guard(lock);
+			available.wait(guard, [this] { return stopping || queued > 0; });
+
+			if (queued == 0)
+				return;
+
+			queued--;
+		}
+
+		take(index)();
+
+		bool last;
+
+		{
+			lock_guard<mutex> guard(lock);
+			last = --pending == 0;
+		}
+
+		if (last)
+			finished.notify_all();
+	}
+}
+
+function<void()> ThreadPool::take(size_t index)
+{
+	for (;;) {
+		for (size_t i = 0; i < queues.size(); i++) {
+			Queue& queue = *queues[(index + i) % queues.size()];
+			lock_guard<mutex> guard(queue.lock);
+
+			if (queue.tasks.empty())
+				continue;
+
+			function<void()> task;
+
+			if (i == 0) {
+				task = move(queue.tasks.front());
+				queue.tasks.pop_front();
+			} else {
+				task = move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+
+			return task;
+		}
+
+		this_thread::yield();
+	}
+}
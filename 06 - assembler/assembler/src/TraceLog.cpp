@@ -0,0 +1,115 @@
+#include "TraceLog.h"
+
+namespace {
+
+	const size_t maxQueued = 8; // buffers queued before the writing thread waits
+
+}
+
+TraceLog::TraceLog(ostream& outputStream, size_t bufferSize)
+	: outputStream(outputStream),
+	  logStream(this),
+	  bufferSize(bufferSize),
+	  writing(false),
+	  stopping(false)
+{
+	current.resize(bufferSize);
+	setp(&current[0], &current[0] + bufferSize);
+	writer = thread([this] { run(); });
+}
+
+TraceLog::~TraceLog()
+{
+	flush();
+
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+
+	available.notify_one();
+	writer.join();
+}
+
+ostream& TraceLog::stream()
+{
+	return logStream;
+}
+
+void TraceLog::flush()
+{
+	submit();
+
+	unique_lock<mutex> guard(lock);
+	written.wait(guard, [this] { return queued.empty() && !writing; });
+	outputStream.flush();
+}
+
+TraceLog::int_type TraceLog::overflow(int_type c)
+{
+	submit();
+
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+
+	return traits_type::not_eof(c);
+}
+
+int TraceLog::sync()
+{
+	return 0;
+}
+
+void TraceLog::submit()
+{
+	size_t size = pptr() - pbase();
+
+	if (size == 0)
+		return;
+
+	current.resize(size);
+
+	{
+		unique_lock<mutex> guard(lock);
+		written.wait(guard, [this] { return queued.size() < maxQueued; });
+		queued.push_back(move(current));
+
+		if (!spare.empty()) {
+			current = move(spare.back());
+			spare.pop_back();
+		} else {
+			current = string();
+		}
+	}
+
+	available.notify_one();
+
+	current.resize(bufferSize);
+	setp(&current[0], &current[0] + bufferSize);
+}
+
+void TraceLog::run()
+{
+	unique_lock<mutex> guard(lock);
+
+	while (true) {
+		available.wait(guard, [this] { return !queued.empty() || stopping; });
+
+		if (queued.empty())
+			return;
+
+		string buffer(move(queued.front()));
+		queued.pop_front();
+		writing = true;
+
+		guard.unlock();
+		outputStream.write(buffer.data(), buffer.size());
+		guard.lock();
+
+		spare.push_back(move(buffer));
+		writing = false;
+		written.notify_all();
+	}
+}
@@ -103,8 +103,8 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
-	Assembler hass(inputFile, inputName, outputFile, outputName, verbose, veryVerbose);
-	hass.assemble();
+	AssemblerL hass(inputFile, inputName, outputFile, outputName, verbose, veryVerbose);
+	bool assembled = hass.assemble();
 
 	if (inputFile.is_open())
 		inputFile.close();
@@ -112,5 +112,5 @@ int main(int argc, char** argv)
 	if (outputFile.is_open())
 		outputFile.close();
 
-	return 0;
+	return assembled ? 0 : 1;
 }
@@ -0,0 +1,60 @@
+#ifndef BENCH_TARGET_INCLUDED_H
+#define BENCH_TARGET_INCLUDED_H
+
+#include "Stopwatch.h"
+#include <string>
+
+using namespace std;
+
+/**
+	The assembler being benchmarked. Each build target of the benchmark uses one assembler
+	and the matching implementation of these functions (TargetAssembler.cpp or
+	TargetAssemblerL.cpp).
+*/
+namespace BenchTarget
+{
+
+	/**
+		Returns the name of the assembler.
+	*/
+	const char* name();
+
+	/**
+		Does the assembler handle symbols (labels and variables)?
+	*/
+	bool hasSymbols();
+
+	/**
+		Can the passes of the assembler be run (and timed) separately?
+	*/
+	bool hasPasses();
+
+	/**
+		Assembles a program in memory, timing its first and second passes separately.
+		Only available if hasPasses().
+
+		@param source Hack assembly program.
+
+		@param firstPass Stopwatch for the first pass.
+
+		@param secondPass Stopwatch for the second pass.
+
+		@return Number of words of the assembled program.
+	*/
+	size_t assemblePasses(const string& source, Stopwatch& firstPass, Stopwatch& secondPass);
+
+	/**
+		Assembles a program from an input stream to an output stream in the .hack format,
+		as the command line assembler does.
+
+		@param source Hack assembly program.
+
+		@param endToEnd Stopwatch for the whole assembly (reading, assembling and writing).
+
+		@return Number of bytes of output.
+	*/
+	size_t assembleEndToEnd(const string& source, Stopwatch& endToEnd);
+
+};
+
+#endif // BENCH_TARGET_INCLUDED_H
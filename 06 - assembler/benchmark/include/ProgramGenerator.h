@@ -0,0 +1,93 @@
+#ifndef PROGRAM_GENERATOR_INCLUDED_H
+#define PROGRAM_GENERATOR_INCLUDED_H
+
+#include <random>
+#include <string>
+
+using namespace std;
+
+/**
+	Generates synthetic Hack assembly programs for benchmarking the assemblers. The programs
+	are valid (every instruction is legal) but meaningless. The same mix and seed always
+	generate the same program.
+*/
+class ProgramGenerator
+{
+
+	public:
+
+		/**
+			Composition of a generated program.
+		*/
+		class Mix {
+			public:
+				unsigned int aWeight = 45;			/**< Relative weight of A-instructions. */
+				unsigned int cWeight = 45;			/**< Relative weight of C-instructions. */
+				unsigned int lWeight = 10;			/**< Relative weight of labels (L_COMMAND). */
+				double symbolDensity = 0.5;			/**< Fraction of A-instructions referencing a symbol instead of a constant. */
+				double commentDensity = 0.1;		/**< Fraction of lines that are (or end with) a // comment. */
+				double blockDensity = 0.0;			/**< Fraction of lines starting a multi line comment. */
+		};
+
+		/**
+			Constructs a ProgramGenerator object.
+
+			@param mix Composition of the programs.
+
+			@param seed Seed of the pseudo-random generator.
+		*/
+		ProgramGenerator(Mix mix, unsigned int seed = 1);
+
+		/**
+			Generates a program.
+
+			@param lineCount Number of lines of the program (the last multi line comment may
+			add a few more, and so may the labels referenced but not defined when the lines
+			ran out, which end the program so that every reference is to a label).
+
+			@return The program.
+		*/
+		string generate(size_t lineCount);
+
+	private:
+
+		/**
+			Appends an A-instruction to the program.
+		*/
+		void appendACommand(string& program);
+
+		/**
+			Appends a C-instruction to the program.
+		*/
+		void appendCCommand(string& program);
+
+		/**
+			Appends a comment (and a line break) to the program.
+		*/
+		void appendComment(string& program);
+
+		/**
+			Appends a multi line comment of a few lines to the program.
+
+			@return Number of lines of the comment.
+		*/
+		size_t appendBlockComment(string& program);
+
+		/**
+			Returns true with the given probability.
+		*/
+		bool chance(double probability);
+
+		Mix mix;							/**< Composition of the programs. */
+
+		mt19937 random;						/**< Pseudo-random generator. */
+
+		size_t labelCount;					/**< Labels defined so far. */
+
+		size_t expectedLabels;				/**< Labels expected in the whole program (to reference labels defined further on). */
+
+		size_t referencedLabels;			/**< Labels referenced so far (the highest number plus one). */
+
+};
+
+#endif // PROGRAM_GENERATOR_INCLUDED_H
@@ -0,0 +1,68 @@
+#ifndef STOPWATCH_INCLUDED_H
+#define STOPWATCH_INCLUDED_H
+
+#include <chrono>
+#include <cstddef>
+
+using namespace std;
+
+/**
+	Measures the time spent and the memory allocations made between calls to start() and
+	stop(). Several measurements accumulate until reset() is called.
+
+	Allocations are counted by replacing the global operator new of the program, so they
+	include every allocation made by the code being measured.
+*/
+class Stopwatch
+{
+
+	public:
+
+		/**
+			Constructs a Stopwatch object with nothing measured.
+		*/
+		Stopwatch();
+
+		/**
+			Starts a measurement.
+		*/
+		void start();
+
+		/**
+			Stops the current measurement, adding it to the totals.
+		*/
+		void stop();
+
+		/**
+			Clears the totals.
+		*/
+		void reset();
+
+		/**
+			Returns the time measured, in seconds.
+		*/
+		double getSeconds() const;
+
+		/**
+			Returns the number of memory allocations measured.
+		*/
+		size_t getAllocations() const;
+
+		/**
+			Returns the number of memory allocations made by the program so far.
+		*/
+		static size_t allocationCount();
+
+	private:
+
+		chrono::steady_clock::time_point startTime;		/**< Time at start(). */
+
+		size_t startAllocations;						/**< Allocation count at start(). */
+
+		double seconds;									/**< Time measured. */
+
+		size_t allocations;								/**< Allocations measured. */
+
+};
+
+#endif // STOPWATCH_INCLUDED_H
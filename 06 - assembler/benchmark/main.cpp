@@ -0,0 +1,220 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <cstdlib>
+#include "BenchTarget.h"
+#include "ProgramGenerator.h"
+#include "Stopwatch.h"
+
+using namespace std;
+
+/**
+	Options of the benchmark, read from the command line arguments.
+*/
+class Flags
+{
+	public:
+		vector<size_t> sizes = { 10000, 1000000, 10000000 };	/**< Lines of the generated programs. */
+		ProgramGenerator::Mix mix;								/**< Composition of the generated programs. */
+		unsigned int repeats = 3;								/**< Runs of every measurement (the best one is reported). */
+		unsigned int seed = 1;									/**< Seed of the generator. */
+		bool generateOnly = false;								/**< Prints the first program instead of benchmarking. */
+};
+
+/**
+	Gets the flags from the command line arguments.
+
+	@param argc Number of command line arguments.
+
+	@param argv Array of arguments.
+
+	@param flags Flags. Their values will be affected by the arguments.
+
+	@return Returns false if an unidentified or malformed flag is present in the arguments.
+	True otherwise.
+*/
+bool getFlags(int argc, char** argv, Flags& flags)
+{
+	int c;
+	char sep1, sep2;
+	string item;
+	istringstream list;
+
+	while ((c = getopt(argc, argv, "n:m:s:c:b:r:S:g")) != -1) {
+
+		switch (c) {
+
+			case 'n':
+				flags.sizes.clear();
+				list.clear();
+				list.str(optarg);
+
+				while (getline(list, item, ','))
+					flags.sizes.push_back(strtoul(item.c_str(), nullptr, 10));
+
+				break;
+
+			case 'm':
+				list.clear();
+				list.str(optarg);
+
+				if (!(list >> flags.mix.aWeight >> sep1 >> flags.mix.cWeight >> sep2 >> flags.mix.lWeight)
+				    || sep1 != ':' || sep2 != ':') {
+					cerr << "error: mix must be given as A:C:L weights (for instance 45:45:10)" << endl;
+					return false;
+				}
+
+				break;
+
+			case 's':
+				flags.mix.symbolDensity = atof(optarg);
+				break;
+
+			case 'c':
+				flags.mix.commentDensity = atof(optarg);
+				break;
+
+			case 'b':
+				flags.mix.blockDensity = atof(optarg);
+				break;
+
+			case 'r':
+				flags.repeats = max(atoi(optarg), 1);
+				break;
+
+			case 'S':
+				flags.seed = atoi(optarg);
+				break;
+
+			case 'g':
+				flags.generateOnly = true;
+				break;
+
+			case '?':
+				return false;
+
+		}
+	}
+
+	return true;
+}
+
+/**
+	Prints a row of results.
+
+	@param lines Lines of the program.
+
+	@param bytes Size of the program.
+
+	@param phase Name of the phase measured.
+
+	@param stopwatch Best measurement of the phase.
+*/
+void printRow(size_t lines, size_t bytes, string phase, const Stopwatch& stopwatch)
+{
+	double seconds = max(stopwatch.getSeconds(), 1e-9);
+
+	cout << setw(10) << right << lines << setw(12) << bytes << "  " << setw(12) << left << phase << right;
+	cout << fixed << setprecision(3) << setw(12) << seconds * 1e3;
+	cout << setprecision(0) << setw(14) << lines / seconds;
+	cout << setprecision(1) << setw(10) << bytes / seconds / 1e6;
+	cout << setprecision(3) << setw(13) << double(stopwatch.getAllocations()) / lines << endl;
+}
+
+/**
+	Runs a measurement several times, keeping the fastest run.
+
+	@param repeats Number of runs.
+
+	@param best Stopwatch receiving the fastest run.
+
+	@param run Function running the measurement on the stopwatch it receives.
+*/
+template<typename Run>
+void measureBest(unsigned int repeats, Stopwatch& best, Run run)
+{
+	for (unsigned int i = 0; i < repeats; i++) {
+		Stopwatch stopwatch;
+		run(stopwatch);
+
+		if (i == 0 || stopwatch.getSeconds() < best.getSeconds())
+			best = stopwatch;
+	}
+}
+
+/**
+
+*/
+int main(int argc, char** argv)
+{
+	Flags flags;
+
+	if (!getFlags(argc, argv, flags)) {
+		cerr << "usage: " << "hass-bench" << " [-n lines,...] [-m A:C:L] [-s density] [-c density] [-b density] [-r runs] [-S seed] [-g]" << endl;
+		cerr << "       -n sizes of the generated programs, in lines (default 10000,1000000,10000000)" << endl;
+		cerr << "       -m relative weights of A-instructions, C-instructions and labels (default 45:45:10)" << endl;
+		cerr << "       -s fraction of A-instructions referencing symbols (default 0.5)" << endl;
+		cerr << "       -c fraction of lines with // comments (default 0.1)" << endl;
+		cerr << "       -b fraction of lines starting a multi line comment (default 0)" << endl;
+		cerr << "       -r runs of every measurement, the fastest is reported (default 3)" << endl;
+		cerr << "       -S seed of the generator (default 1)" << endl;
+		cerr << "       -g print the first program to the standard output instead of benchmarking" << endl;
+		return 1;
+	}
+
+	if (!BenchTarget::hasSymbols()) { // symbol-less assembler: constants only
+		flags.mix.lWeight = 0;
+		flags.mix.symbolDensity = 0;
+	}
+
+	if (flags.generateOnly) {
+		cout << ProgramGenerator(flags.mix, flags.seed).generate(flags.sizes.empty() ? 0 : flags.sizes.front());
+		return 0;
+	}
+
+	cout << "benchmark of " << BenchTarget::name();
+	cout << " (A:C:L " << flags.mix.aWeight << ":" << flags.mix.cWeight << ":" << flags.mix.lWeight;
+	cout << fixed << setprecision(2) << ", symbols " << flags.mix.symbolDensity;
+	cout << ", comments " << flags.mix.commentDensity << ", multi line comments " << flags.mix.blockDensity;
+	cout << ", best of " << flags.repeats << ")" << endl << endl;
+
+	cout << setw(10) << "lines" << setw(12) << "bytes" << "  " << setw(12) << left << "phase" << right;
+	cout << setw(12) << "time (ms)" << setw(14) << "lines/s" << setw(10) << "MB/s" << setw(13) << "allocs/line" << endl;
+
+	for (size_t lines: flags.sizes) {
+		if (lines == 0)
+			continue;
+
+		string source = ProgramGenerator(flags.mix, flags.seed).generate(lines);
+
+		if (BenchTarget::hasPasses()) {
+			Stopwatch firstPass, secondPass;
+
+			measureBest(flags.repeats, firstPass, [&](Stopwatch& stopwatch) {
+				Stopwatch unused;
+				BenchTarget::assemblePasses(source, stopwatch, unused);
+			});
+
+			measureBest(flags.repeats, secondPass, [&](Stopwatch& stopwatch) {
+				Stopwatch unused;
+				BenchTarget::assemblePasses(source, unused, stopwatch);
+			});
+
+			printRow(lines, source.size(), "first pass", firstPass);
+			printRow(lines, source.size(), "second pass", secondPass);
+		}
+
+		Stopwatch endToEnd;
+
+		measureBest(flags.repeats, endToEnd, [&](Stopwatch& stopwatch) {
+			BenchTarget::assembleEndToEnd(source, stopwatch);
+		});
+
+		printRow(lines, source.size(), "end to end", endToEnd);
+	}
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include "ProgramGenerator.h"
+#include <algorithm>
+
+namespace {
+
+	const char* const dests[] = { "", "M=", "D=", "MD=", "A=", "AM=", "AD=", "AMD=" };
+
+	const char* const comps[] = {
+		"0", "1", "-1", "D", "A", "!D", "!A", "-D", "-A", "D+1", "A+1", "D-1", "A-1",
+		"D+A", "D-A", "A-D", "D&A", "D|A", "M", "!M", "-M", "M+1", "M-1", "D+M", "D-M",
+		"M-D", "D&M", "D|M"
+	};
+
+	const char* const jumps[] = { "", ";JGT", ";JEQ", ";JGE", ";JLT", ";JNE", ";JLE", ";JMP" };
+
+	const char* const words[] = {
+		"loop", "over", "the", "screen", "and", "store", "the", "result", "in", "memory",
+		"decrement", "counter", "then", "jump", "back", "if", "not", "zero"
+	};
+
+	const size_t variableCount = 1000; // distinct variables referenced by the programs
+
+}
+
+ProgramGenerator::ProgramGenerator(Mix mix, unsigned int seed)
+	: mix(mix),
+	  random(seed),
+	  labelCount(0),
+	  expectedLabels(0),
+	  referencedLabels(0)
+{
+}
+
+string ProgramGenerator::generate(size_t lineCount)
+{
+	string program;
+	program.reserve(lineCount * 12);
+
+	unsigned int totalWeight = mix.aWeight + mix.cWeight + mix.lWeight;
+	labelCount = 0;
+	referencedLabels = 0;
+	expectedLabels = totalWeight == 0 ? 0 : lineCount * mix.lWeight / totalWeight;
+
+	for (size_t line = 0; line < lineCount; line++) {
+
+		if (chance(mix.blockDensity)) {
+			line += appendBlockComment(program) - 1;
+			continue;
+		}
+
+		if (totalWeight == 0 || chance(mix.commentDensity / 2)) {
+			appendComment(program);
+			continue;
+		}
+
+		unsigned int pick = uniform_int_distribution<unsigned int>(0, totalWeight - 1)(random);
+
+		if (pick < mix.aWeight) {
+			appendACommand(program);
+		} else if (pick < mix.aWeight + mix.cWeight) {
+			appendCCommand(program);
+		} else {
+			program += "(L" + to_string(labelCount++) + ")";
+		}
+
+		if (chance(mix.commentDensity / 2)) {
+			program += "    ";
+			appendComment(program);
+		} else {
+			program += '\n';
+		}
+	}
+
+	// the labels referenced further on than the program went (comments took their lines)
+
+	while (labelCount < referencedLabels)
+		program += "(L" + to_string(labelCount++) + ")\n";
+
+	return program;
+}
+
+void ProgramGenerator::appendACommand(string& program)
+{
+	program += "    @";
+
+	if (!chance(mix.symbolDensity)) {
+		program += to_string(uniform_int_distribution<int>(0, 32767)(random));
+	} else if (expectedLabels > 0 && chance(0.5)) {
+		size_t label = uniform_int_distribution<size_t>(0, expectedLabels - 1)(random);
+		referencedLabels = max(referencedLabels, label + 1);
+		program += "L" + to_string(label);
+	} else {
+		program += "var" + to_string(uniform_int_distribution<size_t>(0, variableCount - 1)(random));
+	}
+}
+
+void ProgramGenerator::appendCCommand(string& program)
+{
+	const char* dest = dests[uniform_int_distribution<size_t>(0, size(dests) - 1)(random)];
+	const char* jump = *dest != '\0' ? "" : jumps[uniform_int_distribution<size_t>(1, size(jumps) - 1)(random)];
+
+	program += "    ";
+	program += dest;
+	program += comps[uniform_int_distribution<size_t>(0, size(comps) - 1)(random)];
+	program += jump;
+}
+
+void ProgramGenerator::appendComment(string& program)
+{
+	program += "//";
+
+	for (int i = uniform_int_distribution<int>(1, 6)(random); i > 0; i--) {
+		program += ' ';
+		program += words[uniform_int_distribution<size_t>(0, size(words) - 1)(random)];
+	}
+
+	program += '\n';
+}
+
+size_t ProgramGenerator::appendBlockComment(string& program)
+{
+	size_t lines = uniform_int_distribution<size_t>(2, 5)(random);
+
+	program += "/*";
+
+	for (size_t i = 1; i < lines; i++) {
+		program += " ";
+		program += words[uniform_int_distribution<size_t>(0, size(words) - 1)(random)];
+		program += "\n  ";
+	}
+
+	program += "*/\n";
+
+	return lines;
+}
+
+bool ProgramGenerator::chance(double probability)
+{
+	return probability > 0 && uniform_real_distribution<double>(0, 1)(random) < probability;
+}
@@ -0,0 +1,86 @@
+#include "Stopwatch.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+	atomic<size_t> allocationTotal(0);
+
+}
+
+void* operator new(size_t size)
+{
+	allocationTotal.fetch_add(1, memory_order_relaxed);
+
+	if (void* p = malloc(size == 0 ? 1 : size))
+		return p;
+
+	throw bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+Stopwatch::Stopwatch()
+	: startAllocations(0),
+	  seconds(0),
+	  allocations(0)
+{
+}
+
+void Stopwatch::start()
+{
+	startAllocations = allocationCount();
+	startTime = chrono::steady_clock::now();
+}
+
+void Stopwatch::stop()
+{
+	auto stopTime = chrono::steady_clock::now();
+	allocations += allocationCount() - startAllocations;
+	seconds += chrono::duration<double>(stopTime - startTime).count();
+}
+
+void Stopwatch::reset()
+{
+	seconds = 0;
+	allocations = 0;
+}
+
+double Stopwatch::getSeconds() const
+{
+	return seconds;
+}
+
+size_t Stopwatch::getAllocations() const
+{
+	return allocations;
+}
+
+size_t Stopwatch::allocationCount()
+{
+	return allocationTotal.load(memory_order_relaxed);
+}
@@ -0,0 +1,52 @@
+#include "BenchTarget.h"
+#include "Assembler.h"
+#include <sstream>
+
+namespace BenchTarget {
+
+	const char* name()
+	{
+		return "assembler";
+	}
+
+	bool hasSymbols()
+	{
+		return true;
+	}
+
+	bool hasPasses()
+	{
+		return true;
+	}
+
+	size_t assemblePasses(const string& source, Stopwatch& firstPass, Stopwatch& secondPass)
+	{
+		Assembler hass(string_view(source), "bench.asm", "bench.hack");
+		hass.setErrorStream(nullptr);
+
+		firstPass.start();
+		hass.assembleFirstPass();
+		firstPass.stop();
+
+		secondPass.start();
+		hass.assembleSecondPass();
+		secondPass.stop();
+
+		return hass.getRom().size();
+	}
+
+	size_t assembleEndToEnd(const string& source, Stopwatch& endToEnd)
+	{
+		istringstream input(source);
+		ostringstream output;
+
+		endToEnd.start();
+		Assembler hass(input, "bench.asm", output, "bench.hack");
+		hass.setErrorStream(nullptr);
+		hass.assemble();
+		endToEnd.stop();
+
+		return output.tellp();
+	}
+
+}
@@ -0,0 +1,41 @@
+#include "BenchTarget.h"
+#include "Assembler.h"
+#include <sstream>
+
+namespace BenchTarget {
+
+	const char* name()
+	{
+		return "assemblerL";
+	}
+
+	bool hasSymbols()
+	{
+		return false;
+	}
+
+	bool hasPasses()
+	{
+		return false;
+	}
+
+	size_t assemblePasses(const string&, Stopwatch&, Stopwatch&)
+	{
+		return 0;
+	}
+
+	size_t assembleEndToEnd(const string& source, Stopwatch& endToEnd)
+	{
+		istringstream input(source);
+		ostringstream output;
+
+		endToEnd.start();
+		AssemblerL hass(input, "bench.asm", output, "bench.hack");
+		hass.setErrorStream(nullptr);
+		hass.assemble();
+		endToEnd.stop();
+
+		return output.tellp();
+	}
+
+}
@@ -0,0 +1,88 @@
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <climits>
+#include "Server.h"
+
+using namespace std;
+
+/**
+	Writes a whole buffer to a file descriptor.
+
+	@param fd File descriptor.
+
+	@param data Buffer to be written.
+*/
+void writeAll(int fd, const string& data)
+{
+	size_t done = 0;
+
+	while (done < data.size()) {
+		ssize_t count = write(fd, data.data() + done, data.size() - done);
+
+		if (count <= 0)
+			return;
+
+		done += count;
+	}
+}
+
+/**
+	Reads the whole standard input.
+
+	@return The contents of the standard input.
+*/
+string readStdin()
+{
+	string input;
+	char block[65536];
+	ssize_t count;
+
+	while ((count = read(STDIN_FILENO, block, sizeof(block))) > 0)
+		input.append(block, count);
+
+	return input;
+}
+
+/**
+	Thin client of "hass --serve": sends its command line (same arguments as hass) to the
+	server, which assembles in its own warm process, and prints what the server replies. If no
+	server is listening on the socket ($HASS_SOCKET or the default one), hass is run instead.
+*/
+int main(int argc, char** argv)
+{
+	Server::Request request;
+	request.args.assign(argv + 1, argv + argc);
+
+	char workingDir[PATH_MAX];
+
+	if (getcwd(workingDir, sizeof(workingDir)) != nullptr)
+		request.workingDir = workingDir;
+
+	for (auto& arg: request.args) {
+		if (arg == "-") { // the input is the standard input
+			request.input = readStdin();
+			break;
+		}
+	}
+
+	Server::Response response;
+
+	if (request.workingDir.empty() || !Server::call(Server::defaultSocketPath(), request, response)) {
+		if (!request.input.empty()) {
+			writeAll(STDERR_FILENO, "error: no hass server is running (start one with hass --serve)\n");
+			return 1;
+		}
+
+		argv[0] = const_cast<char*>("hass");
+		execvp("hass", argv);
+
+		writeAll(STDERR_FILENO, "error: no hass server is running and hass could not be run\n");
+		return 1;
+	}
+
+	writeAll(STDOUT_FILENO, response.output);
+	writeAll(STDERR_FILENO, response.errors);
+
+	return response.status;
+}
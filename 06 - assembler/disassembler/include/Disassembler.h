@@ -0,0 +1,104 @@
+#ifndef DISASSEMBLER_INCLUDED_H
+#define DISASSEMBLER_INCLUDED_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Code.h"
+
+using namespace std;
+
+/**
+	Turns Hack machine code back into assembly that assembles to the same words. C-instructions
+	are decoded with the 64K-entry table of Code::cMnemonic(); A-instructions are printed as
+	numbers unless symbols are given (see addSymbol() and readSymbolTable()).
+
+	A symbol table does not tell labels from variables, so the program tells them apart: a
+	symbol is a variable if its address is 16 or more and some A-instruction loading it is
+	followed by a memory access, if its address is past the end of the program, or if it is
+	the only symbol at an address below the highest variable (the assembler leaves no gaps
+	between variables); it is a label otherwise (labels are written before the instruction
+	they point to). No two variables share an address.
+	Since the assembler allocates variables in order of first use from address 16, a variable
+	name is only used where that order gives it back its address; elsewhere the address is
+	printed as a number, so the output always reassembles to the same machine code.
+*/
+class Disassembler
+{
+
+	public:
+
+		/**
+			Constructs a Disassembler object with no symbols.
+		*/
+		Disassembler();
+
+		/**
+			Adds a symbol used to name the A-instructions.
+
+			@param name Name of the symbol.
+
+			@param address ROM address (labels) or RAM address (variables, predefined symbols).
+
+			@param predefined Is it one of the Hack predefined symbols? They only name memory
+			accesses (and SCREEN and KBD also their addresses).
+		*/
+		void addSymbol(string name, uint16_t address, bool predefined);
+
+		/**
+			Reads a symbol table in the format written by Hass::outputSymbolTable() ("hass -t").
+
+			@param symInputStream Input stream with the symbol table.
+
+			@return True if the table was read. False if a line is not a symbol.
+		*/
+		bool readSymbolTable(istream& symInputStream);
+
+		/**
+			Disassembles a program. Words that are not instructions the assembler can produce
+			are left out.
+
+			@param rom Machine code.
+
+			@param output Receives the assembly (appended).
+
+			@param errorStream Stream the words left out are reported to (null: not reported).
+
+			@return True if every word was disassembled. False otherwise.
+		*/
+		bool disassemble(const vector<uint16_t>& rom, string& output, ostream* errorStream = &cerr);
+
+	private:
+
+		/**
+			A symbol given to the disassembler.
+		*/
+		class Symbol {
+			public:
+				string name;			/**< Name of the symbol. */
+				uint16_t address;		/**< Address of the symbol. */
+				bool predefined;		/**< Is it a predefined symbol? */
+		};
+
+		/**
+			How an A-instruction uses its value, from the instruction that follows it.
+		*/
+		enum Use {
+			USE_VALUE,					/**< As data (D=A) or not at all. */
+			USE_MEMORY,					/**< As memory address (M). */
+			USE_JUMP					/**< As jump target only. */
+		};
+
+		/**
+			Returns how the A-instruction at an address uses its value.
+		*/
+		Use useOf(const vector<uint16_t>& rom, size_t address) const;
+
+		vector<Symbol> symbols;			/**< Symbols, in the order they were given. */
+
+		Code code;						/**< Decoder of C-instructions. */
+
+};
+
+#endif // DISASSEMBLER_INCLUDED_H
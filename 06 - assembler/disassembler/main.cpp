@@ -0,0 +1,362 @@
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <unistd.h>
+#include "Disassembler.h"
+#include "FileHandler.h"
+#include "Hass.h"
+#include "MappedFile.h"
+#include "RomReader.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+	Options of the disassembler, read from the command line arguments.
+*/
+class Flags
+{
+	public:
+		bool verbose = false;					/**< Verbose flag. */
+		bool roundTrip = false;					/**< Round-trip verification flag. */
+		string symInputName;					/**< Symbol table naming the addresses (empty: none). */
+		string outputName;						/**< Name of the output file (empty: standard output). */
+		unsigned int threads = 0;				/**< Threads of the round-trip verification (0: one per core). */
+};
+
+/**
+	Outcome of the round-trip verification of a file.
+*/
+class Check
+{
+	public:
+		bool ok = false;						/**< Is the machine code the same after the round trip? */
+		size_t words = 0;						/**< Words of the program. */
+		size_t bytes = 0;						/**< Size of the input file. */
+		string message;							/**< What went wrong (or what was checked, in verbose mode). */
+};
+
+/**
+	Gets the flags from the command line arguments.
+
+	@param argc Number of command line arguments.
+
+	@param argv Array of arguments.
+
+	@param flags Flags. Their values will be affected by the arguments.
+
+	@return Returns false if an unidentified flag is present in the arguments.
+	True otherwise.
+*/
+bool getFlags(int argc, char** argv, Flags& flags)
+{
+	int c;
+
+	while ((c = getopt(argc, argv, "vrs:o:j:")) != -1) {
+
+        switch (c) {
+
+            case 'v':
+                flags.verbose = true;
+                break;
+
+            case 'r':
+                flags.roundTrip = true;
+                break;
+
+            case 's':
+                flags.symInputName = optarg;
+                break;
+
+            case 'o':
+                flags.outputName = optarg;
+                break;
+
+            case 'j':
+                flags.threads = atoi(optarg);
+                break;
+
+            case '?':
+                return false;
+
+        }
+    }
+
+	return true;
+}
+
+/**
+	Reads a .hack file.
+
+	@param inputName Name of the input file.
+
+	@param rom Receives the machine code.
+
+	@param message Receives the error, if any.
+
+	@return True if the file was read. False otherwise.
+*/
+bool readHack(string inputName, vector<uint16_t>& rom, string& message)
+{
+	MappedFile inputFile;
+
+	if (!inputFile.openRead(inputName)) {
+		message = "unable to open input file \"" + inputName + "\"";
+		return false;
+	}
+
+	int badLine = RomReader::parseHack(inputFile.view(), rom);
+
+	if (badLine != 0) {
+		message = "\"" + inputName + "\", line " + to_string(badLine) + ": not a 16 bit binary word";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+	Checks that a program survives a round trip: an .asm file is assembled, disassembled with
+	its own symbols and assembled again (asm, hack, asm, hack); a .hack file is disassembled
+	(with the symbols of "hass -t" next to it, if any) and assembled again. The machine code
+	must be the same, bit for bit.
+
+	@param inputName Name of the .asm or .hack file.
+
+	@return The outcome of the check.
+*/
+Check roundTrip(string inputName)
+{
+	Check check;
+	vector<uint16_t> rom;
+	Disassembler disassembler;
+
+	if (FileHandler::hasExtension(inputName, ".asm")) {
+		MappedFile inputFile;
+
+		if (!inputFile.openRead(inputName)) {
+			check.message = "unable to open input file \"" + inputName + "\"";
+			return check;
+		}
+
+		Hass::Result result = Hass::assemble(inputFile.view());
+		check.bytes = inputFile.size();
+
+		if (!result.ok) {
+			check.message = "\"" + inputName + "\" does not assemble (line " + to_string(result.diagnostics[0].line) + ": "
+			                + result.diagnostics[0].message + ")";
+			return check;
+		}
+
+		for (auto& symbol: result.symbols)
+			disassembler.addSymbol(symbol.name, symbol.address, symbol.predefined);
+
+		rom.swap(result.rom);
+	} else {
+		if (!readHack(inputName, rom, check.message))
+			return check;
+
+		check.bytes = rom.size() * 17;
+
+		ifstream symInputFile(FileHandler::changeExtension(inputName, "-symbols"));
+
+		if (symInputFile.good() && !disassembler.readSymbolTable(symInputFile)) {
+			check.message = "invalid symbol table for \"" + inputName + "\"";
+			return check;
+		}
+	}
+
+	check.words = rom.size();
+
+	string source;
+
+	if (!disassembler.disassemble(rom, source, nullptr)) {
+		check.message = "\"" + inputName + "\" has words that are not Hack instructions";
+		return check;
+	}
+
+	Hass::Result result = Hass::assemble(source);
+
+	if (!result.ok) {
+		check.message = "disassembly of \"" + inputName + "\" does not assemble (line " + to_string(result.diagnostics[0].line)
+		                + ": " + result.diagnostics[0].message + ")";
+		return check;
+	}
+
+	if (result.rom != rom) {
+		size_t i = 0;
+
+		while (i < rom.size() && i < result.rom.size() && rom[i] == result.rom[i])
+			i++;
+
+		check.message = "\"" + inputName + "\" differs after the round trip at word " + to_string(i);
+		return check;
+	}
+
+	check.ok = true;
+	check.message = inputName + ": " + to_string(rom.size()) + " words";
+
+	return check;
+}
+
+/**
+	Verifies the round trip of the inputs, in parallel.
+
+	@param args Input files and directories (their .asm and .hack files are checked).
+
+	@param flags Flags from the command line.
+
+	@return The exit status of the disassembler.
+*/
+int roundTripInputs(const vector<string>& args, const Flags& flags)
+{
+	vector<string> inputNames;
+
+	for (auto& arg: args) {
+		if (FileHandler::isDirectory(arg)) {
+			for (auto extension: { ".asm", ".hack" }) {
+				vector<string> files(FileHandler::listFiles(arg, extension));
+				inputNames.insert(inputNames.end(), files.begin(), files.end());
+			}
+		} else if (FileHandler::isFile(arg)) {
+			inputNames.push_back(arg);
+		} else {
+			cerr << "error: input \"" << arg << "\" is not a file or directory" << endl;
+			return 1;
+		}
+	}
+
+	if (inputNames.empty()) {
+		cerr << "error: no .asm or .hack files found" << endl;
+		return 1;
+	}
+
+	auto start = chrono::steady_clock::now();
+	vector<Check> checks(inputNames.size());
+
+	{
+		ThreadPool pool(flags.threads);
+
+		for (size_t i = 0; i < inputNames.size(); i++)
+			pool.submit([&checks, &inputNames, i]() { checks[i] = roundTrip(inputNames[i]); });
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	size_t failed = 0, words = 0, bytes = 0;
+
+	for (auto& check: checks) {
+		if (!check.ok)
+			cerr << "error: " << check.message << endl;
+		else if (flags.verbose)
+			cout << check.message << endl;
+
+		failed += !check.ok;
+		words += check.words;
+		bytes += check.bytes;
+	}
+
+	cout << checks.size() - failed << " of " << checks.size() << " files round-trip (" << words << " words, "
+	     << static_cast<size_t>(bytes / 1e6 / max(seconds, 1e-9)) << " MB/s)" << endl;
+
+	return failed == 0 ? 0 : 1;
+}
+
+/**
+	Disassembles a .hack file.
+
+	@param inputName Name of the input file.
+
+	@param flags Flags from the command line.
+
+	@return The exit status of the disassembler.
+*/
+int disassembleFile(string inputName, const Flags& flags)
+{
+	Disassembler disassembler;
+	vector<uint16_t> rom;
+	string message;
+
+	if (!flags.symInputName.empty()) {
+		ifstream symInputFile(flags.symInputName);
+
+		if (!symInputFile.good()) {
+			cerr << "error: unable to open symbol table \"" << flags.symInputName << "\"" << endl;
+			return 1;
+		}
+
+		if (!disassembler.readSymbolTable(symInputFile)) {
+			cerr << "error: \"" << flags.symInputName << "\" is not a symbol table (write one with hass -t)" << endl;
+			return 1;
+		}
+	}
+
+	if (!readHack(inputName, rom, message)) {
+		cerr << "error: " << message << endl;
+		return 1;
+	}
+
+	string source;
+	bool disassembled = disassembler.disassemble(rom, source);
+
+	if (flags.outputName.empty()) {
+		cout << source;
+	} else {
+		ofstream outputFile(flags.outputName, ios::binary);
+
+		if (!outputFile.good()) {
+			cerr << "error: unable to open output file \"" << flags.outputName << "\"" << endl;
+			return 1;
+		}
+
+		outputFile << source;
+	}
+
+	if (flags.verbose)
+		cerr << inputName << ": " << rom.size() << " words disassembled" << endl;
+
+	return disassembled ? 0 : 1;
+}
+
+/**
+	Disassembles .hack files back into Hack assembly, or verifies that programs survive the
+	round trip through the assembler and the disassembler.
+*/
+int main(int argc, char** argv)
+{
+	if (argc == 1) {
+		cerr << "usage: " << "hdis" << " [-v] [-s symbols] [-o output] input.hack" << endl;
+		cerr << "       " << "hdis" << " -r [-v] [-j threads] input..." << endl;
+		cerr << "       -v verbose" << endl;
+		cerr << "       -s symbol table written by hass -t, naming labels and variables" << endl;
+		cerr << "       -o output file (default: standard output)" << endl;
+		cerr << "       -r round trip: checks that .asm (asm, hack, asm, hack) and .hack files (hack," << endl;
+		cerr << "          asm, hack) assemble to the same words after disassembling; directories" << endl;
+		cerr << "          are checked whole, and a .hack file uses the -symbols file next to it" << endl;
+		cerr << "       -j number of threads of the round trip (default: one per core)" << endl;
+		return 1;
+	}
+
+	Flags flags;
+
+	if (!getFlags(argc, argv, flags))
+		return 1;
+
+	if (optind >= argc) {
+		cerr << "error: no input files" << endl;
+		return 1;
+	}
+
+	vector<string> args(argv + optind, argv + argc);
+
+	if (flags.roundTrip)
+		return roundTripInputs(args, flags);
+
+	if (args.size() > 1) {
+		cerr << "error: only one input can be disassembled at a time (use -r to check several)" << endl;
+		return 1;
+	}
+
+	return disassembleFile(args[0], flags);
+}
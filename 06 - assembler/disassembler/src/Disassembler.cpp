@@ -0,0 +1,216 @@
+#include "Disassembler.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+	const size_t addressCount = 32768;
+
+	const uint16_t firstVariable = 16;
+
+	const uint16_t cInstruction = 0x8000;
+
+	const uint16_t compReadsM = 0x1000;
+
+	const uint16_t destM = 0x0008;
+
+	const uint16_t jumpBits = 0x0007;
+
+	/**
+		Is the name one of R0...R15? They are the least descriptive of the predefined names.
+	*/
+	bool isRegisterName(const string& name)
+	{
+		return name.size() >= 2 && name[0] == 'R' && name.find_first_not_of("0123456789", 1) == string::npos;
+	}
+
+	void appendLine(string& output, const char* prefix, const string& text, const char* suffix)
+	{
+		output += prefix;
+		output += text;
+		output += suffix;
+	}
+
+}
+
+Disassembler::Disassembler()
+{
+}
+
+void Disassembler::addSymbol(string name, uint16_t address, bool predefined)
+{
+	symbols.push_back(Symbol { name, address, predefined });
+}
+
+bool Disassembler::readSymbolTable(istream& symInputStream)
+{
+	string line;
+	bool predefined = false;
+
+	while (getline(symInputStream, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		if (line.empty())
+			continue;
+
+		if (line.compare(0, 5, "**** ") == 0) { // header of a section
+			predefined = line == "**** predefined symbols:";
+			continue;
+		}
+
+		istringstream fields(line);
+		unsigned int address;
+		string name;
+
+		if (!(fields >> hex >> address >> name) || address >= addressCount)
+			return false;
+
+		addSymbol(name, address, predefined);
+	}
+
+	return true;
+}
+
+bool Disassembler::disassemble(const vector<uint16_t>& rom, string& output, ostream* errorStream)
+{
+	bool ok = true;
+
+	// tells labels from variables, and picks a name for every address
+
+	vector<vector<const string*>> labels;				// labels written before each word
+	vector<const string*> labelNames, variableNames, predefinedNames;
+	vector<bool> usedAsMemory;
+
+	if (!symbols.empty()) {
+		labels.resize(rom.size() + 1);
+		labelNames.resize(addressCount);
+		variableNames.resize(addressCount);
+		predefinedNames.resize(addressCount);
+		usedAsMemory.resize(addressCount);
+
+		for (size_t i = 0; i < rom.size(); i++) {
+			if ((rom[i] & cInstruction) == 0 && useOf(rom, i) == USE_MEMORY)
+				usedAsMemory[rom[i]] = true;
+		}
+
+		// variables are allocated without gaps from 16: every address up to the highest one
+		// known holds a variable even if no memory access tells it, and so does an address past
+		// the end of the program, where there is no label
+
+		vector<bool> hasSymbol(addressCount);
+		size_t highestVariable = 0;
+
+		for (auto& symbol: symbols) {
+			if (!symbol.predefined && symbol.address < addressCount) {
+				hasSymbol[symbol.address] = true;
+
+				if (symbol.address >= firstVariable && (usedAsMemory[symbol.address] || symbol.address > rom.size()))
+					highestVariable = max<size_t>(highestVariable, symbol.address);
+			}
+		}
+
+		size_t end = firstVariable; // the first address without a symbol is past the variables
+
+		while (end < addressCount && hasSymbol[end])
+			end++;
+
+		highestVariable = min(highestVariable, end - 1);
+
+		for (auto& symbol: symbols) {
+			if (symbol.address >= addressCount) // labels past the ROM (programs too large for it) name no A-instruction
+				continue;
+
+			bool variable = symbol.address >= firstVariable && (usedAsMemory[symbol.address] || symbol.address > rom.size()
+			                || symbol.address <= highestVariable);
+
+			if (symbol.predefined) {
+				const string*& name = predefinedNames[symbol.address];
+
+				if (name == nullptr || (isRegisterName(*name) && !isRegisterName(symbol.name)))
+					name = &symbol.name;
+			} else if (variable && variableNames[symbol.address] == nullptr) {
+				variableNames[symbol.address] = &symbol.name; // one variable per address, the others are labels
+			} else if (symbol.address <= rom.size()) {
+				labels[symbol.address].push_back(&symbol.name);
+
+				if (labelNames[symbol.address] == nullptr)
+					labelNames[symbol.address] = &symbol.name;
+			}
+		}
+	}
+
+	vector<bool> allocated(symbols.empty() ? 0 : addressCount);
+	uint16_t nextVariable = firstVariable;
+
+	output.reserve(output.size() + rom.size() * 8);
+
+	for (size_t i = 0; i <= rom.size(); i++) {
+		if (!labels.empty()) {
+			for (auto label: labels[i])
+				appendLine(output, "(", *label, ")\n");
+		}
+
+		if (i == rom.size())
+			break;
+
+		uint16_t word = rom[i];
+
+		if (word & cInstruction) {
+			const char* mnemonic = code.cMnemonic(word);
+
+			if (mnemonic == nullptr) {
+				if (errorStream != nullptr)
+					*errorStream << "error: word " << i << " (0x" << hex << word << dec << ") is not a Hack instruction" << endl;
+
+				ok = false;
+				continue;
+			}
+
+			output += '\t';
+			output += mnemonic;
+			output += '\n';
+			continue;
+		}
+
+		const string* name = nullptr;
+
+		if (!symbols.empty()) {
+			Use use = useOf(rom, i);
+
+			if (word == nextVariable && variableNames[word] != nullptr) {
+				name = variableNames[word]; // its first use allocates the same address, whatever the use
+				allocated[word] = true;
+				nextVariable++;
+			} else if (use != USE_MEMORY) {
+				name = labelNames[word];
+			}
+
+			if (name == nullptr && variableNames[word] != nullptr && allocated[word])
+				name = variableNames[word];
+
+			if (name == nullptr && (use == USE_MEMORY || (use == USE_VALUE && word >= firstVariable)))
+				name = predefinedNames[word];
+		}
+
+		if (name != nullptr)
+			appendLine(output, "\t@", *name, "\n");
+		else
+			appendLine(output, "\t@", to_string(word), "\n");
+	}
+
+	return ok;
+}
+
+Disassembler::Use Disassembler::useOf(const vector<uint16_t>& rom, size_t address) const
+{
+	if (address + 1 >= rom.size() || (rom[address + 1] & cInstruction) == 0)
+		return USE_VALUE;
+
+	uint16_t next = rom[address + 1];
+
+	if (next & (compReadsM | destM))
+		return USE_MEMORY;
+
+	return next & jumpBits ? USE_JUMP : USE_VALUE;
+}
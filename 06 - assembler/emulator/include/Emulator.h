@@ -0,0 +1,274 @@
+#ifndef EMULATOR_INCLUDED_H
+#define EMULATOR_INCLUDED_H
+
+#include "Jit.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/**
+	Emulator of the Hack computer: the CPU of CPU.hdl running a program held in a 32K word ROM,
+	with the memory of Memory.hdl (16K words of RAM, the screen at 0x4000 and the keyboard at
+	0x6000).
+
+	The words of the ROM are decoded once, when they are loaded, into micro-operations (see
+	MicroOp) that run() executes without looking at the bits of the instructions again. The A,
+	D and PC registers live in local variables of run() while the program runs, and the memory
+	is indexed by the 15 low bits of A without bounds checks: the memory holds the whole 32K
+	address space, and the words past the keyboard (not wired on the Hack computer) are plain
+	memory. Writes to the keyboard are kept until the next setKeyboard().
+
+	A program halts when it jumps unconditionally to the A-instruction that loads the address
+	of the jump ("(END) \@END 0;JMP"), the idiom Hack programs end with.
+
+	The interpreter threads the micro-operations when built with GCC or Clang: each one holds
+	the address of its handler (labels as values), and each handler ends with the jump to the
+	handler of the next one, so that the indirect jumps are as many as the handlers and
+	predicted by their own history. The frequent forms of the C-instructions (D=M, M=D,
+	AM=M-1, 0;JMP, D;JGT...) have handlers of their own, without the tests of the destination
+	and jump bits (see Form). Other compilers run the same micro-operations with a switch.
+
+	With setJit(), run() compiles the program to host code instead (see Jit), and interprets
+	only the end of the program and the cycles that are left when a block does not fit in
+	them: the results are the same, cycle for cycle. Tools tracing every instruction must not
+	enable it.
+*/
+class Emulator
+{
+
+	public:
+
+		static const uint16_t screen = 0x4000;		/**< Address of the screen memory map. */
+		static const uint16_t keyboard = 0x6000;	/**< Address of the keyboard memory map. */
+		static const size_t romSize = 32768;		/**< Words of the ROM. */
+		static const size_t ramSize = keyboard + 1;	/**< Words of the memory of the Hack computer. */
+
+		/**
+			Constructs an Emulator object, with an empty ROM (all words zero) and memory.
+		*/
+		Emulator();
+
+		/**
+			Loads a program into the ROM (the rest of the ROM is cleared) and resets the CPU.
+
+			@param program Machine code.
+
+			@return True if the program was loaded. False if it does not fit in the ROM.
+		*/
+		bool load(const vector<uint16_t>& program);
+
+		/**
+			Enables or disables the compilation of the program to host code (see Jit).
+
+			@param enabled Compile the program?
+
+			@param codeSize Bytes of the code buffer of the compiler (see Jit::Jit()).
+
+			@return True if done. False if the JIT is not supported on this host.
+		*/
+		bool setJit(bool enabled, size_t codeSize = Jit::defaultCodeSize);
+
+		/**
+			Writes a word of the ROM (for test harnesses patching a program), decoding again
+			the micro-operations that depend on it and discarding the compiled code.
+
+			@param address Address (15 bits; the higher bit is ignored).
+
+			@param word The instruction.
+		*/
+		void writeRom(uint16_t address, uint16_t word);
+
+		/**
+			Resets the CPU, as its reset input: the program starts again at address 0. The
+			registers and the memory keep their values.
+		*/
+		void reset();
+
+		/**
+			Runs the program until it halts or the cycles run out.
+
+			@param maxCycles Maximum number of cycles (instructions) to run.
+
+			@return The number of cycles run.
+		*/
+		uint64_t run(uint64_t maxCycles);
+
+		/**
+			Has the program halted? (see the class description)
+		*/
+		bool isHalted() const;
+
+		/**
+			Returns the number of cycles run since the last load() or reset().
+		*/
+		uint64_t getCycles() const;
+
+		/**
+			Returns the A register.
+		*/
+		uint16_t getA() const;
+
+		/**
+			Returns the D register.
+		*/
+		uint16_t getD() const;
+
+		/**
+			Returns the program counter (the address of the next instruction).
+		*/
+		uint16_t getPC() const;
+
+		/**
+			Sets the A register.
+		*/
+		void setA(uint16_t value);
+
+		/**
+			Sets the D register.
+		*/
+		void setD(uint16_t value);
+
+		/**
+			Reads a word of the memory.
+
+			@param address Address (15 bits; the higher bit is ignored, as in addressM).
+		*/
+		uint16_t peek(uint16_t address) const;
+
+		/**
+			Writes a word of the memory.
+
+			@param address Address (15 bits; the higher bit is ignored, as in addressM).
+
+			@param value Value of the word.
+		*/
+		void poke(uint16_t address, uint16_t value);
+
+		/**
+			Sets the key being pressed (0: none), read by the program at @ref keyboard.
+		*/
+		void setKeyboard(uint16_t key);
+
+		/**
+			Returns the screen memory map: 8K words, 32 per row of 512 pixels, the least
+			significant bit of each word on the left.
+		*/
+		const uint16_t* getScreen() const;
+
+	private:
+
+		/**
+			Operations of the micro-operations: the A-instruction, the end of the program and
+			the computations of the C-instructions, by the registers they read.
+		*/
+		enum Op : uint8_t {
+			LOAD_A,				/**< A-instruction: A = value. */
+			HALT,				/**< 0;JMP at X+1 with "@X" at X, without dest: halts if A is X. */
+			ZERO, ONE, MINUS_ONE,
+			D, A, M,
+			NOT_D, NOT_A, NOT_M,
+			NEG_D, NEG_A, NEG_M,
+			D_PLUS_1, A_PLUS_1, M_PLUS_1,
+			D_MINUS_1, A_MINUS_1, M_MINUS_1,
+			D_PLUS_A, D_PLUS_M,
+			D_MINUS_A, D_MINUS_M,
+			A_MINUS_D, M_MINUS_D,
+			D_AND_A, D_AND_M,
+			D_OR_A, D_OR_M,
+			GENERIC_A,			/**< Other ALU control bits, with A as the y input. */
+			GENERIC_M			/**< Other ALU control bits, with M as the y input. */
+		};
+
+		/**
+			Handlers of the threaded interpreter: the forms of the micro-operations that have one
+			of their own (computation, destination and jump), the others running the generic one.
+		*/
+		enum class Form : uint8_t {
+			GENERIC,			/**< Any computation, destination and jump. */
+			LOAD_A,				/**< A-instruction. */
+			HALT,				/**< The end of the program (see HALT). */
+			JMP,				/**< 0;JMP, or any computation without destination. */
+			D_JGT, D_JEQ, D_JGE, D_JLT, D_JNE, D_JLE,
+			D_IS_A, D_IS_M, D_IS_D_PLUS_A, D_IS_M_MINUS_D,
+			A_IS_M, A_IS_A_MINUS_1, A_IS_D_PLUS_A,
+			M_IS_D, M_IS_0, M_IS_MINUS_1, M_IS_M_PLUS_1, M_IS_M_MINUS_1, M_IS_D_PLUS_M, M_IS_M_MINUS_D,
+			AM_IS_M_PLUS_1, AM_IS_M_MINUS_1,
+			MD_IS_M_MINUS_1
+		};
+
+		/**
+			A decoded ROM word. An A-instruction followed by a C-instruction is fused with it:
+			the micro-operation loads A and then runs the C-instruction, whose jump target is
+			then known when the ROM is loaded. The C-instruction keeps a micro-operation of its
+			own, for the jumps that land on it.
+		*/
+		class MicroOp {
+			public:
+				Op op;					/**< Operation. */
+				uint8_t dest;			/**< Destination bits of the C-instruction (A, D, M). */
+				uint8_t jump;			/**< Jump bits of the C-instruction (less, equal, greater). */
+				uint8_t control;		/**< ALU control bits (GENERIC_A and GENERIC_M). */
+				uint16_t value;			/**< Value loaded into A (LOAD_A, fused), or X (HALT). */
+				bool fused;				/**< Does it load A before the C-instruction? */
+				Form form;				/**< Handler of the threaded interpreter. */
+				const void* handler;	/**< Address of the handler (set by interpret()). */
+		};
+
+		/**
+			Runs the program with the interpreter (see run()).
+		*/
+		uint64_t interpret(uint64_t maxCycles);
+
+		/**
+			Returns the result of the computation of a micro-operation.
+
+			@param op The micro-operation (a computation).
+
+			@param regD The D register.
+
+			@param regA The A register.
+
+			@param m M, the word of the memory at A.
+		*/
+		static uint16_t compute(const MicroOp& op, uint16_t regD, uint16_t regA, uint16_t m);
+
+		/**
+			Returns the handler of a decoded micro-operation.
+		*/
+		static Form getForm(const MicroOp& op);
+
+		/**
+			Decodes a C-instruction.
+		*/
+		static MicroOp decodeC(uint16_t word);
+
+		/**
+			Decodes the word of the ROM at an address into its micro-operation.
+		*/
+		void decode(uint16_t address);
+
+		vector<uint16_t> rom;		/**< The ROM, @ref romSize words. */
+
+		vector<MicroOp> ops;		/**< Micro-operation of every word of the ROM. */
+
+		vector<uint16_t> ram;		/**< The memory, the whole address space of A. */
+
+		uint16_t a;					/**< A register. */
+
+		uint16_t d;					/**< D register. */
+
+		uint16_t pc;				/**< Program counter. */
+
+		bool halted;				/**< Has the program halted? */
+
+		bool threaded;				/**< Are the handlers of the micro-operations set? */
+
+		uint64_t cycles;			/**< Cycles run since the last reset. */
+
+		unique_ptr<Jit> jit;		/**< The compiler (nullptr if disabled). */
+
+};
+
+#endif // EMULATOR_INCLUDED_H
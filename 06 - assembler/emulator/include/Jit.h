@@ -0,0 +1,210 @@
+#ifndef JIT_INCLUDED_H
+#define JIT_INCLUDED_H
+
+#include <cstdint>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+using namespace std;
+
+/**
+	Compiler of the ROM of the Hack computer to x86-64 code, block by block as the program
+	reaches them (used by Emulator::run()).
+
+	A block starts at any address the program reaches and runs to the first jump, the end of
+	the program (see Emulator) or @ref maxBlockLength instructions. A and D are kept in host
+	registers and the memory is the array of the Emulator, addressed directly. The address of
+	M is a constant when an A-instruction of the block sets it, as are the targets of the
+	jumps: the exits to static targets are chained to the code of the target block once it is
+	compiled, while the computed jumps (A=M 0;JMP, the return of the VM) go through a table
+	with the code of every address.
+
+	Each block checks first that its instructions fit in the cycles left, and returns to
+	run() if they do not, so that the interpreter runs the last ones: runs stop at the exact
+	cycle. The end of the program is left to the interpreter too.
+
+	The code is written to a buffer of @ref defaultCodeSize bytes (see Jit()) that is emptied
+	when full. Only x86-64 hosts are supported (see isReady()).
+*/
+class Jit
+{
+
+	public:
+
+		static const uint16_t maxBlockLength = 256;		/**< Instructions of a block at most. */
+		static const size_t defaultCodeSize = 16 << 20;	/**< Bytes of the code buffer by default. */
+		static const size_t minCodeSize = 64 << 10;		/**< Bytes of the code buffer at least. */
+
+		/**
+			Constructs a Jit object, allocating the code buffer.
+
+			@param rom The ROM of the Emulator (32K words). Changes of the ROM must be told
+			with invalidate().
+
+			@param ram The memory of the Emulator (32K words).
+
+			@param bufferSize Bytes of the code buffer (raised to @ref minCodeSize). A small
+			buffer is emptied often, which exercises the recompilation of the blocks.
+		*/
+		Jit(const uint16_t* rom, uint16_t* ram, size_t bufferSize = defaultCodeSize);
+
+		/**
+			Frees the code buffer.
+		*/
+		~Jit();
+
+		Jit(const Jit&) = delete;
+
+		Jit& operator=(const Jit&) = delete;
+
+		/**
+			Can the program be compiled? False if the host is not x86-64, or if no executable
+			memory could be allocated.
+		*/
+		bool isReady() const;
+
+		/**
+			Discards the compiled code, when the ROM has changed.
+		*/
+		void invalidate();
+
+		/**
+			Runs compiled code from the program counter, compiling the blocks it reaches,
+			until the block at the program counter does not fit in the cycles left or is the
+			end of the program. getBlockLength() then tells how many cycles the interpreter
+			must run before calling run() again.
+
+			@param a The A register. Receives its new value.
+
+			@param d The D register. Receives its new value.
+
+			@param pc The program counter. Receives the address of the block run() stopped at.
+
+			@param maxCycles Maximum number of cycles (instructions) to run.
+
+			@return The number of cycles run.
+		*/
+		uint64_t run(uint16_t& a, uint16_t& d, uint16_t& pc, uint64_t maxCycles);
+
+		/**
+			Returns the number of instructions of the block run() stopped at: the block that
+			did not fit in the cycles left, or the instructions that end the program (1 or 2).
+
+			@param address Address where run() stopped.
+		*/
+		uint16_t getBlockLength(uint16_t address) const;
+
+		/**
+			Returns the number of blocks compiled since the object was constructed.
+		*/
+		uint64_t getBlockCount() const;
+
+	private:
+
+		/**
+			State shared with the compiled code (addressed from r15).
+		*/
+		class Context {
+			public:
+				uint64_t remaining;			/**< Cycles left (r13 in the compiled code). */
+				uint16_t* ram;				/**< The memory (r12). */
+				const uint8_t** table;		/**< Code of every address (r14). */
+				uint16_t a;					/**< A register (ebx). */
+				uint16_t d;					/**< D register (ebp). */
+				uint16_t pc;				/**< Program counter, when leaving the code (eax). */
+		};
+
+		/**
+			Entry of the compiled code: runs from the block at entry until it leaves.
+
+			@return The exit stub to chain to the block at the program counter, or nullptr.
+		*/
+		typedef uint8_t* (*Entry)(Context* context, const uint8_t* entry);
+
+		/**
+			Returns the code of the block at an address, compiling it if needed. nullptr if the
+			block is the end of the program (see getBlockLength()).
+		*/
+		const uint8_t* lookup(uint16_t address);
+
+		/**
+			Compiles the block at an address.
+		*/
+		const uint8_t* compile(uint16_t start);
+
+		/**
+			Returns the number of instructions ending the program at an address: 2 for
+			"@X 0;JMP" at X, 1 for the "0;JMP" after a "@X" at X, 0 if the address does not end
+			the program.
+		*/
+		uint16_t getEndLength(uint16_t address) const;
+
+		/**
+			Writes the code entering and leaving the compiled code, at the start of the buffer.
+		*/
+		void writeRuntime();
+
+		/**
+			Writes the load of M into ecx, from a known address or the one in esi.
+		*/
+		void emitLoadM(bool known, uint16_t address);
+
+		/**
+			Writes the store of ax into M, at a known address or the one in esi.
+		*/
+		void emitStoreM(bool known, uint16_t address);
+
+		/**
+			Writes an exit to a known address, chained later to its block.
+		*/
+		void emitExit(uint16_t pc);
+
+		/**
+			Writes a jump to the address in esi through the table.
+		*/
+		void emitDispatch();
+
+		/**
+			Writes a jump with a 32 bit displacement to a target.
+		*/
+		void emitJump(initializer_list<uint8_t> opcode, const uint8_t* target);
+
+		void emit(initializer_list<uint8_t> bytes);
+
+		void emit32(uint32_t value);
+
+		void emit64(uint64_t value);
+
+		/**
+			Sets the 32 bit displacement at the end of a jump to a target.
+		*/
+		static void setTarget(uint8_t* jump, const uint8_t* target);
+
+		const uint16_t* rom;			/**< The ROM. */
+
+		uint16_t* ram;					/**< The memory. */
+
+		uint8_t* code;					/**< The code buffer (nullptr if not allocated). */
+
+		size_t codeSize;				/**< Bytes of the code buffer. */
+
+		size_t used;					/**< Bytes of the buffer written. */
+
+		size_t runtimeSize;				/**< Bytes of the code written by writeRuntime(). */
+
+		uint8_t* exit;					/**< Code leaving the compiled code. */
+
+		uint8_t* miss;					/**< Code leaving it for an address not compiled. */
+
+		vector<const uint8_t*> table;	/**< Code of every address (miss if not compiled). */
+
+		vector<uint16_t> lengths;		/**< Instructions of the block at every address. */
+
+		uint64_t blockCount;			/**< Blocks compiled. */
+
+		uint64_t flushes;				/**< Times the buffer was emptied. */
+
+};
+
+#endif // JIT_INCLUDED_H
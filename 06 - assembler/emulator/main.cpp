@@ -0,0 +1,254 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <unistd.h>
+#include "Emulator.h"
+#include "FileHandler.h"
+#include "MappedFile.h"
+#include "RomReader.h"
+
+using namespace std;
+
+/**
+	A range of memory words.
+*/
+class Range
+{
+	public:
+		uint16_t address;						/**< First word. */
+		unsigned int count;						/**< Number of words. */
+};
+
+/**
+	A word of memory set before running.
+*/
+class Assignment
+{
+	public:
+		uint16_t address;						/**< Address of the word. */
+		uint16_t value;							/**< Value of the word. */
+};
+
+/**
+	Options of the emulator, read from the command line arguments.
+*/
+class Flags
+{
+	public:
+		uint64_t maxCycles = 1000000000;		/**< Maximum number of cycles. */
+		vector<Assignment> assignments;			/**< Words set before running. */
+		vector<Range> ranges;					/**< Words printed after running. */
+		bool timing = false;					/**< Print speed flag. */
+		bool jit = false;						/**< Compile to host code flag. */
+		size_t codeSize = Jit::defaultCodeSize;	/**< Bytes of the code buffer of the JIT. */
+};
+
+/**
+	Parses a number in decimal or, with the 0x prefix, hexadecimal.
+
+	@param text The number.
+
+	@param min Least valid value.
+
+	@param max Greatest valid value.
+
+	@param value Receives the number.
+
+	@return True if the text is a valid number. False otherwise.
+*/
+bool parseNumber(const string& text, long long min, long long max, long long& value)
+{
+	char* end;
+	value = strtoll(text.c_str(), &end, 0);
+
+	return !text.empty() && *end == '\0' && value >= min && value <= max;
+}
+
+/**
+	Gets the flags from the command line arguments.
+
+	@param argc Number of command line arguments.
+
+	@param argv Array of arguments.
+
+	@param flags Flags. Their values will be affected by the arguments.
+
+	@return Returns false if an unidentified or invalid flag is present in the arguments.
+	True otherwise.
+*/
+bool getFlags(int argc, char** argv, Flags& flags)
+{
+	int c;
+	long long number, value;
+
+	while ((c = getopt(argc, argv, "n:s:p:tjc:")) != -1) {
+
+        switch (c) {
+
+            case 'n':
+                if (!parseNumber(optarg, 1, LLONG_MAX, number)) {
+                    cerr << "error: invalid number of cycles \"" << optarg << "\"" << endl;
+                    return false;
+                }
+                flags.maxCycles = number;
+                break;
+
+            case 's': {
+                string arg(optarg);
+                size_t equals = arg.find('=');
+
+                if (equals == string::npos || !parseNumber(arg.substr(0, equals), 0, 0x7fff, number)
+                    || !parseNumber(arg.substr(equals + 1), -32768, 65535, value)) {
+                    cerr << "error: invalid assignment \"" << optarg << "\" (expected address=value)" << endl;
+                    return false;
+                }
+                flags.assignments.push_back(Assignment { uint16_t(number), uint16_t(value) });
+                break;
+            }
+
+            case 'p': {
+                string arg(optarg);
+                size_t colon = arg.find(':');
+
+                if (!parseNumber(arg.substr(0, colon), 0, 0x7fff, number)
+                    || (colon != string::npos && !parseNumber(arg.substr(colon + 1), 1, 0x8000 - number, value))) {
+                    cerr << "error: invalid range \"" << optarg << "\" (expected address or address:count)" << endl;
+                    return false;
+                }
+                flags.ranges.push_back(Range { uint16_t(number), colon != string::npos ? unsigned(value) : 1 });
+                break;
+            }
+
+            case 't':
+                flags.timing = true;
+                break;
+
+            case 'j':
+                flags.jit = true;
+                break;
+
+            case 'c':
+                if (!parseNumber(optarg, Jit::minCodeSize, 1 << 30, number)) {
+                    cerr << "error: invalid code buffer size \"" << optarg << "\" (" << Jit::minCodeSize << " bytes at least)" << endl;
+                    return false;
+                }
+                flags.codeSize = number;
+                break;
+
+            case '?':
+                return false;
+
+        }
+    }
+
+	return true;
+}
+
+/**
+	Reads a ROM image: a .hack file, a .bin file written by "hass -f bin" or a .hbin file
+	written by "hass -f hbin".
+
+	@param inputName Name of the input file.
+
+	@param rom Receives the machine code.
+
+	@return True if the file was read. False otherwise.
+*/
+bool readRom(string inputName, vector<uint16_t>& rom)
+{
+	if (!FileHandler::isFile(inputName)) {
+		cerr << "error: input \"" << inputName << "\" is not a file" << endl;
+		return false;
+	}
+
+	MappedFile inputFile;
+
+	if (!inputFile.openRead(inputName)) {
+		cerr << "error: unable to open input file \"" << inputName << "\"" << endl;
+		return false;
+	}
+
+	string message;
+
+	if (!RomReader::read(inputFile.view(), RomReader::getFormat(inputName), rom, message)) {
+		cerr << "error: \"" << inputName << "\": " << message << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+	Runs a Hack program and prints the registers and the requested memory words (signed, as
+	the CPU emulator of the book does).
+*/
+int main(int argc, char** argv)
+{
+	if (argc == 1) {
+		cerr << "usage: " << "hemu" << " [-n cycles] [-s address=value]... [-p address[:count]]... [-t] [-j [-c bytes]] input" << endl;
+		cerr << "       -n maximum number of cycles (default: 1000000000); the program stops" << endl;
+		cerr << "          before if it halts (jumps to itself: \"(END) @END 0;JMP\")" << endl;
+		cerr << "       -s set a memory word before running (e.g. -s 0=3)" << endl;
+		cerr << "       -p print memory words after running (e.g. -p 2, -p 0x4000:32)" << endl;
+		cerr << "       -t print the time taken and the speed" << endl;
+		cerr << "       -j compile the program to x86-64 code while running it (same results)" << endl;
+		cerr << "       -c size of the code buffer of -j in bytes (default: 16M, 64K at least); the" << endl;
+		cerr << "          buffer is emptied when full, which a small one tests" << endl;
+		cerr << "       input is a .hack file, a .bin file (hass -f bin) or a .hbin file (hass -f hbin)" << endl;
+		return 1;
+	}
+
+	Flags flags;
+
+	if (!getFlags(argc, argv, flags))
+		return 1;
+
+	if (optind != argc - 1) {
+		cerr << "error: expected one input file" << endl;
+		return 1;
+	}
+
+	vector<uint16_t> rom;
+
+	if (!readRom(argv[optind], rom))
+		return 1;
+
+	Emulator emulator;
+
+	if (!emulator.load(rom)) {
+		cerr << "error: program too large (" << rom.size() << " words, the ROM holds " << Emulator::romSize << ")" << endl;
+		return 1;
+	}
+
+	if (flags.jit && !emulator.setJit(true, flags.codeSize)) {
+		cerr << "error: the JIT is not supported on this host" << endl;
+		return 1;
+	}
+
+	for (auto& assignment: flags.assignments)
+		emulator.poke(assignment.address, assignment.value);
+
+	auto start = chrono::steady_clock::now();
+	emulator.run(flags.maxCycles);
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	cout << "cycles: " << emulator.getCycles() << (emulator.isHalted() ? " (halted)" : " (limit reached)") << endl;
+	cout << "A: " << int16_t(emulator.getA()) << endl;
+	cout << "D: " << int16_t(emulator.getD()) << endl;
+	cout << "PC: " << emulator.getPC() << endl;
+
+	for (auto& range: flags.ranges)
+		for (unsigned int i = 0; i < range.count; i++)
+			cout << "RAM[" << range.address + i << "]: " << int16_t(emulator.peek(range.address + i)) << endl;
+
+	if (flags.timing) {
+		cout << "time: " << fixed << setprecision(3) << elapsed.count() << " s ("
+		     << setprecision(1) << emulator.getCycles() / elapsed.count() / 1e6 << " MIPS)" << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,508 @@
+#include "Emulator.h"
+#include "Cpu.h"
+#include <algorithm>
+
+using namespace Cpu;
+
+Emulator::Emulator()
+	: rom(romSize), ops(romSize), ram(addressMask + 1), a(0), d(0), pc(0), halted(false), threaded(false), cycles(0)
+{
+	for (size_t i = 0; i < romSize; i++)
+		decode(i);
+}
+
+bool Emulator::load(const vector<uint16_t>& program)
+{
+	if (program.size() > romSize)
+		return false;
+
+	copy(program.begin(), program.end(), rom.begin());
+	fill(rom.begin() + program.size(), rom.end(), 0);
+
+	for (size_t i = 0; i < romSize; i++)
+		decode(i);
+
+	if (jit != nullptr)
+		jit->invalidate();
+
+	reset();
+
+	return true;
+}
+
+void Emulator::writeRom(uint16_t address, uint16_t word)
+{
+	address &= addressMask;
+	rom[address] = word;
+
+	// the A-instruction before may be fused with the word, and the word after may end the program
+
+	decode((address - 1) & addressMask);
+	decode(address);
+	decode((address + 1) & addressMask);
+
+	if (jit != nullptr)
+		jit->invalidate();
+}
+
+bool Emulator::setJit(bool enabled, size_t codeSize)
+{
+	jit.reset();
+
+	if (enabled) {
+		jit = make_unique<Jit>(rom.data(), ram.data(), codeSize);
+
+		if (!jit->isReady()) {
+			jit.reset();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Emulator::reset()
+{
+	pc = 0;
+	halted = false;
+	cycles = 0;
+}
+
+uint64_t Emulator::run(uint64_t maxCycles)
+{
+	if (jit == nullptr)
+		return interpret(maxCycles);
+
+	uint64_t cycle = 0;
+
+	while (cycle < maxCycles && !halted) {
+		uint64_t count = jit->run(a, d, pc, maxCycles - cycle);
+		cycles += count;
+		cycle += count;
+
+		// the block at the PC does not fit in the cycles left, or ends the program
+
+		if (cycle < maxCycles)
+			cycle += interpret(min<uint64_t>(maxCycles - cycle, jit->getBlockLength(pc)));
+	}
+
+	return cycle;
+}
+
+uint16_t Emulator::compute(const MicroOp& op, uint16_t regD, uint16_t regA, uint16_t m)
+{
+	switch (op.op) {
+		case ZERO:		return 0;
+		case ONE:		return 1;
+		case MINUS_ONE:	return 0xffff;
+		case D:			return regD;
+		case A:			return regA;
+		case M:			return m;
+		case NOT_D:		return ~regD;
+		case NOT_A:		return ~regA;
+		case NOT_M:		return ~m;
+		case NEG_D:		return -regD;
+		case NEG_A:		return -regA;
+		case NEG_M:		return -m;
+		case D_PLUS_1:	return regD + 1;
+		case A_PLUS_1:	return regA + 1;
+		case M_PLUS_1:	return m + 1;
+		case D_MINUS_1:	return regD - 1;
+		case A_MINUS_1:	return regA - 1;
+		case M_MINUS_1:	return m - 1;
+		case D_PLUS_A:	return regD + regA;
+		case D_PLUS_M:	return regD + m;
+		case D_MINUS_A:	return regD - regA;
+		case D_MINUS_M:	return regD - m;
+		case A_MINUS_D:	return regA - regD;
+		case M_MINUS_D:	return m - regD;
+		case D_AND_A:	return regD & regA;
+		case D_AND_M:	return regD & m;
+		case D_OR_A:	return regD | regA;
+		case D_OR_M:	return regD | m;
+		case GENERIC_A:	return alu(regD, regA, op.control);
+		default:		return alu(regD, m, op.control);
+	}
+}
+
+#if defined(__GNUC__)
+
+uint64_t Emulator::interpret(uint64_t maxCycles)
+{
+	// the handler of every form, entered at the C-instruction and at the A-instruction fused
+	// with it, in the order of Form
+
+	static const void* const handlers[][2] = {
+		{ &&GENERIC, &&FUSED_GENERIC },
+		{ &&LOAD_A, &&LOAD_A },
+		{ &&HALT, &&FUSED_HALT },
+		{ &&JMP, &&FUSED_JMP },
+		{ &&D_JGT, &&FUSED_D_JGT },
+		{ &&D_JEQ, &&FUSED_D_JEQ },
+		{ &&D_JGE, &&FUSED_D_JGE },
+		{ &&D_JLT, &&FUSED_D_JLT },
+		{ &&D_JNE, &&FUSED_D_JNE },
+		{ &&D_JLE, &&FUSED_D_JLE },
+		{ &&D_IS_A, &&FUSED_D_IS_A },
+		{ &&D_IS_M, &&FUSED_D_IS_M },
+		{ &&D_IS_D_PLUS_A, &&FUSED_D_IS_D_PLUS_A },
+		{ &&D_IS_M_MINUS_D, &&FUSED_D_IS_M_MINUS_D },
+		{ &&A_IS_M, &&FUSED_A_IS_M },
+		{ &&A_IS_A_MINUS_1, &&FUSED_A_IS_A_MINUS_1 },
+		{ &&A_IS_D_PLUS_A, &&FUSED_A_IS_D_PLUS_A },
+		{ &&M_IS_D, &&FUSED_M_IS_D },
+		{ &&M_IS_0, &&FUSED_M_IS_0 },
+		{ &&M_IS_MINUS_1, &&FUSED_M_IS_MINUS_1 },
+		{ &&M_IS_M_PLUS_1, &&FUSED_M_IS_M_PLUS_1 },
+		{ &&M_IS_M_MINUS_1, &&FUSED_M_IS_M_MINUS_1 },
+		{ &&M_IS_D_PLUS_M, &&FUSED_M_IS_D_PLUS_M },
+		{ &&M_IS_M_MINUS_D, &&FUSED_M_IS_M_MINUS_D },
+		{ &&AM_IS_M_PLUS_1, &&FUSED_AM_IS_M_PLUS_1 },
+		{ &&AM_IS_M_MINUS_1, &&FUSED_AM_IS_M_MINUS_1 },
+		{ &&MD_IS_M_MINUS_1, &&FUSED_MD_IS_M_MINUS_1 }
+	};
+
+	if (halted)
+		return 0;
+
+	if (!threaded) {
+		for (MicroOp& op: ops)
+			op.handler = handlers[size_t(op.form)][op.fused];
+
+		threaded = true;
+	}
+
+	const MicroOp* code = ops.data();
+	const MicroOp* op;
+	uint16_t* memory = ram.data();
+	uint16_t regA = a, regD = d, next = pc;
+	uint16_t address, out;
+	uint64_t cycle = 0;
+
+	// every handler ends with the dispatch to the next one; M is read and written at the
+	// address A has before the C-instruction, and the jump goes there too
+
+#define DISPATCH() \
+	if (cycle >= maxCycles) \
+		goto stop; \
+	op = &code[next]; \
+	goto *op->handler
+
+#define HANDLER(form) \
+	FUSED_##form: \
+		regA = op->value; \
+		next = (next + 1) & addressMask; \
+		if (++cycle == maxCycles) \
+			goto stop; \
+	form: \
+		cycle++; \
+		address = regA & addressMask
+
+#define STEP() \
+	next = (next + 1) & addressMask; \
+	DISPATCH()
+
+#define JUMP_IF(condition) \
+	next = (condition) ? address : (next + 1) & addressMask; \
+	DISPATCH()
+
+	DISPATCH();
+
+LOAD_A:
+	regA = op->value;
+	next = (next + 1) & addressMask;
+	cycle++;
+	DISPATCH();
+
+HANDLER(HALT);
+	next = address;
+
+	if (address == op->value) {
+		halted = true; // "@X 0;JMP" at X: nothing changes any more
+		goto stop;
+	}
+
+	DISPATCH();
+
+HANDLER(GENERIC);
+	out = compute(*op, regD, regA, memory[address]);
+
+	if (op->dest & destM)
+		memory[address] = out;
+
+	if (op->dest & destA)
+		regA = out;
+
+	if (op->dest & destD)
+		regD = out;
+
+	JUMP_IF(op->jump & (out == 0 ? jumpEqual : out & 0x8000 ? jumpLess : jumpGreater));
+
+HANDLER(JMP);			next = address; DISPATCH();
+HANDLER(D_JGT);			JUMP_IF(int16_t(regD) > 0);
+HANDLER(D_JEQ);			JUMP_IF(regD == 0);
+HANDLER(D_JGE);			JUMP_IF(int16_t(regD) >= 0);
+HANDLER(D_JLT);			JUMP_IF(int16_t(regD) < 0);
+HANDLER(D_JNE);			JUMP_IF(regD != 0);
+HANDLER(D_JLE);			JUMP_IF(int16_t(regD) <= 0);
+HANDLER(D_IS_A);		regD = regA; STEP();
+HANDLER(D_IS_M);		regD = memory[address]; STEP();
+HANDLER(D_IS_D_PLUS_A);	regD += regA; STEP();
+HANDLER(D_IS_M_MINUS_D);	regD = memory[address] - regD; STEP();
+HANDLER(A_IS_M);		regA = memory[address]; STEP();
+HANDLER(A_IS_A_MINUS_1);	regA--; STEP();
+HANDLER(A_IS_D_PLUS_A);	regA += regD; STEP();
+HANDLER(M_IS_D);		memory[address] = regD; STEP();
+HANDLER(M_IS_0);		memory[address] = 0; STEP();
+HANDLER(M_IS_MINUS_1);	memory[address] = 0xffff; STEP();
+HANDLER(M_IS_M_PLUS_1);	memory[address]++; STEP();
+HANDLER(M_IS_M_MINUS_1);	memory[address]--; STEP();
+HANDLER(M_IS_D_PLUS_M);	memory[address] += regD; STEP();
+HANDLER(M_IS_M_MINUS_D);	memory[address] -= regD; STEP();
+HANDLER(AM_IS_M_PLUS_1);	regA = ++memory[address]; STEP();
+HANDLER(AM_IS_M_MINUS_1);	regA = --memory[address]; STEP();
+HANDLER(MD_IS_M_MINUS_1);	regD = --memory[address]; STEP();
+
+#undef DISPATCH
+#undef HANDLER
+#undef STEP
+#undef JUMP_IF
+
+stop:
+	a = regA;
+	d = regD;
+	pc = next;
+	cycles += cycle;
+
+	return cycle;
+}
+
+#else
+
+uint64_t Emulator::interpret(uint64_t maxCycles)
+{
+	const MicroOp* code = ops.data();
+	uint16_t* memory = ram.data();
+	uint16_t regA = a, regD = d, next = pc;
+	uint64_t cycle = 0;
+
+	if (halted)
+		return 0;
+
+	while (cycle < maxCycles) {
+		const MicroOp& op = code[next];
+
+		if (op.op == LOAD_A) {
+			regA = op.value;
+			next = (next + 1) & addressMask;
+			cycle++;
+			continue;
+		}
+
+		if (op.fused) { // the A-instruction before the C-instruction
+			regA = op.value;
+			next = (next + 1) & addressMask;
+
+			if (++cycle == maxCycles)
+				break;
+		}
+
+		// M is read and written at the address A had before the instruction, and the jump
+		// goes there too
+
+		uint16_t address = regA & addressMask;
+		cycle++;
+
+		if (op.op == HALT) {
+			next = address;
+
+			if (address == op.value) {
+				halted = true; // "@X 0;JMP" at X: nothing changes any more
+				break;
+			}
+
+			continue;
+		}
+
+		uint16_t out = compute(op, regD, regA, memory[address]);
+
+		if (op.dest & destM)
+			memory[address] = out;
+
+		if (op.dest & destA)
+			regA = out;
+
+		if (op.dest & destD)
+			regD = out;
+
+		unsigned int condition = out == 0 ? jumpEqual : out & 0x8000 ? jumpLess : jumpGreater;
+		next = op.jump & condition ? address : (next + 1) & addressMask;
+	}
+
+	a = regA;
+	d = regD;
+	pc = next;
+	cycles += cycle;
+
+	return cycle;
+}
+
+#endif
+
+bool Emulator::isHalted() const
+{
+	return halted;
+}
+
+uint64_t Emulator::getCycles() const
+{
+	return cycles;
+}
+
+uint16_t Emulator::getA() const
+{
+	return a;
+}
+
+uint16_t Emulator::getD() const
+{
+	return d;
+}
+
+uint16_t Emulator::getPC() const
+{
+	return pc;
+}
+
+void Emulator::setA(uint16_t value)
+{
+	a = value;
+}
+
+void Emulator::setD(uint16_t value)
+{
+	d = value;
+}
+
+uint16_t Emulator::peek(uint16_t address) const
+{
+	return ram[address & addressMask];
+}
+
+void Emulator::poke(uint16_t address, uint16_t value)
+{
+	ram[address & addressMask] = value;
+}
+
+void Emulator::setKeyboard(uint16_t key)
+{
+	ram[keyboard] = key;
+}
+
+const uint16_t* Emulator::getScreen() const
+{
+	return ram.data() + screen;
+}
+
+Emulator::MicroOp Emulator::decodeC(uint16_t word)
+{
+	// micro-operations of the computations, with A and with M as the y input
+
+	static const struct { uint8_t control; Op withA; Op withM; } computations[] = {
+		{ 0x2a, ZERO, ZERO },				{ 0x3f, ONE, ONE },					{ 0x3a, MINUS_ONE, MINUS_ONE },
+		{ 0x0c, D, D },						{ 0x30, A, M },						{ 0x0d, NOT_D, NOT_D },
+		{ 0x31, NOT_A, NOT_M },				{ 0x0f, NEG_D, NEG_D },				{ 0x33, NEG_A, NEG_M },
+		{ 0x1f, D_PLUS_1, D_PLUS_1 },		{ 0x37, A_PLUS_1, M_PLUS_1 },		{ 0x0e, D_MINUS_1, D_MINUS_1 },
+		{ 0x32, A_MINUS_1, M_MINUS_1 },		{ 0x02, D_PLUS_A, D_PLUS_M },		{ 0x13, D_MINUS_A, D_MINUS_M },
+		{ 0x07, A_MINUS_D, M_MINUS_D },		{ 0x00, D_AND_A, D_AND_M },			{ 0x15, D_OR_A, D_OR_M }
+	};
+
+	uint8_t control = word >> 6 & 0x3f;
+	bool readsM = word & compReadsM;
+	MicroOp op { readsM ? GENERIC_M : GENERIC_A, uint8_t(word & (destA | destD | destM)), uint8_t(word & jumpAlways), control, 0, false, Form::GENERIC, nullptr };
+
+	for (auto& computation: computations) {
+		if (computation.control == control) {
+			op.op = readsM ? computation.withM : computation.withA;
+			break;
+		}
+	}
+
+	return op;
+}
+
+void Emulator::decode(uint16_t address)
+{
+	uint16_t word = rom[address];
+	uint16_t nextWord = rom[(address + 1) & addressMask];
+	uint16_t previous = (address - 1) & addressMask;
+	MicroOp& op = ops[address];
+
+	if (word & cInstruction) {
+		op = decodeC(word);
+
+		if (isEnd(rom[previous], previous, word)) { // entered by a jump, halts if A is X
+			op.op = HALT;
+			op.value = previous;
+		}
+	} else if (nextWord & cInstruction) {
+		op = decodeC(nextWord);
+		op.value = word;
+		op.fused = true;
+
+		if (isEnd(word, address, nextWord))
+			op.op = HALT;
+	} else {
+		op = MicroOp { LOAD_A, 0, 0, 0, word, false, Form::GENERIC, nullptr };
+	}
+
+	op.form = getForm(op);
+	threaded = false;
+}
+
+Emulator::Form Emulator::getForm(const MicroOp& op)
+{
+	// the forms with a handler of their own, by computation, destination and jump
+
+	static const struct { Op op; uint8_t dest; uint8_t jump; Form form; } forms[] = {
+		{ D, 0, jumpGreater, Form::D_JGT },
+		{ D, 0, jumpEqual, Form::D_JEQ },
+		{ D, 0, jumpGreater | jumpEqual, Form::D_JGE },
+		{ D, 0, jumpLess, Form::D_JLT },
+		{ D, 0, jumpLess | jumpGreater, Form::D_JNE },
+		{ D, 0, jumpLess | jumpEqual, Form::D_JLE },
+		{ A, destD, 0, Form::D_IS_A },
+		{ M, destD, 0, Form::D_IS_M },
+		{ D_PLUS_A, destD, 0, Form::D_IS_D_PLUS_A },
+		{ M_MINUS_D, destD, 0, Form::D_IS_M_MINUS_D },
+		{ M, destA, 0, Form::A_IS_M },
+		{ A_MINUS_1, destA, 0, Form::A_IS_A_MINUS_1 },
+		{ D_PLUS_A, destA, 0, Form::A_IS_D_PLUS_A },
+		{ D, destM, 0, Form::M_IS_D },
+		{ ZERO, destM, 0, Form::M_IS_0 },
+		{ MINUS_ONE, destM, 0, Form::M_IS_MINUS_1 },
+		{ M_PLUS_1, destM, 0, Form::M_IS_M_PLUS_1 },
+		{ M_MINUS_1, destM, 0, Form::M_IS_M_MINUS_1 },
+		{ D_PLUS_M, destM, 0, Form::M_IS_D_PLUS_M },
+		{ M_MINUS_D, destM, 0, Form::M_IS_M_MINUS_D },
+		{ M_PLUS_1, destA | destM, 0, Form::AM_IS_M_PLUS_1 },
+		{ M_MINUS_1, destA | destM, 0, Form::AM_IS_M_MINUS_1 },
+		{ M_MINUS_1, destM | destD, 0, Form::MD_IS_M_MINUS_1 }
+	};
+
+	if (op.op == LOAD_A)
+		return Form::LOAD_A;
+
+	if (op.op == HALT)
+		return Form::HALT;
+
+	if (op.dest == 0 && op.jump == jumpAlways)
+		return Form::JMP;
+
+	for (auto& form: forms) {
+		if (form.op == op.op && form.dest == op.dest && form.jump == op.jump)
+			return form.form;
+	}
+
+	return Form::GENERIC;
+}
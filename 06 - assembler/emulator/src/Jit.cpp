@@ -0,0 +1,354 @@
+#include "Jit.h"
+#include "Cpu.h"
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+
+using namespace Cpu;
+
+namespace {
+
+	/**
+		Bytes of code a block may take at most: the longest C-instruction with its jump, the
+		exits, and the cycle check.
+	*/
+	const size_t maxBlockSize = Jit::maxBlockLength * 64 + 128;
+
+	/**
+		Second byte of the jcc rel32 instruction taken on each condition of the jump bits,
+		after "test ax, ax".
+	*/
+	const uint8_t conditions[] = { 0, 0x8f, 0x84, 0x8d, 0x8c, 0x85, 0x8e };
+
+}
+
+Jit::Jit(const uint16_t* rom, uint16_t* ram, size_t bufferSize)
+	: rom(rom), ram(ram), code(nullptr), codeSize(max(bufferSize, size_t(minCodeSize))), used(0), runtimeSize(0), exit(nullptr), miss(nullptr),
+	  table(addressMask + 1), lengths(addressMask + 1), blockCount(0), flushes(0)
+{
+#ifdef __x86_64__
+	void* buffer = mmap(nullptr, codeSize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (buffer != MAP_FAILED) {
+		code = static_cast<uint8_t*>(buffer);
+		writeRuntime();
+		invalidate();
+		flushes = 0;
+	}
+#endif
+}
+
+Jit::~Jit()
+{
+	if (code != nullptr)
+		munmap(code, codeSize);
+}
+
+bool Jit::isReady() const
+{
+	return code != nullptr;
+}
+
+void Jit::invalidate()
+{
+	used = runtimeSize;
+	fill(table.begin(), table.end(), miss);
+	fill(lengths.begin(), lengths.end(), 0);
+	flushes++;
+}
+
+uint64_t Jit::run(uint16_t& a, uint16_t& d, uint16_t& pc, uint64_t maxCycles)
+{
+	Context context { maxCycles, ram, table.data(), a, d, pc };
+	Entry enter = reinterpret_cast<Entry>(code);
+	const uint8_t* entry;
+
+	while ((entry = lookup(context.pc)) != nullptr && lengths[context.pc] <= context.remaining) {
+		uint8_t* stub = enter(&context, entry);
+
+		// chain the exit to its target, unless compiling the target emptied the buffer
+
+		uint64_t generation = flushes;
+		const uint8_t* target = stub != nullptr ? lookup(context.pc) : nullptr;
+
+		if (target != nullptr && generation == flushes) {
+			stub[0] = 0xe9; // jmp rel32 over "mov eax, pc"
+			setTarget(stub + 5, target);
+		}
+	}
+
+	a = context.a;
+	d = context.d;
+	pc = context.pc;
+
+	return maxCycles - context.remaining;
+}
+
+uint16_t Jit::getBlockLength(uint16_t address) const
+{
+	uint16_t length = getEndLength(address);
+
+	if (length == 0)
+		length = lengths[address];
+
+	return max<uint16_t>(length, 1);
+}
+
+uint64_t Jit::getBlockCount() const
+{
+	return blockCount;
+}
+
+const uint8_t* Jit::lookup(uint16_t address)
+{
+	if (table[address] != miss)
+		return table[address];
+
+	if (getEndLength(address) != 0)
+		return nullptr;
+
+	return compile(address);
+}
+
+const uint8_t* Jit::compile(uint16_t start)
+{
+	if (codeSize - used < maxBlockSize)
+		invalidate();
+
+	// the block: up to the first jump, excluding the end of the program
+
+	uint16_t length = 0;
+	uint16_t address = start;
+
+	while (length < maxBlockLength && (length == 0 || getEndLength(address) == 0)) {
+		uint16_t word = rom[address];
+		length++;
+		address = (address + 1) & addressMask;
+
+		if ((word & cInstruction) && (word & jumpAlways))
+			break;
+	}
+
+	uint8_t* entry = code + used;
+	table[start] = entry;
+	lengths[start] = length;
+	blockCount++;
+
+	emit({ 0x49, 0x81, 0xfd }); emit32(length);			// cmp r13, length
+	emit({ 0x0f, 0x82 }); emit32(0);						// jb (to the exit below)
+	uint8_t* cycleCheck = code + used;
+	emit({ 0x49, 0x81, 0xed }); emit32(length);			// sub r13, length
+
+	bool known = false; // is A known, from an A-instruction of the block?
+	bool targetKnown = false;
+	uint16_t value = 0;
+	uint16_t jump = 0;
+
+	address = start;
+
+	for (uint16_t i = 0; i < length; i++) {
+		uint16_t word = rom[address];
+		address = (address + 1) & addressMask;
+
+		if (!(word & cInstruction)) {
+			emit({ 0xbb }); emit32(word);					// mov ebx, word
+			known = true;
+			value = word;
+			continue;
+		}
+
+		unsigned int control = word >> 6 & 0x3f;
+		uint16_t dest = word & (destA | destD | destM);
+		jump = word & jumpAlways;
+		targetKnown = known; // the jump goes to A before the instruction
+
+		if (!known && ((word & compReadsM) || (dest & destM) || jump)) {
+			emit({ 0x89, 0xde });							// mov esi, ebx
+			emit({ 0x81, 0xe6 }); emit32(addressMask);		// and esi, 0x7fff
+		}
+
+		// the ALU as the chip: x = D in eax, y = A or M in ecx
+
+		if (control & 0x20)
+			emit({ 0x31, 0xc0 });							// xor eax, eax
+		else
+			emit({ 0x89, 0xe8 });							// mov eax, ebp
+
+		if (control & 0x10)
+			emit({ 0xf7, 0xd0 });							// not eax
+
+		if (control & 0x08)
+			emit({ 0x31, 0xc9 });							// xor ecx, ecx
+		else if (word & compReadsM)
+			emitLoadM(known, value);
+		else
+			emit({ 0x89, 0xd9 });							// mov ecx, ebx
+
+		if (control & 0x04)
+			emit({ 0xf7, 0xd1 });							// not ecx
+
+		if (control & 0x02)
+			emit({ 0x01, 0xc8 });							// add eax, ecx
+		else
+			emit({ 0x21, 0xc8 });							// and eax, ecx
+
+		if (control & 0x01)
+			emit({ 0xf7, 0xd0 });							// not eax
+
+		emit({ 0x0f, 0xb7, 0xc0 });							// movzx eax, ax
+
+		if (dest & destM)
+			emitStoreM(known, value);
+
+		if (dest & destD)
+			emit({ 0x89, 0xc5 });							// mov ebp, eax
+
+		if (dest & destA) {
+			emit({ 0x89, 0xc3 });							// mov ebx, eax
+			known = false;
+		}
+	}
+
+	// address is now the one after the block
+
+	if (jump == jumpAlways) {
+		if (targetKnown)
+			emitExit(value);
+		else
+			emitDispatch();
+	} else if (jump != 0) {
+		emit({ 0x66, 0x85, 0xc0 });							// test ax, ax
+		emit({ 0x0f, conditions[jump] }); emit32(0);		// jcc (taken below)
+		uint8_t* taken = code + used;
+
+		emitExit(address);
+		setTarget(taken, code + used);
+
+		if (targetKnown)
+			emitExit(value);
+		else
+			emitDispatch();
+	} else {
+		emitExit(address);
+	}
+
+	setTarget(cycleCheck, code + used);
+	emit({ 0xb8 }); emit32(start);							// mov eax, start
+	emit({ 0x31, 0xd2 });									// xor edx, edx
+	emitJump({ 0xe9 }, exit);
+
+	return entry;
+}
+
+uint16_t Jit::getEndLength(uint16_t address) const
+{
+	uint16_t word = rom[address];
+	uint16_t previous = (address - 1) & addressMask;
+
+	if (word & cInstruction)
+		return isEnd(rom[previous], previous, word) ? 1 : 0;
+
+	return isEnd(word, address, rom[(address + 1) & addressMask]) ? 2 : 0;
+}
+
+void Jit::writeRuntime()
+{
+	used = 0;
+
+	// entry (System V: rdi = context, rsi = code of the block)
+
+	emit({ 0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 });	// push rbx, rbp, r12 - r15
+	emit({ 0x49, 0x89, 0xff });												// mov r15, rdi
+	emit({ 0x41, 0x0f, 0xb7, 0x5f, uint8_t(offsetof(Context, a)) });		// movzx ebx, word [r15 + a]
+	emit({ 0x41, 0x0f, 0xb7, 0x6f, uint8_t(offsetof(Context, d)) });		// movzx ebp, word [r15 + d]
+	emit({ 0x4d, 0x8b, 0x67, uint8_t(offsetof(Context, ram)) });			// mov r12, [r15 + ram]
+	emit({ 0x4d, 0x8b, 0x6f, uint8_t(offsetof(Context, remaining)) });		// mov r13, [r15 + remaining]
+	emit({ 0x4d, 0x8b, 0x77, uint8_t(offsetof(Context, table)) });			// mov r14, [r15 + table]
+	emit({ 0xff, 0xe6 });													// jmp rsi
+
+	// exit (eax = program counter, rdx = exit stub to chain or 0)
+
+	exit = code + used;
+	emit({ 0x66, 0x41, 0x89, 0x5f, uint8_t(offsetof(Context, a)) });		// mov [r15 + a], bx
+	emit({ 0x66, 0x41, 0x89, 0x6f, uint8_t(offsetof(Context, d)) });		// mov [r15 + d], bp
+	emit({ 0x66, 0x41, 0x89, 0x47, uint8_t(offsetof(Context, pc)) });		// mov [r15 + pc], ax
+	emit({ 0x4d, 0x89, 0x6f, uint8_t(offsetof(Context, remaining)) });		// mov [r15 + remaining], r13
+	emit({ 0x48, 0x89, 0xd0 });											// mov rax, rdx
+	emit({ 0x41, 0x5f, 0x41, 0x5e, 0x41, 0x5d, 0x41, 0x5c, 0x5d, 0x5b });	// pop r15 - r12, rbp, rbx
+	emit({ 0xc3 });															// ret
+
+	// computed jump to an address not compiled (eax = the address)
+
+	miss = code + used;
+	emit({ 0x31, 0xd2 });													// xor edx, edx
+	emitJump({ 0xe9 }, exit);
+
+	runtimeSize = used;
+}
+
+void Jit::emitLoadM(bool known, uint16_t address)
+{
+	if (known) {
+		emit({ 0x41, 0x0f, 0xb7, 0x8c, 0x24 });			// movzx ecx, word [r12 + address * 2]
+		emit32((address & addressMask) * 2);
+	} else {
+		emit({ 0x41, 0x0f, 0xb7, 0x0c, 0x74 });			// movzx ecx, word [r12 + rsi * 2]
+	}
+}
+
+void Jit::emitStoreM(bool known, uint16_t address)
+{
+	if (known) {
+		emit({ 0x66, 0x41, 0x89, 0x84, 0x24 });			// mov [r12 + address * 2], ax
+		emit32((address & addressMask) * 2);
+	} else {
+		emit({ 0x66, 0x41, 0x89, 0x04, 0x74 });			// mov [r12 + rsi * 2], ax
+	}
+}
+
+void Jit::emitExit(uint16_t pc)
+{
+	// run() chains the stub by writing a jmp over its first 5 bytes
+
+	uint8_t* stub = code + used;
+	emit({ 0xb8 }); emit32(pc);								// mov eax, pc
+	emit({ 0x48, 0xba }); emit64(reinterpret_cast<uintptr_t>(stub));	// mov rdx, stub
+	emitJump({ 0xe9 }, exit);
+}
+
+void Jit::emitDispatch()
+{
+	emit({ 0x89, 0xf0 });									// mov eax, esi
+	emit({ 0x41, 0xff, 0x24, 0xc6 });						// jmp [r14 + rax * 8]
+}
+
+void Jit::emitJump(initializer_list<uint8_t> opcode, const uint8_t* target)
+{
+	emit(opcode);
+	emit32(0);
+	setTarget(code + used, target);
+}
+
+void Jit::emit(initializer_list<uint8_t> bytes)
+{
+	for (uint8_t byte: bytes)
+		code[used++] = byte;
+}
+
+void Jit::emit32(uint32_t value)
+{
+	memcpy(code + used, &value, 4);
+	used += 4;
+}
+
+void Jit::emit64(uint64_t value)
+{
+	memcpy(code + used, &value, 8);
+	used += 8;
+}
+
+void Jit::setTarget(uint8_t* jump, const uint8_t* target)
+{
+	int32_t displacement = int32_t(target - jump);
+	memcpy(jump - 4, &displacement, 4);
+}
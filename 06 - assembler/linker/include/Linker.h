@@ -0,0 +1,101 @@
+#ifndef LINKER_INCLUDED_H
+#define LINKER_INCLUDED_H
+
+#include "ObjectFile.h"
+#include "SymbolTable.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+/**
+	Links relocatable objects (see ObjectFile) into a ROM image. The modules are placed one after
+	the other, in the order they were added; the labels they export are mapped to their final
+	addresses, and the symbols no module exports are allocated as variables from RAM 16 upward,
+	in order of first use. The result is the same machine code the assembler makes from the
+	concatenation of the sources of the modules.
+*/
+class Linker
+{
+
+	public:
+
+		/**
+			Constructs a Linker object.
+
+			@param verbose True for verbose mode on (details printed to the standard output).
+		*/
+		Linker(bool verbose);
+
+		/**
+			Adds a module to the program.
+
+			@param object Object of the module (copied).
+
+			@param name Name of the module, used in messages.
+		*/
+		void add(const ObjectFile& object, string name);
+
+		/**
+			Links the modules added. Labels exported by more than one module and programs that do
+			not fit in the ROM are reported to the standard error output.
+
+			@return True if the modules were linked without errors. False otherwise.
+		*/
+		bool link();
+
+		/**
+			Returns the linked program.
+
+			@return A reference to the words of the ROM image.
+		*/
+		const vector<uint16_t>& getRom();
+
+		/**
+			Outputs the symbol table of the linked program (labels and variables), in the format
+			of the assembler.
+
+			@param symOutputStream Output stream.
+
+			@param outputName Name of the linked program.
+		*/
+		void outputSymbolTable(ostream& symOutputStream, string outputName);
+
+	private:
+
+		/**
+			A module added to the program.
+		*/
+		class Module {
+			public:
+				ObjectFile object;		/**< Object of the module. */
+				string name;			/**< Name of the module. */
+				uint32_t base;			/**< ROM address of the first word of the module. */
+		};
+
+		/**
+			Reports an error.
+
+			@param message Error message.
+		*/
+		void reportError(string message);
+
+		vector<Module> modules;			/**< Modules of the program, in ROM order. */
+
+		vector<uint16_t> rom;			/**< Linked program. */
+
+		SymbolTable symbolTable;		/**< Labels and variables of the linked program. */
+
+		bool verbose;					/**< Flag for the verbose mode. */
+
+		int errorCount;					/**< Number of errors found while linking. */
+
+		static const uint32_t romSize = 32768;	/**< Size of the Hack ROM, in words. */
+
+		static const int firstVariable = 16;	/**< RAM address of the first variable. */
+
+};
+
+#endif // LINKER_INCLUDED_H
@@ -0,0 +1,180 @@
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <unistd.h>
+#include "Linker.h"
+#include "ObjectFile.h"
+#include "FileHandler.h"
+#include "RomWriter.h"
+
+using namespace std;
+
+/**
+	Options of the linker, read from the command line arguments.
+*/
+class Flags
+{
+	public:
+		bool verbose = false;					/**< Verbose flag. */
+		bool symTable = false;					/**< Output symbol table flag. */
+		RomFormat romFormat = RomFormat::HACK;	/**< Output format. */
+		string outputName;						/**< Name of the output file (empty: named after the first input). */
+};
+
+/**
+	Gets the flags from the command line arguments.
+
+	@param argc Number of command line arguments.
+
+	@param argv Array of arguments.
+
+	@param flags Flags. Their values will be affected by the arguments.
+
+	@return Returns false if an unidentified flag is present in the arguments.
+	True otherwise.
+*/
+bool getFlags(int argc, char** argv, Flags& flags)
+{
+	int c;
+
+	while ((c = getopt(argc, argv, "vtf:o:")) != -1) {
+
+        switch (c) {
+
+            case 'v':
+                flags.verbose = true;
+                break;
+
+            case 't':
+                flags.symTable = true;
+                break;
+
+            case 'f':
+                if (string(optarg) == "hack") {
+                    flags.romFormat = RomFormat::HACK;
+                } else if (string(optarg) == "bin") {
+                    flags.romFormat = RomFormat::BINARY;
+                } else if (string(optarg) == "hbin") {
+                    flags.romFormat = RomFormat::BINARY_HEADER;
+                } else {
+                    cerr << "error: unknown output format \"" << optarg << "\"" << endl;
+                    return false;
+                }
+                break;
+
+            case 'o':
+                flags.outputName = optarg;
+                break;
+
+            case '?':
+                return false;
+
+        }
+    }
+
+	return true;
+}
+
+/**
+	Reads a relocatable object from a file.
+
+	@param inputName Name of the input file.
+
+	@param object Object receiving the contents of the file.
+
+	@return True if the file was read. False otherwise.
+*/
+bool readObject(string inputName, ObjectFile& object)
+{
+	if (!FileHandler::isFile(inputName)) {
+		cerr << "error: input \"" << inputName << "\" is not a file" << endl;
+		return false;
+	}
+
+	ifstream inputFile(inputName, ios::binary);
+
+	if (!inputFile.good()) {
+		cerr << "error: unable to open input file \"" << inputName << "\"" << endl;
+		return false;
+	}
+
+	if (!object.read(inputFile)) {
+		cerr << "error: \"" << inputName << "\" is not a valid object file (assemble it with hass -c)" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+	Links the relocatable objects (.hobj) made by "hass -c" into a .hack (or .bin, or .hbin) file.
+*/
+int main(int argc, char** argv)
+{
+	if (argc == 1) {
+		cerr << "usage: " << "hlink" << " [-v|-t] [-f hack|bin|hbin] [-o output] input.hobj..." << endl;
+		cerr << "       -v verbose" << endl;
+		cerr << "       -t output symbol table" << endl;
+		cerr << "       -f output format: hack (text, default), bin (raw little-endian words)" << endl;
+		cerr << "          or hbin (raw words with a header holding word count and checksum)" << endl;
+		cerr << "       -o output file (default: the first input, with the extension of the format)" << endl;
+		cerr << "       the modules are placed in ROM in the order they are given" << endl;
+		return 1;
+	}
+
+	Flags flags;
+
+	if (!getFlags(argc, argv, flags))
+		return 1;
+
+	if (optind >= argc) {
+		cerr << "error: no input files" << endl;
+		return 1;
+	}
+
+	Linker linker(flags.verbose);
+
+	for (int i = optind; i < argc; i++) {
+		ObjectFile object;
+
+		if (!readObject(argv[i], object))
+			return 1;
+
+		linker.add(object, argv[i]);
+	}
+
+	bool linked = linker.link();
+
+	string outputName(flags.outputName);
+
+	if (outputName.empty())
+		outputName = FileHandler::changeExtension(argv[optind], RomWriter::getExtension(flags.romFormat));
+
+	ofstream outputFile(outputName, ios::binary);
+
+	if (!outputFile.good()) {
+		cerr << "error: unable to open output file \"" << outputName << "\"" << endl;
+		return 1;
+	}
+
+	RomWriter::write(outputFile, linker.getRom(), flags.romFormat);
+	outputFile.close();
+
+	if (flags.symTable) {
+		string symOutputName(FileHandler::changeExtension(outputName, "-symbols"));
+		ofstream symOutputFile(symOutputName);
+
+		if (!symOutputFile.good()) {
+			cerr << "error: unable to open output stream" << endl;
+			return 1;
+		}
+
+		linker.outputSymbolTable(symOutputFile, outputName);
+
+		if (flags.verbose)
+			cout << "symbol table output: " << symOutputName << endl;
+	}
+
+	return linked ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#include "Linker.h"
+#include <iomanip>
+#include <unordered_map>
+
+Linker::Linker(bool verbose)
+	: verbose(verbose), errorCount(0)
+{}
+
+void Linker::add(const ObjectFile& object, string name)
+{
+	modules.push_back(Module { object, name, 0 });
+}
+
+bool Linker::link()
+{
+	// place the modules and map their labels
+
+	unordered_map<string, size_t> definedBy; // label -> module
+	uint32_t address = 0;
+
+	for (size_t i = 0; i < modules.size(); i++) {
+		Module& module = modules[i];
+		module.base = address;
+
+		for (auto& entry: module.object.exports) {
+			bool inserted;
+			symbolTable.findOrInsert(entry.name, module.base + entry.offset, inserted);
+
+			if (inserted)
+				definedBy[entry.name] = i;
+			else
+				reportError("label \"" + entry.name + "\" defined in " + modules[definedBy[entry.name]].name + " and " + module.name);
+		}
+
+		if (verbose)
+			cout << module.name << " mapped to address 0x" << setfill('0') << setw(4) << setbase(16) << module.base
+			     << setbase(10) << " (" << module.object.words.size() << " words)" << endl;
+
+		address += module.object.words.size();
+	}
+
+	if (address > romSize)
+		reportError("program does not fit in ROM (" + to_string(address) + " words)");
+
+	// relocate the code and resolve the symbols, allocating variables in order of first use
+
+	size_t labelCount = symbolTable.size();
+	int variableAddress = firstVariable;
+
+	rom.clear();
+	rom.reserve(address);
+
+	for (auto& module: modules) {
+		const ObjectFile& object = module.object;
+
+		rom.insert(rom.end(), object.words.begin(), object.words.end());
+
+		for (uint32_t relocation: object.relocations)
+			rom[module.base + relocation] += module.base;
+
+		for (auto& reference: object.references) {
+			bool inserted;
+			rom[module.base + reference.wordIndex] = symbolTable.findOrInsert(object.variables[reference.variableIndex],
+			                                                                  variableAddress, inserted);
+			if (inserted)
+				variableAddress++;
+		}
+	}
+
+	if (verbose)
+		cout << endl << labelCount << " labels, " << symbolTable.size() - labelCount << " variables, "
+		     << rom.size() << " words" << endl << endl;
+
+	return errorCount == 0;
+}
+
+const vector<uint16_t>& Linker::getRom()
+{
+	return rom;
+}
+
+void Linker::outputSymbolTable(ostream& symOutputStream, string outputName)
+{
+	symOutputStream << "**** " << outputName << " symbols:" << endl << endl;
+
+	for (auto entry: symbolTable.getSortedEntries(0, symbolTable.size()))
+		symOutputStream << "0x" << setfill('0') << setw(4) << setbase(16) << entry->address << " " << entry->symbol << endl;
+}
+
+void Linker::reportError(string message)
+{
+	cerr << "error: " << message << endl;
+	errorCount++;
+}
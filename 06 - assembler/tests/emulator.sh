@@ -0,0 +1,106 @@
+#!/bin/sh
+# Runs generated ROMs with the interpreter of hemu, its JIT (hemu -j), the JIT with the
+# smallest code buffer (hemu -j -c, emptied again and again) and the program hcpp translates
+# them to, and checks that all of them print the same registers, cycles and memory.
+#
+# The small ROMs mix A-instructions loading nearby addresses (and their own: the end of the
+# program), the frequent C-instructions of the VM code and any other C-instruction, and run
+# for a few cycles up to 5000; the large ones are too long for the code buffer of -c.
+#
+# usage: emulator.sh [directory of hemu and hcpp] [ROMs] [seed]
+#        (default: the PATH, 200 ROMs, seed 1; the C++ compiler is $CXX, or c++)
+
+bin=${1:+$1/}
+roms=${2:-200}
+seed=${3:-1}
+cxx=${CXX:-c++}
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+failures=0
+
+# generate <seed> <words>: writes a random ROM to $work/rom.hack
+
+generate() {
+	awk -v seed="$1" -v words="$2" 'BEGIN {
+		srand(seed);
+		split("64528 58120 64544 64968 64680 60432 57504 57488 60576 58114 58117 58113 58116 " \
+		      "58115 58118 61896 61904 61576 64664 60040 61064 65000 64648 60039", frequent, " ");
+
+		for (i = 0; i < words; i++) {
+			r = rand();
+
+			if (r < 0.45) {
+				pick = rand();
+				word = pick < 0.4 ? int(rand() * (words + 3)) : pick < 0.8 ? int(rand() * 71) : i;
+			} else if (r < 0.5) {
+				word = 60039; # 0;JMP
+			} else if (r < 0.85) {
+				word = frequent[1 + int(rand() * 24)];
+			} else {
+				word = 57344 + int(rand() * 8192);
+			}
+
+			line = "";
+
+			for (bit = 32768; bit >= 1; bit /= 2) {
+				line = line (word >= bit ? "1" : "0");
+				word %= bit;
+			}
+
+			print line;
+		}
+	}' > "$work/rom.hack"
+}
+
+# check <name> <hcpp> <options>...: runs the ROM every way and compares the outputs
+
+check() {
+	name=$1
+	translate=$2
+	shift 2
+
+	"${bin}hemu" "$@" "$work/rom.hack" > "$work/interpreter"
+	"${bin}hemu" -j "$@" "$work/rom.hack" > "$work/jit"
+	"${bin}hemu" -j -c 65536 "$@" "$work/rom.hack" > "$work/flushes"
+
+	for output in jit flushes; do
+		if ! cmp -s "$work/interpreter" "$work/$output"; then
+			echo "FAIL: $name $* ($output)"
+			failures=$((failures + 1))
+		fi
+	done
+
+	if [ "$translate" = yes ]; then
+		"$work/translated" "$@" > "$work/translated.out"
+
+		if ! cmp -s "$work/interpreter" "$work/translated.out"; then
+			echo "FAIL: $name $* (hcpp)"
+			failures=$((failures + 1))
+		fi
+	fi
+}
+
+options="-p 0:80 -s 0=5 -s 1=65535 -s 2=32768"
+i=0
+
+while [ "$i" -lt "$roms" ]; do
+	words=$(awk -v seed="$seed$i" 'BEGIN { srand(seed); print 2 + int(rand() * 39) }')
+	generate "$seed$i" "$words"
+
+	"${bin}hcpp" -o "$work/translated.cpp" "$work/rom.hack" &&
+	"$cxx" -O1 -o "$work/translated" "$work/translated.cpp" || { echo "error: ROM $i not translated"; exit 1; }
+
+	for cycles in 1 2 3 7 100 5000; do
+		check "ROM $i" yes -n "$cycles" $options
+	done
+
+	i=$((i + 1))
+done
+
+for words in 8000 20000 32768; do
+	generate "$seed$words" "$words"
+	check "ROM of $words words" no -n 1000000 $options
+done
+
+echo "$failures failures"
+[ "$failures" -eq 0 ]
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Runs the programs of optimizer/ assembled with hass -O, -e and -O -e, and checks that the
+# memory they leave (hemu -p) is the same as when assembled without optimizing, and that they
+# take the number of words given in their comments ("// -O: 12 words"), so that a pass that
+# stops removing what it should, or removes what it should not, is noticed too.
+#
+# usage: optimizer.sh [directory of hass and hemu] (default: the PATH)
+
+bin=${1:+$1/}
+dir=$(dirname "$0")/optimizer
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+failures=0
+
+run() {
+	"${bin}hass" $1 - < "$2" > "$work/program.hack" &&
+	"${bin}hemu" -n 1000000 -p 0:1024 "$work/program.hack" | grep '^RAM'
+}
+
+for program in "$dir"/*.asm; do
+	run "" "$program" > "$work/expected" || { echo "error: $program: not assembled"; exit 1; }
+
+	for options in -O -e "-O -e"; do
+		run "$options" "$program" > "$work/actual"
+
+		if ! cmp -s "$work/expected" "$work/actual"; then
+			echo "FAIL: $program ($options)"
+			failures=$((failures + 1))
+		fi
+
+		words=$(wc -l < "$work/program.hack")
+		expected=$(sed -n "s|^// $options: \([0-9]*\) words\$|\1|p" "$program")
+
+		if [ -n "$expected" ] && [ "$words" -ne "$expected" ]; then
+			echo "FAIL: $program ($options: $words words, $expected expected)"
+			failures=$((failures + 1))
+		fi
+	done
+done
+
+echo "$failures failures"
+[ "$failures" -eq 0 ]
@@ -0,0 +1,19 @@
+// Jumps to a constant ROM address (@7 is the M=D after @x): removing the
+// second "@1 D=A" would make the jump land on "0;JMP" and skip the store, so
+// the program is left as it is.
+//
+// -O: 10 words
+// -e: 10 words
+// -O -e: 10 words
+
+@1
+D=A
+@1
+D=A
+@7
+0;JMP
+@x
+M=D
+(END)
+@END
+0;JMP
@@ -0,0 +1,29 @@
+// Writes overwritten before being read: the first "@7 D=A", the "@5" before
+// "@6", and the "D=0" left dead once "M=D" becomes a constant store (M=0),
+// as D is loaded again after it.
+//
+// -O: 16 words
+// -e: 20 words
+// -O -e: 16 words
+
+@7
+D=A
+@8
+D=A
+@r
+M=D
+@5
+@6
+D=A
+@s
+M=D
+D=0
+@z
+M=D
+@9
+D=A
+@o
+M=D
+(END)
+@END
+0;JMP
@@ -0,0 +1,28 @@
+// The pop after a push (M=M+1, AM=M-1) becomes A=M, and an increment undone
+// by a decrement (M=M+1, M=M-1) disappears.
+//
+// -O: 17 words
+// -e: 20 words
+// -O -e: 17 words
+
+@256
+D=A
+@SP
+M=D
+@42
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+AM=M-1
+D=M
+@r
+M=D
+@c
+M=M+1
+M=M-1
+(END)
+@END
+0;JMP
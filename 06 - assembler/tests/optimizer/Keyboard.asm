@@ -0,0 +1,28 @@
+// The keyboard may change at any time, so the second read of KBD stays; the
+// same reload of x, whose word D still holds, is removed.
+//
+// -O: 17 words
+// -e: 18 words
+// -O -e: 17 words
+
+@KBD
+D=M
+@KEYBOARD
+D;JEQ
+@KBD
+D=M
+(KEYBOARD)
+@k
+M=D
+@x
+D=M
+@VARIABLE
+D;JEQ
+@x
+D=M
+(VARIABLE)
+@y
+M=D
+(END)
+@END
+0;JMP
@@ -0,0 +1,36 @@
+// Redundant loads: "@n D=M" after "@n M=D" loads what A and D already hold, and
+// the second "@x" too, but the same loads after (LOOP) must stay, since the
+// jump back to LOOP comes with other values in A and D. Sums 3+2+1 into sum.
+//
+// -O: 24 words
+// -e: 26 words
+// -O -e: 24 words
+
+@3
+D=A
+@n
+M=D
+@x
+M=D
+@x
+D=M
+@n
+D=M
+@sum
+M=0
+@n
+M=D
+(LOOP)
+@n
+D=M
+@END
+D;JEQ
+@sum
+M=D+M
+@n
+M=M-1
+@LOOP
+0;JMP
+(END)
+@END
+0;JMP
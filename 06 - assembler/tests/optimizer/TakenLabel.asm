@@ -0,0 +1,32 @@
+// RET is only reached through the computed jump of the return from FUNC, and
+// its address is taken ("@RET D=A"), so -e keeps it; UNUSED is never called
+// and goes away with its code.
+//
+// -O: 20 words
+// -e: 15 words
+// -O -e: 15 words
+
+@RET
+D=A
+@ret
+M=D
+@FUNC
+0;JMP
+(RET)
+@r
+M=1
+(END)
+@END
+0;JMP
+(FUNC)
+@f
+M=1
+@ret
+A=M
+0;JMP
+(UNUSED)
+@u
+M=1
+@ret
+A=M
+0;JMP
@@ -0,0 +1,118 @@
+#ifndef TRANSLATOR_INCLUDED_H
+#define TRANSLATOR_INCLUDED_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+	Translates Hack machine code to a C++ program that runs it natively, with the options and
+	the output of the emulator (hemu): the same registers, memory and cycle counts, so that
+	both can be compared.
+
+	The ROM becomes one function running the instructions in sequence, with a label at the
+	addresses jumps are expected to land on (entries): the start, the targets of the jumps
+	whose address an A-instruction has just loaded ("@LOOP D;JGT"), the addresses after the
+	jumps and the addresses loaded as data ("@RETURN D=A", the return addresses of the VM).
+	A jump to a known address is a goto to its label, and so is its access to M a constant
+	address; other jumps (A=M 0;JMP, the return of the VM) go through a switch on the
+	address.
+
+	The translated program also holds the ROM and a small interpreter, which runs the jumps
+	that land elsewhere until one lands on an entry, the words past the program (zero, as in
+	the Emulator) and the last cycles when fewer are left than the longest run of
+	instructions without a jump, so that runs stop at the exact cycle. The memory is an
+	array of 32K words, as in the Emulator, and programs halt on the same idiom
+	("(END) \@END 0;JMP").
+
+	Keeping the labels to the entries keeps the function a few large basic blocks, which the
+	C++ compiler optimizes in about linear time.
+*/
+class Translator
+{
+
+	public:
+
+		static const size_t romSize = 32768;		/**< Words of the ROM. */
+
+		/**
+			Constructs a Translator object.
+		*/
+		Translator();
+
+		/**
+			Translates a program.
+
+			@param rom Machine code (@ref romSize words at most).
+
+			@param name Name of the program, for the comment heading the output.
+
+			@param output Receives the C++ program (appended).
+
+			@return True if the program was translated. False if it does not fit in the ROM.
+		*/
+		bool translate(const vector<uint16_t>& rom, const string& name, string& output);
+
+		/**
+			Returns the number of entries (labels) of the last translation.
+		*/
+		size_t getEntryCount() const;
+
+		/**
+			Returns the number of jumps to a known address (gotos) of the last translation.
+		*/
+		size_t getStaticJumpCount() const;
+
+		/**
+			Returns the number of jumps through the switch of the last translation.
+		*/
+		size_t getComputedJumpCount() const;
+
+	private:
+
+		/**
+			Finds the entries of the program.
+		*/
+		void findEntries();
+
+		/**
+			Translates the C-instruction at an address.
+
+			@param address Address of the instruction.
+
+			@param output Receives the statements (appended).
+		*/
+		void translateC(uint16_t address, string& output);
+
+		/**
+			Returns the statement jumping to an address: a goto if it is an entry, the
+			interpreter otherwise.
+		*/
+		string jumpTo(uint16_t address) const;
+
+		/**
+			Is the word at an address a C-instruction after an A-instruction? A is then known
+			when it runs in sequence.
+		*/
+		bool isKnownA(uint16_t address) const;
+
+		/**
+			Returns the word of the ROM at an address (0 past the program).
+		*/
+		uint16_t wordAt(uint16_t address) const;
+
+		const vector<uint16_t>* program;	/**< Program being translated. */
+
+		vector<bool> entries;				/**< Is every address of the program an entry? */
+
+		size_t entryCount;					/**< Entries. */
+
+		size_t staticJumps;					/**< Jumps to a known address. */
+
+		size_t computedJumps;				/**< Jumps through the switch. */
+
+};
+
+#endif // TRANSLATOR_INCLUDED_H
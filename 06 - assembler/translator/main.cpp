@@ -0,0 +1,151 @@
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <unistd.h>
+#include "FileHandler.h"
+#include "MappedFile.h"
+#include "RomReader.h"
+#include "Translator.h"
+
+using namespace std;
+
+/**
+	Options of the translator, read from the command line arguments.
+*/
+class Flags
+{
+	public:
+		bool verbose = false;					/**< Verbose flag. */
+		string outputName;						/**< Name of the output file (empty: named after the input). */
+};
+
+/**
+	Gets the flags from the command line arguments.
+
+	@param argc Number of command line arguments.
+
+	@param argv Array of arguments.
+
+	@param flags Flags. Their values will be affected by the arguments.
+
+	@return Returns false if an unidentified flag is present in the arguments.
+	True otherwise.
+*/
+bool getFlags(int argc, char** argv, Flags& flags)
+{
+	int c;
+
+	while ((c = getopt(argc, argv, "vo:")) != -1) {
+
+        switch (c) {
+
+            case 'v':
+                flags.verbose = true;
+                break;
+
+            case 'o':
+                flags.outputName = optarg;
+                break;
+
+            case '?':
+                return false;
+
+        }
+    }
+
+	return true;
+}
+
+/**
+	Reads a ROM image: a .hack file, a .bin file written by "hass -f bin" or a .hbin file
+	written by "hass -f hbin".
+
+	@param inputName Name of the input file.
+
+	@param rom Receives the machine code.
+
+	@return True if the file was read. False otherwise.
+*/
+bool readRom(string inputName, vector<uint16_t>& rom)
+{
+	if (!FileHandler::isFile(inputName)) {
+		cerr << "error: input \"" << inputName << "\" is not a file" << endl;
+		return false;
+	}
+
+	MappedFile inputFile;
+
+	if (!inputFile.openRead(inputName)) {
+		cerr << "error: unable to open input file \"" << inputName << "\"" << endl;
+		return false;
+	}
+
+	string message;
+
+	if (!RomReader::read(inputFile.view(), RomReader::getFormat(inputName), rom, message)) {
+		cerr << "error: \"" << inputName << "\": " << message << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+	Translates a Hack program into a C++ program that runs it at native speed, with the
+	options and the output of hemu.
+*/
+int main(int argc, char** argv)
+{
+	if (argc == 1) {
+		cerr << "usage: " << "hcpp" << " [-v] [-o output.cpp] input" << endl;
+		cerr << "       -v verbose" << endl;
+		cerr << "       -o output file (default: the input with the .cpp extension)" << endl;
+		cerr << "       input is a .hack file, a .bin file (hass -f bin) or a .hbin file (hass -f hbin)" << endl;
+		cerr << "       the output compiles alone (g++ -O2 output.cpp) into a program taking the" << endl;
+		cerr << "       -n, -s, -p and -t options of hemu and printing the same results" << endl;
+		return 1;
+	}
+
+	Flags flags;
+
+	if (!getFlags(argc, argv, flags))
+		return 1;
+
+	if (optind != argc - 1) {
+		cerr << "error: expected one input file" << endl;
+		return 1;
+	}
+
+	string inputName(argv[optind]);
+	string outputName(flags.outputName.empty() ? FileHandler::changeExtension(inputName, ".cpp") : flags.outputName);
+	vector<uint16_t> rom;
+
+	if (!readRom(inputName, rom))
+		return 1;
+
+	Translator translator;
+	string output;
+
+	if (!translator.translate(rom, inputName, output)) {
+		cerr << "error: program too large (" << rom.size() << " words, the ROM holds " << Translator::romSize << ")" << endl;
+		return 1;
+	}
+
+	ofstream outputFile(outputName, ios::binary);
+
+	if (!outputFile.good()) {
+		cerr << "error: unable to open output file \"" << outputName << "\"" << endl;
+		return 1;
+	}
+
+	outputFile << output;
+
+	if (flags.verbose) {
+		cout << inputName << ": " << rom.size() << " words, " << translator.getEntryCount() << " entries, "
+		     << translator.getStaticJumpCount() << " static jumps, " << translator.getComputedJumpCount() << " computed jumps" << endl;
+		cout << outputName << ": " << output.size() << " bytes" << endl;
+	}
+
+	return 0;
+}
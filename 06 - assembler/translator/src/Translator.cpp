@@ -0,0 +1,422 @@
+#include "Translator.h"
+#include "Cpu.h"
+#include <algorithm>
+
+using namespace Cpu;
+
+namespace {
+
+	/**
+		Start of the translated program, before the ROM.
+	*/
+	const char* const header = R"code(
+#include <chrono>
+#include <cinttypes>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+static uint16_t ram[32768];
+
+static bool halted = false;
+)code";
+
+	/**
+		Interpreter of the translated program, and start of the function running the ROM.
+	*/
+	const char* const runtime = R"code(
+// runs the program one instruction at a time, until a jump lands on an entry with longestRun
+// cycles left (true), or until the program halts or the cycles run out (false)
+static bool interpret(uint16_t& A, uint16_t& D, uint16_t& pc, uint64_t& cycle, uint64_t maxCycles)
+{
+	while (cycle < maxCycles) {
+		uint16_t word = pc < romSize ? rom[pc] : 0;
+		uint16_t next = (pc + 1) & 0x7fff;
+		uint16_t previous = (pc - 1) & 0x7fff;
+		uint16_t address = A & 0x7fff;
+		cycle++;
+
+		if (!(word & 0x8000)) {
+			A = word;
+			pc = next;
+			continue;
+		}
+
+		if (address == previous && previous < romSize && Cpu::isEnd(rom[previous], previous, word)) {
+			halted = true;
+			pc = previous;
+			return false;
+		}
+
+		uint16_t out = Cpu::alu(D, word & 0x1000 ? ram[address] : A, word >> 6 & 0x3f);
+
+		if (word & 0x08)
+			ram[address] = out;
+
+		if (word & 0x20)
+			A = out;
+
+		if (word & 0x10)
+			D = out;
+
+		unsigned int condition = out == 0 ? 2 : out & 0x8000 ? 4 : 1;
+		pc = word & condition ? address : next;
+
+		if ((word & 7) && pc < romSize && entries[pc] && maxCycles - cycle >= longestRun)
+			return true;
+	}
+
+	return false;
+}
+
+// goes on at an entry, unless fewer cycles are left than the longest run without a jump
+#define CHECK(address) pc = address; if (maxCycles - cycle < longestRun) goto slow;
+#define JUMP(address) { CHECK(address) goto L##address; }
+
+#pragma GCC diagnostic ignored "-Wunused-label"
+
+static uint64_t run(uint16_t& a, uint16_t& d, uint16_t& pc, uint64_t maxCycles)
+{
+	uint16_t A = a, D = d, m = 0, out = 0;
+	uint64_t cycle = 0;
+
+	(void) m;
+	(void) out;
+
+	goto dispatch;
+
+)code";
+
+	/**
+		End of the translated program: the options and the output of hemu.
+	*/
+	const char* const footer = R"code(
+static bool parseNumber(const string& text, long long min, long long max, long long& value)
+{
+	char* end;
+	value = strtoll(text.c_str(), &end, 0);
+
+	return !text.empty() && *end == '\0' && value >= min && value <= max;
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t maxCycles = 1000000000;
+	vector<pair<uint16_t, unsigned int>> ranges;
+	bool timing = false;
+	long long number, value;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:s:p:t")) != -1) {
+		string arg(optarg != nullptr ? optarg : "");
+		size_t separator = arg.find(c == 's' ? '=' : ':');
+
+		if (c == 'n' && parseNumber(arg, 1, LLONG_MAX, number)) {
+			maxCycles = number;
+		} else if (c == 's' && separator != string::npos && parseNumber(arg.substr(0, separator), 0, 0x7fff, number)
+		           && parseNumber(arg.substr(separator + 1), -32768, 65535, value)) {
+			ram[number] = uint16_t(value);
+		} else if (c == 'p' && parseNumber(arg.substr(0, separator), 0, 0x7fff, number)
+		           && (separator == string::npos || parseNumber(arg.substr(separator + 1), 1, 0x8000 - number, value))) {
+			ranges.push_back(make_pair(uint16_t(number), separator != string::npos ? unsigned(value) : 1));
+		} else if (c == 't') {
+			timing = true;
+		} else {
+			fprintf(stderr, "usage: %s [-n cycles] [-s address=value]... [-p address[:count]]... [-t]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	uint16_t a = 0, d = 0, pc = 0;
+
+	auto start = chrono::steady_clock::now();
+	uint64_t cycles = run(a, d, pc, maxCycles);
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	printf("cycles: %" PRIu64 " %s\n", cycles, halted ? "(halted)" : "(limit reached)");
+	printf("A: %d\nD: %d\nPC: %u\n", int16_t(a), int16_t(d), unsigned(pc));
+
+	for (auto& range: ranges)
+		for (unsigned int i = 0; i < range.second; i++)
+			printf("RAM[%u]: %d\n", range.first + i, int16_t(ram[range.first + i]));
+
+	if (timing)
+		printf("time: %.3f s (%.1f MIPS)\n", elapsed.count(), cycles / elapsed.count() / 1e6);
+
+	return 0;
+}
+)code";
+
+	/**
+		Computations of the assembly language, by their ALU control bits (zx nx zy ny f no),
+		with Y for the y input (A or M).
+	*/
+	const struct { unsigned int control; const char* expression; } computations[] = {
+		{ 0x2a, "0" },			{ 0x3f, "1" },			{ 0x3a, "0xffff" },		{ 0x0c, "D" },
+		{ 0x30, "Y" },			{ 0x0d, "~D" },			{ 0x31, "~Y" },			{ 0x0f, "-D" },
+		{ 0x33, "-Y" },			{ 0x1f, "D + 1" },		{ 0x37, "Y + 1" },		{ 0x0e, "D - 1" },
+		{ 0x32, "Y - 1" },		{ 0x02, "D + Y" },		{ 0x13, "D - Y" },		{ 0x07, "Y - D" },
+		{ 0x00, "D & Y" },		{ 0x15, "D | Y" }
+	};
+
+	/**
+		Conditions of the jump bits, on out.
+	*/
+	const char* const conditions[] = {
+		"", "int16_t(out) > 0", "out == 0", "int16_t(out) >= 0", "int16_t(out) < 0", "out != 0", "int16_t(out) <= 0"
+	};
+
+	/**
+		Returns the C++ expression of the ALU for a C-instruction.
+	*/
+	string expressionOf(uint16_t word, const string& y)
+	{
+		unsigned int control = word >> 6 & 0x3f;
+
+		for (auto& computation: computations) {
+			if (computation.control == control) {
+				string expression;
+
+				for (const char* c = computation.expression; *c != '\0'; c++) {
+					if (*c == 'Y')
+						expression += y;
+					else
+						expression += *c;
+				}
+
+				return expression;
+			}
+		}
+
+		return "Cpu::alu(D, " + y + ", " + to_string(control) + ")";
+	}
+
+	string label(uint16_t address)
+	{
+		return "L" + to_string(address);
+	}
+
+}
+
+Translator::Translator()
+	: program(nullptr), entryCount(0), staticJumps(0), computedJumps(0)
+{
+}
+
+bool Translator::translate(const vector<uint16_t>& rom, const string& name, string& output)
+{
+	if (rom.size() > romSize)
+		return false;
+
+	program = &rom;
+	staticJumps = 0;
+	computedJumps = 0;
+	findEntries();
+
+	// the longest run of instructions without a jump, from any address (the end of the
+	// program goes to the interpreter)
+
+	vector<uint16_t> runs(rom.size() + 1, 0);
+	uint16_t longestRun = 1;
+
+	for (size_t i = rom.size(); i-- > 0; ) {
+		bool jump = (rom[i] & cInstruction) && (rom[i] & jumpAlways);
+		runs[i] = jump ? 1 : runs[i + 1] + 1;
+		longestRun = max(longestRun, runs[i]);
+	}
+
+	output += "// " + name + " translated by hcpp (" + to_string(rom.size()) + " words)\n";
+	output += header;
+	output += "\n// the ALU and the end of a program, as in the Emulator\n";
+	output += Cpu::source;
+	output += "\n";
+	output += "\nstatic const uint16_t romSize = " + to_string(rom.size()) + ";\n";
+	output += "\nstatic const uint64_t longestRun = " + to_string(longestRun) + ";\n";
+	output += "\nstatic const uint16_t rom[romSize + 1] = {";
+
+	for (size_t i = 0; i < rom.size(); i++)
+		output += string(i % 16 == 0 ? "\n\t" : " ") + to_string(rom[i]) + ",";
+
+	output += "\n};\n\nstatic const bool entries[romSize + 1] = {";
+
+	for (size_t i = 0; i < rom.size(); i++)
+		output += string(i % 32 == 0 ? "\n\t" : " ") + (entries[i] ? "1," : "0,");
+
+	output += "\n};\n";
+	output += runtime;
+
+	string dispatch;
+
+	for (size_t i = 0; i < rom.size(); i++) {
+		uint16_t address = i;
+		uint16_t word = rom[address];
+
+		if (entries[address]) {
+			output += label(address) + ":\n";
+			dispatch += "\t\tcase " + to_string(address) + ": goto " + label(address) + ";\n";
+		}
+
+		output += "\tcycle++;\n";
+
+		if (!(word & cInstruction)) {
+			output += "\tA = " + to_string(word) + ";\n";
+			continue;
+		}
+
+		translateC(address, output);
+
+		// a jump not taken goes on at the entry after it
+
+		if ((word & jumpAlways) != 0 && (word & jumpAlways) != jumpAlways && i + 1 < rom.size())
+			output += "\tCHECK(" + to_string(address + 1) + ")\n";
+	}
+
+	if (rom.size() < romSize)
+		output += "\tpc = " + to_string(rom.size()) + ";\n\tgoto slow;\n\n";
+	else
+		output += "\tJUMP(0)\n\n";
+
+	output += "dispatch:\n\tif (maxCycles - cycle < longestRun)\n\t\tgoto slow;\n\n";
+	output += "\tswitch (pc) {\n" + dispatch + "\t}\n\n";
+	output += "slow:\n\tif (interpret(A, D, pc, cycle, maxCycles))\n\t\tgoto dispatch;\n\n";
+	output += "stop:\n\ta = A;\n\td = D;\n\n\treturn cycle;\n}\n";
+	output += footer;
+
+	return true;
+}
+
+size_t Translator::getEntryCount() const
+{
+	return entryCount;
+}
+
+size_t Translator::getStaticJumpCount() const
+{
+	return staticJumps;
+}
+
+size_t Translator::getComputedJumpCount() const
+{
+	return computedJumps;
+}
+
+void Translator::findEntries()
+{
+	const vector<uint16_t>& rom = *program;
+
+	entries.assign(rom.size(), false);
+
+	if (!rom.empty())
+		entries[0] = true;
+
+	for (size_t i = 0; i < rom.size(); i++) {
+		uint16_t word = rom[i];
+
+		if (word & cInstruction) {
+			if (!(word & jumpAlways))
+				continue;
+
+			if (i + 1 < rom.size())
+				entries[i + 1] = true;
+
+			if (isKnownA(i) && rom[i - 1] < rom.size() && !isKnownA(rom[i - 1]))
+				entries[rom[i - 1]] = true;
+		} else if (word < rom.size() && !isKnownA(word)) {
+			// an address loaded as data, without zeroing it or jumping ("@RETURN D=A")
+
+			uint16_t next = wordAt(i + 1);
+
+			if ((next & cInstruction) && !(next & (compReadsM | compZeroY | jumpAlways)))
+				entries[word] = true;
+		}
+	}
+
+	entryCount = count(entries.begin(), entries.end(), true);
+}
+
+void Translator::translateC(uint16_t address, string& output)
+{
+	uint16_t word = wordAt(address);
+	uint16_t previous = (address - 1) & addressMask;
+	uint16_t dest = word & (destA | destD | destM);
+	uint16_t jump = word & jumpAlways;
+	bool known = isKnownA(address);
+	uint16_t value = wordAt(previous); // A, if known
+
+	// M is read and written at the address A had before the instruction, and the jump goes there too
+
+	string m = known ? "ram[" + to_string(value) + "]" : "ram[m]";
+
+	if (!known && ((word & compReadsM) || (dest & destM) || jump))
+		output += "\tm = A & 0x7fff;\n";
+
+	if (isEnd(value, previous, word)) { // "@X 0;JMP" at X: the end of the program
+		string x = to_string(previous);
+
+		if (known) {
+			output += "\thalted = true;\n\tpc = " + x + ";\n\tgoto stop;\n";
+		} else {
+			output += "\tif (m == " + x + ") {\n\t\thalted = true;\n\t\tpc = " + x + ";\n\t\tgoto stop;\n\t}\n";
+			output += "\tpc = m;\n\tgoto dispatch;\n";
+			computedJumps++;
+		}
+
+		return;
+	}
+
+	if (dest != 0 || (jump != 0 && jump != jumpAlways))
+		output += "\tout = uint16_t(" + expressionOf(word, (word & compReadsM) ? m : "A") + ");\n";
+
+	if (dest & destM)
+		output += "\t" + m + " = out;\n";
+
+	if (dest & destD)
+		output += "\tD = out;\n";
+
+	if (dest & destA)
+		output += "\tA = out;\n";
+
+	if (jump == 0)
+		return;
+
+	string target;
+
+	if (known) {
+		target = jumpTo(value);
+		staticJumps++;
+	} else {
+		target = "{ pc = m; goto dispatch; }";
+		computedJumps++;
+	}
+
+	if (jump == jumpAlways)
+		output += "\t" + target + "\n";
+	else
+		output += "\tif (" + string(conditions[jump]) + ") " + target + "\n";
+}
+
+string Translator::jumpTo(uint16_t address) const
+{
+	if (address < program->size() && entries[address])
+		return "JUMP(" + to_string(address) + ")";
+
+	return "{ pc = " + to_string(address) + "; goto slow; }";
+}
+
+bool Translator::isKnownA(uint16_t address) const
+{
+	return address > 0 && address < program->size() && (wordAt(address) & cInstruction) && !(wordAt(address - 1) & cInstruction);
+}
+
+uint16_t Translator::wordAt(uint16_t address) const
+{
+	address &= addressMask;
+
+	return address < program->size() ? (*program)[address] : 0;
+}